@@ -0,0 +1,349 @@
+'''
+Converts a Standard MIDI File into a score for Song_compiler.py.
+
+Usage: python3 Midi_importer.py song.mid [-o songs/song.score]
+           [--title TITLE] [--track N] [--transpose SEMITONES]
+
+The melody comes from one track: the one given with --track, otherwise
+the busiest of the higher ones (drums, on channel 10, never count). Where
+it has several notes at once, the highest one is the melody. The notes
+of all the other tracks (and the lower ones of the melody track) become
+the harmony: whenever they change under a melody note, the chord is
+reduced to its bass note, or to three notes (the bass and the two lowest
+other pitch classes above it) in the third octave, which the buzzer
+cycles with the melody as a fast arpeggio until the next chord or break
+(music.c).
+
+The buzzer only plays what pitches.h has (B0 to B5): the whole song is
+moved by octaves until the melody fits, and any note still out of range
+is folded an octave at a time. The lengths are rounded to 10 ms, at most
+16 different ones in a song, and a song is split into parts of at most
+255 notes (music.h).
+
+The score goes to songs/<file name>.score unless -o says otherwise; run
+Song_compiler.py after to put it into songs.c.
+'''
+
+import argparse
+import os
+import re
+import struct
+import sys
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+NAMES = ['C', 'CS', 'D', 'DS', 'E', 'F', 'FS', 'G', 'GS', 'A', 'AS', 'B']
+LOWEST = 23 # B0, as a MIDI note number.
+HIGHEST = 83 # B5.
+CHORD_OCTAVE = 48 # C3: the arpeggios start from the third octave.
+LENGTHS = 16 # Different lengths in a song.
+PART = 255 # Notes in a part.
+DRUMS = 9 # Channel 10.
+GAP = 0.05 # s: a shorter gap between melody notes is no break.
+
+
+class MidiError(Exception):
+    pass
+
+
+def name(note):
+    return '%s%d' % (NAMES[note % 12], note // 12 - 1)
+
+
+def variable(data, i):
+    '''Reads a variable-length quantity: the value and where it ends.'''
+    value = 0
+    while True:
+        if i >= len(data):
+            raise MidiError('truncated file')
+        byte = data[i]
+        i += 1
+        value = value << 7 | byte & 0x7F
+        if not byte & 0x80:
+            return value, i
+
+
+def read_track(data):
+    '''The events of a track: (tick, kind, channel, a, b) and the name.'''
+    events = []
+    track_name = None
+    tick = 0
+    status = 0
+    i = 0
+
+    while i < len(data):
+        delta, i = variable(data, i)
+        tick += delta
+
+        if data[i] & 0x80:
+            status = data[i]
+            i += 1
+        elif status == 0:
+            raise MidiError('running status without a status')
+
+        if status == 0xFF: # Meta event.
+            kind = data[i]
+            length, i = variable(data, i + 1)
+            body = data[i:i + length]
+            i += length
+            status = 0
+            if kind == 0x51 and length == 3: # Tempo, in us per quarter note.
+                events.append((tick, 'tempo', 0, body[0] << 16 | body[1] << 8 | body[2], 0))
+            elif kind == 0x03 and track_name is None:
+                track_name = body.decode('latin-1')
+            elif kind == 0x2F:
+                break
+        elif status in (0xF0, 0xF7): # System exclusive.
+            length, i = variable(data, i)
+            i += length
+            status = 0
+        else:
+            kind = status & 0xF0
+            channel = status & 0x0F
+            if kind in (0xC0, 0xD0): # One data byte.
+                i += 1
+                continue
+            a, b = data[i], data[i + 1]
+            i += 2
+            if kind == 0x90 and b > 0:
+                events.append((tick, 'on', channel, a, b))
+            elif kind == 0x80 or kind == 0x90:
+                events.append((tick, 'off', channel, a, 0))
+
+    return events, track_name
+
+
+def read_midi(path):
+    '''The notes of each track as (start s, end s, note), and the track names.'''
+    with open(path, 'rb') as f:
+        data = f.read()
+
+    if data[:4] != b'MThd':
+        raise MidiError('%s: not a Standard MIDI File' % path)
+
+    length, form, count, division = struct.unpack('>IHHH', data[4:14])
+    if division & 0x8000:
+        raise MidiError('%s: SMPTE time is not supported' % path)
+
+    tracks = []
+    i = 8 + length
+    while i + 8 <= len(data) and len(tracks) < count:
+        kind, length = struct.unpack('>4sI', data[i:i + 8])
+        if kind == b'MTrk':
+            tracks.append(read_track(data[i + 8:i + 8 + length]))
+        i += 8 + length
+
+    # One tempo map for all the tracks (format 1 keeps it in the first).
+    tempos = sorted((tick, value) for events, _ in tracks for tick, kind, _, value, _ in events if kind == 'tempo')
+
+    def seconds(tick):
+        time, last, tempo = 0.0, 0, 500000
+        for at, value in tempos:
+            if at >= tick:
+                break
+            time += (at - last) * tempo / division / 1e6
+            last, tempo = at, value
+        return time + (tick - last) * tempo / division / 1e6
+
+    result = []
+    for events, track_name in tracks:
+        notes = []
+        sounding = {}
+        for tick, kind, channel, a, _ in events:
+            if kind == 'tempo' or channel == DRUMS:
+                continue
+            key = (channel, a)
+            if key in sounding:
+                start = sounding.pop(key)
+                if tick > start:
+                    notes.append((seconds(start), seconds(tick), a))
+            if kind == 'on':
+                sounding[key] = tick
+        notes.sort()
+        result.append((notes, track_name))
+
+    return result
+
+
+def pick_melody(tracks):
+    '''The busiest of the tracks whose notes are mostly above the middle.'''
+    candidates = [(i, notes) for i, (notes, _) in enumerate(tracks) if notes]
+    if not candidates:
+        raise MidiError('no notes')
+
+    busiest = max(len(notes) for _, notes in candidates)
+    lively = [(sum(n for _, _, n in notes) / len(notes), i) for i, notes in candidates if len(notes) * 4 >= busiest]
+    return max(lively)[1]
+
+
+def skyline(notes):
+    '''The highest note at each onset, cut where the next one starts (or held until it, over a short gap).'''
+    melody = []
+    for start, end, note in notes:
+        if melody and abs(start - melody[-1][0]) < 0.005:
+            if note > melody[-1][2]:
+                melody[-1] = (melody[-1][0], end, note)
+            continue
+        melody.append((start, end, note))
+
+    for i in range(len(melody) - 1):
+        start, end, note = melody[i]
+        gap = melody[i + 1][0] - end
+        melody[i] = (start, melody[i + 1][0] if gap < GAP else min(end, melody[i + 1][0]), note)
+
+    return melody
+
+
+def chord(pitches):
+    '''The bass note, or the bass and two more pitch classes, voiced upwards from the third octave.'''
+    if not pitches:
+        return ()
+
+    bass = min(pitches)
+    classes = []
+    for note in sorted(pitches):
+        if note % 12 not in classes:
+            classes.append(note % 12)
+
+    voicing = [CHORD_OCTAVE + classes[0]]
+    for pitch_class in classes[1:3]:
+        note = CHORD_OCTAVE + pitch_class
+        while note <= voicing[-1]:
+            note += 12
+        voicing.append(note)
+
+    if len(voicing) < 3:
+        return (CHORD_OCTAVE + bass % 12,)
+    return tuple(voicing)
+
+
+def fit(note, shift):
+    note += shift
+    while note < LOWEST:
+        note += 12
+    while note > HIGHEST:
+        note -= 12
+    return note
+
+
+def convert(tracks, melody_track, transpose):
+    melody = skyline(tracks[melody_track][0])
+    harmony = [n for i, (notes, _) in enumerate(tracks) for n in notes if i != melody_track]
+    taken = set((round(s, 3), n) for s, _, n in melody)
+    harmony += [n for n in tracks[melody_track][0] if (round(n[0], 3), n[2]) not in taken]
+    harmony.sort()
+
+    if transpose is None: # Whole octaves, until the melody fits.
+        transpose = 0
+        while max(n for _, _, n in melody) + transpose > HIGHEST:
+            transpose -= 12
+        while min(n for _, _, n in melody) + transpose < LOWEST and max(n for _, _, n in melody) + transpose + 12 <= HIGHEST:
+            transpose += 12
+
+    events = [] # (pitch or None, length in ms, chord)
+    previous = ()
+    clock = 0.0
+    sounding = [] # The harmony notes that may still sound, swept along with the melody.
+    j = 0
+
+    for i, (start, end, note) in enumerate(melody):
+        if start - clock >= 0.005: # A break before the note: the harmony stops too.
+            events.append((None, (start - clock) * 1000, ()))
+            previous = ()
+
+        while j < len(harmony) and harmony[j][0] < end:
+            sounding.append(harmony[j])
+            j += 1
+        sounding = [n for n in sounding if n[1] > start]
+
+        harmony_chord = tuple(fit(n, 0) for n in chord([n + transpose for _, _, n in sounding]))
+        if harmony_chord == previous:
+            harmony_chord = () # Still held.
+        else:
+            previous = harmony_chord
+
+        events.append((fit(note, transpose), (end - start) * 1000, harmony_chord))
+        clock = end
+
+    return quantize(events), transpose
+
+
+def quantize(events):
+    '''Rounds the lengths to 10 ms, at most LENGTHS different ones, carrying the error on.'''
+    for grid in range(1, 256):
+        result = []
+        error = 0.0
+        for pitch, length, harmony in events:
+            exact = length / 10 + error
+            ticks = max(grid, int(round(exact / grid)) * grid)
+            error = exact - ticks
+            while ticks > 255: # Longer than a note can be: the rest as a break.
+                result.append((pitch, 255 // grid * grid, harmony))
+                ticks -= 255 // grid * grid
+                pitch, harmony = None, ()
+            result.append((pitch, ticks, harmony))
+        if len(set(length for _, length, _ in result)) <= LENGTHS:
+            return result
+
+    raise MidiError('too many different lengths')
+
+
+def write_score(out, events, title, source, track, transpose):
+    with open(out, 'w') as f:
+        f.write('# %s, imported by Midi_importer.py from %s\n' % (title, os.path.basename(source)))
+        f.write('# (melody from track %d, moved %+d semitones).\n\n' % (track, transpose))
+        f.write('title %s\n' % title)
+
+        previous = None
+        for i, (pitch, length, harmony) in enumerate(events):
+            if i % PART == 0:
+                f.write('\npart\n')
+                previous = None
+            elif i % 8 == 0:
+                f.write('\n')
+            else:
+                f.write(' ')
+
+            token = name(pitch) if pitch is not None else '-'
+            if length != previous:
+                token += '/%d' % length
+            if harmony:
+                token += ':' + '+'.join(name(n) for n in harmony)
+            f.write(token)
+            previous = length
+
+        f.write('\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Converts a MIDI file into a score for Song_compiler.py.')
+    parser.add_argument('midi')
+    parser.add_argument('-o', '--output', help='the score (default songs/<name>.score)')
+    parser.add_argument('--title', help='the name in the song library (default from the file)')
+    parser.add_argument('--track', type=int, help='the melody track (default: guessed)')
+    parser.add_argument('--transpose', type=int, help='semitones (default: whole octaves to fit)')
+    args = parser.parse_args()
+
+    base = os.path.splitext(os.path.basename(args.midi))[0]
+    out = args.output or os.path.join(HERE, 'songs', re.sub(r'\W+', '_', base.lower()) + '.score')
+    began = time.perf_counter()
+
+    try:
+        tracks = read_midi(args.midi)
+        track = args.track if args.track is not None else pick_melody(tracks)
+        if not 0 <= track < len(tracks) or not tracks[track][0]:
+            raise MidiError('track %d has no notes' % track)
+
+        events, transpose = convert(tracks, track, args.transpose)
+        title = args.title or tracks[0][1] or base
+        title = title.encode('ascii', 'ignore').decode().strip()[:16] or base # The display has room for 16.
+        write_score(out, events, title, args.midi, track, transpose)
+    except (MidiError, OSError, IndexError, struct.error) as e:
+        sys.exit('Midi_importer.py: %s' % e)
+
+    print('%s: %d notes from track %d in %.1f ms' % (out, len(events), track, (time.perf_counter() - began) * 1000))
+
+
+if __name__ == '__main__':
+    main()
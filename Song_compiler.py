@@ -0,0 +1,289 @@
+'''
+Compiles the text scores in songs/ into the packed song tables of
+songs.c and songs.h for the music sequencer (music.c).
+
+Usage: python3 Song_compiler.py [score ...]   (default songs/*.score)
+
+A score is a text file; "#" starts a comment. "title <name>" names the
+song in the song library (the karaoke menu), "part" starts a part of the
+song (a song_t of its own; a song has one or more, played one after
+another) and "scale <factor>" stretches the lengths that follow it.
+"harmony steps" plays the harmony of the song note by note before each
+melody note, as the first songs were written, instead of the default
+"harmony fast": a fast arpeggio under the melody that takes none of its
+time (music.c). "lyric <row> <column> <text>" puts a line of the lyrics
+on the display when the next note starts; the lyric lines before a note
+make a screen of their own, and the rows of the screen before that not
+on it are cleared. The notes are tokens
+
+    PITCH[/LENGTH][:CHORD]
+
+PITCH is a note of pitches.h without the NOTE_ prefix (CS5) or "-" for
+a break. LENGTH is in 10 ms and can be left out when it is the same as
+the note before. CHORD is the harmony played before the note: one or
+three pitches joined with "+" (CS3+FS3+A3).
+
+Each note packs into 16 bits (MUSIC_NOTE in music.h): an index into the
+pitch table, an index into the lengths of the song and an index into the
+chord table. The pitch and chord tables are shared by all the songs and
+only hold what they use. The song library (song_library) lists every
+song with its title, in the order of the score file names.
+
+The lyrics become a track of their own next to the notes: a time (from
+the start of the part, in 10 ms, any harmony played before the notes
+included) for each row that changes, and what it changes to. The karaoke
+(karaoke.c) follows the clock, not the notes, and only redraws the rows
+that change. The sizes, and what the same songs took as plain melody,
+duration and harmony arrays, are printed at the end.
+'''
+
+import glob
+import os
+import re
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+PITCHES = 64 # Limits of the packed fields, as in music.h.
+LENGTHS = 16
+CHORDS = 64
+CHORD_TIME = 5 # MUSIC_CHORD_MS, in 10 ms: each note of a harmony.
+ROWS = 12 # Of text on the display...
+COLUMNS = 16 # ...and characters on a row.
+
+
+class ScoreError(Exception):
+    pass
+
+
+def read_pitches():
+    '''The notes of pitches.h by name, in Hz.'''
+    with open(os.path.join(HERE, 'pitches.h'), encoding='latin-1') as f:
+        return {m.group(1): int(m.group(2)) for m in re.finditer(r'#define NOTE_(\w+)\s+(\d+)', f.read())}
+
+
+def parse(path, notes):
+    '''Reads a score into its title, a list of parts (each a list of
+    (pitch, length, chord)) and the screens of lyrics (part, note, {row: (column, text)}).'''
+    title = os.path.splitext(os.path.basename(path))[0]
+    parts = []
+    screens = []
+    screen = {} # The lyric lines waiting for the next note.
+    arpeggio = 1
+    length = None
+    scale = 1.0
+
+    with open(path, encoding='latin-1') as f:
+        for number, raw in enumerate(f, 1):
+            raw = raw.split('#')[0]
+            line = raw.split()
+            where = '%s:%d' % (path, number)
+
+            if not line:
+                continue
+            if line[0] == 'lyric':
+                m = re.fullmatch(r'\s*lyric\s+(\d+)\s+(\d+)\s+(.*?)\s*', raw)
+                if not m:
+                    raise ScoreError(where + ': a lyric line is "lyric <row> <column> <text>"')
+                row, column, text = int(m.group(1)), int(m.group(2)), m.group(3)
+                if row >= ROWS or column + len(text) > COLUMNS:
+                    raise ScoreError(where + ': the line does not fit on the display')
+                if not text.isascii() or '"' in text or '\\' in text:
+                    raise ScoreError(where + ': the lyrics must be plain ASCII')
+                screen[row] = (column, text)
+                continue
+            if line[0] == 'part':
+                parts.append([])
+                length = None
+                continue
+            if line[0] == 'scale':
+                scale = float(line[1])
+                continue
+            if line[0] == 'harmony':
+                if line[1:] not in (['fast'], ['steps']):
+                    raise ScoreError(where + ': the harmony is "fast" or "steps"')
+                arpeggio = line[1] == 'fast'
+                continue
+            if line[0] == 'title':
+                title = ' '.join(line[1:])
+                if not title.isascii() or len(title) > 16 or '"' in title or '\\' in title:
+                    raise ScoreError(where + ': the title must be up to 16 characters of plain ASCII')
+                continue
+            if not parts:
+                raise ScoreError(where + ': notes before the first part')
+
+            for token in line:
+                m = re.fullmatch(r'(-|[A-G]S?\d)(?:/(\d+))?(?::([A-G]S?\d(?:\+[A-G]S?\d){0,2}))?', token)
+                if not m:
+                    raise ScoreError('%s: bad note "%s"' % (where, token))
+
+                pitch, written, chord = m.groups()
+
+                if written is not None:
+                    length = int(int(written) * scale) # Truncated, as a uint8_t initializer would.
+                if length is None:
+                    raise ScoreError('%s: "%s" has no length' % (where, token))
+                if not 0 < length < 256:
+                    raise ScoreError('%s: "%s" is too long' % (where, token))
+
+                chord = tuple(chord.split('+')) if chord else ()
+                if len(chord) == 2:
+                    raise ScoreError('%s: "%s" has two notes in the chord' % (where, token))
+
+                for name in (pitch,) + chord:
+                    if name != '-' and name not in notes:
+                        raise ScoreError('%s: no %s in pitches.h' % (where, name))
+
+                if screen:
+                    screens.append((len(parts) - 1, len(parts[-1]), screen))
+                    screen = {}
+
+                parts[-1].append((None if pitch == '-' else pitch, length, chord))
+
+    if screen:
+        raise ScoreError(path + ': lyrics after the last note')
+
+    return title, parts, screens, arpeggio
+
+
+def lyric_track(parts, screens, arpeggio):
+    '''The rows that change, in time order: (part, time, row, column, text or None to clear).'''
+    track = []
+    shown = {}
+
+    for part, note, screen in screens:
+        time = sum((0 if arpeggio else CHORD_TIME * len(chord)) + length for _, length, chord in parts[part][:note])
+        if time > 0xFFFF:
+            raise ScoreError('a lyric over 655 s into a part')
+
+        for row in sorted(set(shown) | set(screen)):
+            if screen.get(row) != shown.get(row):
+                column, text = screen.get(row, (0, None))
+                track.append((part, time, row, column, text))
+        shown = screen
+
+    return track
+
+
+def index(table, item, limit, what):
+    if item not in table:
+        if len(table) >= limit:
+            raise ScoreError('more than %d %s' % (limit, what))
+        table.append(item)
+    return table.index(item)
+
+
+def compile_songs(paths):
+    notes = read_pitches()
+    pitches = [None] # 0: a break, or no note in a chord.
+    chords = [()] # 0: no harmony.
+    songs = []
+
+    for path in paths:
+        name = os.path.splitext(os.path.basename(path))[0]
+        title, parts, screens, arpeggio = parse(path, notes)
+        lengths = []
+        packed = []
+
+        if not parts:
+            raise ScoreError(path + ': no parts')
+
+        for part in parts:
+            if len(part) > 255:
+                raise ScoreError('%s: a part of over 255 notes' % path)
+
+            packed.append([])
+            for pitch, length, chord in part:
+                for note in chord:
+                    index(pitches, note, PITCHES, 'pitches')
+                packed[-1].append((index(pitches, pitch, PITCHES, 'pitches'),
+                                   index(lengths, length, LENGTHS, 'lengths in ' + path),
+                                   index(chords, chord, CHORDS, 'chords')))
+
+        lyrics = lyric_track(parts, screens, arpeggio)
+        if len(lyrics) > 255:
+            raise ScoreError('%s: over 255 lyric changes' % path)
+
+        songs.append((name, title, lengths, packed, lyrics, arpeggio))
+
+    return notes, pitches, chords, songs
+
+
+def write(notes, pitches, chords, songs, paths):
+    count = sum(len(part) for _, _, _, parts, _, _ in songs for part in parts)
+    flash = (len(pitches) * 2 + len(chords) * 3 + count * 2 + len(songs) * 12
+             + sum(len(lengths) + len(parts) * 12 for _, _, lengths, parts, _, _ in songs))
+    plain = count * (2 + 1 + 3 * 2) + sum(len(parts) * 16 for _, _, _, parts, _, _ in songs)
+    sources = ', '.join(os.path.relpath(p, HERE) for p in paths)
+
+    def pad(chord):
+        return [pitches.index(n) for n in chord] + [0] * (3 - len(chord))
+
+    with open(os.path.join(HERE, 'songs.c'), 'w') as c:
+        c.write('/*\n * Generated by Song_compiler.py from %s: do not edit.\n *\n' % sources)
+        c.write(' * %d notes in %d bytes of flash (%d as plain arrays).\n */\n\n' % (count, flash, plain))
+        c.write('#include <inttypes.h>\n#include <stddef.h>\n#include "music.h"\n#include "songs.h"\n\n')
+
+        c.write('const uint16_t music_pitches[] = {\n\t0,\n')
+        for name in pitches[1:]:
+            c.write('\t%d, // %d: %s\n' % (notes[name], pitches.index(name), name))
+        c.write('};\n\n')
+
+        c.write('const uint8_t music_chords[][3] = {\n\t{0, 0, 0},\n')
+        for i, chord in enumerate(chords[1:], 1):
+            c.write('\t{%s}, // %d: %s\n' % (', '.join(str(n) for n in pad(chord)), i, '+'.join(chord)))
+        c.write('};\n')
+
+        for name, _, lengths, parts, lyrics, arpeggio in songs:
+            c.write('\nstatic const uint8_t %s_lengths[] = {%s};\n' % (name, ', '.join(str(l) for l in lengths)))
+
+            for i, part in enumerate(parts):
+                c.write('\nstatic const uint16_t %s_%d[] = {\n' % (name, i))
+                for j in range(0, len(part), 8):
+                    c.write('\t' + ' '.join('MUSIC_NOTE(%d, %d, %d),' % note for note in part[j:j + 8]) + '\n')
+                c.write('};\n')
+
+            c.write('\nconst song_t %s[] = {\n' % name)
+            for i, part in enumerate(parts):
+                c.write('\t{%s_%d, %s_lengths, %d, %d},\n' % (name, i, name, len(part), arpeggio))
+            c.write('};\n')
+
+            if lyrics:
+                c.write('\nstatic const lyric_t %s_lyrics[] = { // Part, time, row, column, text.\n' % name)
+                for part, time, row, column, text in lyrics:
+                    c.write('\t{%d, %d, %d, %d, %s},\n' % (part, time, row, column, '"%s"' % text if text else 'NULL'))
+                c.write('};\n')
+
+        c.write('\nconst song_entry_t song_library[] = {\n')
+        for name, title, _, parts, lyrics, _ in songs:
+            c.write('\t{"%s", %s, %d, %s, %d},\n' % (title, name, len(parts),
+                    name + '_lyrics' if lyrics else 'NULL', len(lyrics)))
+        c.write('};\n')
+
+    with open(os.path.join(HERE, 'songs.h'), 'w') as h:
+        h.write('/*\n * Generated by Song_compiler.py from %s: do not edit.\n */\n\n' % sources)
+        h.write('#ifndef SONGS_H_\n#define SONGS_H_\n\n#include "music.h"\n\n')
+        h.write('#define SONG_LIBRARY %d // Songs in song_library.\n\n' % len(songs))
+        for name, _, _, parts, _, _ in songs:
+            h.write('extern const song_t %s[%d];\n' % (name, len(parts)))
+        h.write('\nextern const song_entry_t song_library[SONG_LIBRARY];\n')
+        h.write('\n#endif\n')
+
+    for name, _, lengths, parts, lyrics, _ in songs:
+        print('%s: %d part(s), %d notes, %d lengths, %d lyric changes' % (name, len(parts),
+              sum(len(p) for p in parts), len(lengths), len(lyrics)))
+    print('%d pitches, %d chords' % (len(pitches) - 1, len(chords) - 1))
+    print('flash: %d bytes (%d as plain arrays), RAM: 0 bytes' % (flash, plain))
+
+
+def main():
+    paths = sys.argv[1:] or sorted(glob.glob(os.path.join(HERE, 'songs', '*.score')))
+
+    try:
+        write(*compile_songs(paths), paths)
+    except (ScoreError, OSError) as e:
+        sys.exit('Song_compiler.py: %s' % e)
+
+
+if __name__ == '__main__':
+    main()
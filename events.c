@@ -0,0 +1,117 @@
+/*
+ * Event queue between the producers (timer Swis, sensorTask, commTask)
+ * and uiTask, on top of a BIOS Mailbox.
+ *
+ * uiTask is the only one that changes the program state: the others
+ * post what happened and uiTask pends on the mailbox, so it runs as
+ * soon as there is something to do instead of polling globals every
+ * 100 ms. Posting never blocks, so it works from the Swis too; if the
+ * mailbox is full the event is dropped (and counted).
+ */
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <inttypes.h>
+#include <string.h>
+
+// BIOS header files
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Mailbox.h>
+#include <ti/sysbios/knl/Swi.h>
+
+#include "events.h"
+#include "trace.h"
+
+static Mailbox_Handle mailbox;
+static event_stats_t stats;
+
+/*
+ * Call from main before BIOS_start.
+ */
+void events_init() {
+	Mailbox_Params mailboxParams;
+	Mailbox_Params_init(&mailboxParams);
+	mailbox = Mailbox_create(sizeof(event_t), EVENT_QUEUE_SIZE, &mailboxParams, NULL);
+
+	if (mailbox == NULL) {
+		System_abort("Couldn't create the event mailbox!");
+	}
+
+	memset(&stats, 0, sizeof(stats));
+}
+
+/*
+ * Posts an event for uiTask. Returns 1 if posted, 0 if the mailbox was
+ * full. Never blocks: callable from Swis and tasks alike.
+ */
+uint8_t event_post(uint8_t type, uint8_t arg, int16_t x, int16_t y) {
+	return event_post_at(type, arg, x, y, Clock_getTicks());
+}
+
+/*
+ * Like event_post, for an event that happened at ticks already: a button
+ * edge or a sensor sample. The latency is counted from then.
+ */
+uint8_t event_post_at(uint8_t type, uint8_t arg, int16_t x, int16_t y, uint32_t ticks) {
+	event_t event;
+	UInt key;
+	Bool ok;
+
+	event.type = type;
+	event.arg = arg;
+	event.x = x;
+	event.y = y;
+	event.ticks = ticks;
+
+	ok = Mailbox_post(mailbox, &event, BIOS_NO_WAIT);
+
+	key = Swi_disable();
+	if (ok) {
+		stats.posted++;
+	} else {
+		stats.dropped++;
+		trace_log(TRACE_DROP, type, arg);
+	}
+	Swi_restore(key);
+
+	return ok ? 1 : 0;
+}
+
+/*
+ * Waits up to timeout ticks (or BIOS_WAIT_FOREVER) for the next event
+ * posted at or after since (ticks). Older ones were meant for a state
+ * uiTask has left already, e.g. button presses during the karaoke, and
+ * are dropped. Returns 1 if an event was received, 0 on timeout.
+ */
+uint8_t event_pend(event_t *event, uint32_t timeout, uint32_t since) {
+	uint32_t latency;
+	UInt key;
+
+	while (Mailbox_pend(mailbox, event, timeout)) {
+		latency = (Clock_getTicks() - event->ticks) * Clock_tickPeriod;
+		key = Swi_disable();
+
+		if ((int32_t) (event->ticks - since) < 0) {
+			stats.stale++;
+			Swi_restore(key);
+			continue;
+		}
+
+		stats.latency_us_sum += latency;
+		if (latency > stats.latency_us_max) stats.latency_us_max = latency;
+		Swi_restore(key);
+
+		trace_log(TRACE_EVENT, event->type, event->arg);
+
+		return 1;
+	}
+
+	return 0;
+}
+
+void events_get_stats(event_stats_t *out) {
+	UInt key = Swi_disable();
+	*out = stats;
+	Swi_restore(key);
+}
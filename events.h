@@ -0,0 +1,51 @@
+/*
+ * Events from the timers, the inputs, the sensors and the backend to uiTask.
+ */
+
+#ifndef EVENTS_H_
+#define EVENTS_H_
+
+#include <inttypes.h>
+
+#define EVENT_QUEUE_SIZE 16
+
+/*
+ * The event types.
+ *   BUTTON0, BUTTON1: a button was pressed (input.c).
+ *   TICK: one second of the stopwatch / REVERSE clock.
+ *   CALIBRATED: the sensors are ready.
+ *   MOVE: a gesture in the game; arg is the direction, x the confidence.
+ *   MENU_NEXT, MENU_SELECT: a gesture in the menu.
+ *   TILT: a maze sample; x and y are the acceleration in cm/s^2.
+ *   TEMP: a stopwatch temperature sample in C (x).
+ *   WIN, LOST: the result from the backend.
+ *   RELEASE: a button was released; arg is the button, x the time held in ms (up to INT16_MAX).
+ *   LONG_PRESS: a button has been held for INPUT_LONG_MS; arg is the button.
+ *   REPEAT: a button is still held, every INPUT_REPEAT_MS after the long press.
+ *   NOTE: the music (music.c) moved on to note arg, or ended (x 1).
+ */
+enum event_type {EV_BUTTON0=1, EV_BUTTON1, EV_TICK, EV_CALIBRATED, EV_MOVE, EV_MENU_NEXT, EV_MENU_SELECT, EV_TILT, EV_TEMP, EV_WIN, EV_LOST, EV_RELEASE, EV_LONG_PRESS, EV_REPEAT, EV_NOTE, EV_COUNT};
+
+typedef struct {
+	uint8_t type;
+	uint8_t arg;
+	int16_t x;
+	int16_t y;
+	uint32_t ticks; // Clock_getTicks() when it happened, usually when posted.
+} event_t;
+
+typedef struct {
+	uint32_t posted;
+	uint32_t dropped; // The mailbox was full.
+	uint32_t stale; // Posted before uiTask entered its current state.
+	uint32_t latency_us_sum; // From the event to event_pend, delivered events only.
+	uint32_t latency_us_max;
+} event_stats_t;
+
+void events_init();
+uint8_t event_post(uint8_t type, uint8_t arg, int16_t x, int16_t y);
+uint8_t event_post_at(uint8_t type, uint8_t arg, int16_t x, int16_t y, uint32_t ticks);
+uint8_t event_pend(event_t *event, uint32_t timeout, uint32_t since);
+void events_get_stats(event_stats_t *stats);
+
+#endif
@@ -0,0 +1,140 @@
+/*
+ * The dispatcher for the state table in main.c.
+ *
+ * An event is handled with one lookup, table[state].on[event type]:
+ * the action runs and the machine moves to the state it returns (or to
+ * the fixed next state of the row). Every transition runs the exit
+ * hook of the old state and the entry hook of the new one, so the
+ * set-up and clean-up of a state live in one place whichever input
+ * caused the move. The last FSM_TRACE_SIZE transitions are kept with
+ * their timestamps, and every one goes to the trace log (trace.c).
+ *
+ * Everything here runs in uiTask. The other tasks only read the state
+ * with fsm_state().
+ */
+
+#include <xdc/std.h>
+#include <inttypes.h>
+
+// BIOS header files
+#include <ti/sysbios/knl/Clock.h>
+
+#include "fsm.h"
+#include "trace.h"
+
+static const fsm_state_t *states;
+static uint8_t state_count = 0;
+
+static uint8_t current = 0;
+static uint8_t previous = 0;
+static uint32_t since = 0; // Ticks when the current state was entered.
+
+static fsm_trace_t trace[FSM_TRACE_SIZE];
+static uint32_t transitions = 0;
+
+/*
+ * Moves to state next: exit hook, trace, entry hook.
+ */
+static void enter(uint8_t next, uint8_t cause) {
+	fsm_trace_t *t;
+
+	if (next == 0 || next >= state_count) return;
+
+	t = &trace[transitions % FSM_TRACE_SIZE];
+
+	if (states[current].exit) states[current].exit();
+
+	t->ticks = Clock_getTicks();
+	t->from = current;
+	t->to = next;
+	t->cause = cause;
+	transitions++;
+
+	trace_log(TRACE_STATE, current, next);
+
+	previous = current;
+	current = next;
+	since = t->ticks;
+
+	if (states[current].entry) states[current].entry();
+}
+
+/*
+ * Starts the machine in state initial; its entry hook runs.
+ */
+void fsm_init(const fsm_state_t *table, uint8_t count, uint8_t initial) {
+	states = table;
+	state_count = count;
+	current = initial;
+	previous = initial;
+	since = Clock_getTicks();
+
+	if (states[current].entry) states[current].entry();
+}
+
+/*
+ * Handles an event in the current state.
+ */
+void fsm_dispatch(const event_t *event) {
+	const fsm_transition_t *t;
+	uint8_t next;
+
+	if (event->type >= EV_COUNT) return;
+
+	t = &states[current].on[event->type];
+	next = t->next;
+
+	if (t->action) {
+		uint8_t result = t->action(event);
+		if (result) next = result;
+	}
+
+	enter(next, event->type);
+}
+
+/*
+ * Does the work of the current state, e.g. drawing it or playing a
+ * song, and moves on if it says so.
+ */
+void fsm_run() {
+	if (states[current].run) enter(states[current].run(NULL), 0);
+}
+
+uint8_t fsm_state() {
+	return current;
+}
+
+/*
+ * The state we came from, e.g. to tell whether WIN was the maze's.
+ */
+uint8_t fsm_previous() {
+	return previous;
+}
+
+/*
+ * Ticks when the current state was entered.
+ */
+uint32_t fsm_since() {
+	return since;
+}
+
+const char *fsm_name(uint8_t state) {
+	return state < state_count && states[state].name ? states[state].name : "-";
+}
+
+/*
+ * Copies the kept transitions, oldest first, into out (FSM_TRACE_SIZE
+ * entries). Returns how many there are; total gets all transitions
+ * since the start.
+ */
+uint8_t fsm_get_trace(fsm_trace_t *out, uint32_t *total) {
+	uint8_t n = transitions < FSM_TRACE_SIZE ? transitions : FSM_TRACE_SIZE;
+	uint8_t i;
+
+	for (i = 0; i < n; i++) {
+		out[i] = trace[(transitions - n + i) % FSM_TRACE_SIZE];
+	}
+
+	*total = transitions;
+	return n;
+}
@@ -0,0 +1,51 @@
+/*
+ * Table-driven state machine for uiTask.
+ */
+
+#ifndef FSM_H_
+#define FSM_H_
+
+#include <inttypes.h>
+#include "events.h"
+
+#define FSM_TRACE_SIZE 32 // Transitions kept for the trace.
+
+// An action runs on an event (or as the work of a state) and returns
+// the state to move to, or 0 to let the table decide.
+typedef uint8_t (*fsm_action_t)(const event_t *event);
+
+typedef struct {
+	uint8_t next; // State to move to, 0 to stay.
+	fsm_action_t action; // Optional; its result overrides next.
+} fsm_transition_t;
+
+/*
+ * One row per state: its name, entry and exit hooks, the work it does
+ * in uiTask (run, with event NULL) and what each event type leads to.
+ * Events without a transition are ignored in that state.
+ */
+typedef struct {
+	const char *name;
+	void (*entry)();
+	void (*exit)();
+	fsm_action_t run;
+	fsm_transition_t on[EV_COUNT];
+} fsm_state_t;
+
+typedef struct {
+	uint32_t ticks;
+	uint8_t from;
+	uint8_t to;
+	uint8_t cause; // Event type, 0 if the state's run moved on by itself.
+} fsm_trace_t;
+
+void fsm_init(const fsm_state_t *table, uint8_t count, uint8_t initial);
+void fsm_dispatch(const event_t *event);
+void fsm_run();
+uint8_t fsm_state();
+uint8_t fsm_previous();
+uint32_t fsm_since();
+const char *fsm_name(uint8_t state);
+uint8_t fsm_get_trace(fsm_trace_t *out, uint32_t *total);
+
+#endif
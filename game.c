@@ -39,13 +39,29 @@
 
 #include <driverlib/timer.h>
 #include "wireless/comm_lib.h"
-#include "buzzer.h"
-#include "pitches.h"
 #include "karaoke.h"
 #include "game.h"
+#include "link.h"
+#include "maze.h"
+#include "maze_view.h"
+#include "pt.h"
+#include "session.h"
+#include "sfx.h"
+#include "songs.h"
 
 #define PI 3.14159265 // This is rather self-explanatory...
 
+// Cells on a side: all maze.h has room for. The 2 * MAZE_CELLS + 1
+// blocks of MAZE_BLOCK pixels are more than the display shows.
+#define MAZE_CELLS MAZE_MAX
+
+// The ball physics, in fixed point: 1/256 pixels, and a step per tilt sample.
+#define BALL_SHIFT 8
+#define BALL_DEAD 50 // cm/s^2 of tilt ignored (an unsteady hand).
+#define BALL_GAIN 4 // The tilt, in cm/s^2, shifted down: 1 g speeds the ball up 61/256 pixels a step.
+#define BALL_FRICTION 4 // Lost each step: 1/16 of the velocity.
+#define BALL_MAX ((MAZE_BLOCK - 1) << BALL_SHIFT) // Under a block a step, so a step crosses one block edge at most.
+
 // Numerical values: 0 * PI/4, 1 * PI/4, 2 * PI/4, ...
 enum direction {DOWN=0, DOWNRIGHT, RIGHT, UPRIGHT, UP, UPLEFT, LEFT, DOWNLEFT, NONE};
 enum direction dir = NONE; // Storing the current direction.
@@ -54,18 +70,59 @@ enum direction dir_list[100]; // List of directions; used for backtracing.
 
 uint8_t index = 0; // Index for the array containing the directions.
 
-uint8_t ball_x = 8;
-uint8_t ball_y = 56; // Display coordinates for the maze "ball".
-
-uint8_t end_i;
-uint8_t end_j; // (i,j)-coordinates for the winning block.
+uint16_t ball_x;
+uint16_t ball_y; // Maze coordinates for the maze "ball", in pixels from the top left corner.
 
 uint8_t clear = 1; // If starting a new game, clear the maze display.
-uint8_t blocks[6][6]; //
+static maze_t maze;
+static maze_view_t view; // The part of the maze on the display.
+
+static struct {
+	int32_t x; // Maze pixels << BALL_SHIFT.
+	int32_t y;
+	int32_t vx; // Maze pixels << BALL_SHIFT a step.
+	int32_t vy;
+} ball;
+
+static uint32_t mazePalette[] = {0, 0xFFFFFF};
+
+static struct {
+	pt_t pt;
+	PIN_Handle buzzerHandle;
+	PIN_Handle ledHandle;
+} illegal;
+
+/*
+ * The discouraging part of an illegal move, with a pause after it.
+ */
+static uint8_t illegal_thread(pt_t *pt) {
+	if (pt->aborted) { // Cut short: no more tones or flashes.
+		sfx_stop();
+		PIN_setOutputValue(illegal.ledHandle, Board_LED1, 0);
+		return PT_ENDED;
+	}
+
+	PT_BEGIN(pt);
+
+	// Flash the red LED in a discouraging fashion.
+	// ...in time with some discouraging tones (SFX_ILLEGAL) to boot.
+	PIN_setOutputValue(illegal.ledHandle, Board_LED1, 1);
+	sfx_play(illegal.buzzerHandle, SFX_ILLEGAL);
+	PT_SLEEP(pt, 500000 / Clock_tickPeriod);
+	PIN_setOutputValue(illegal.ledHandle, Board_LED1, 0);
+	PT_SLEEP(pt, 500000 / Clock_tickPeriod);
+	PIN_setOutputValue(illegal.ledHandle, Board_LED1, 1);
+	PT_SLEEP(pt, 800000 / Clock_tickPeriod);
+	PIN_setOutputValue(illegal.ledHandle, Board_LED1, 0);
+
+	PT_SLEEP(pt, 2000000 / Clock_tickPeriod);
+
+	PT_END(pt);
+}
 
 /*
  * Notifying the user about an illegal move: displays a cross, asks the user how many she/he has
- * taken and punishes with discouraging music.
+ * taken and punishes with discouraging music. The music plays on after this returns.
  */
 void illegal_move(PIN_Handle buzzerHandle, Display_Handle displayHandle, PIN_Handle ledHandle) {
 	Display_clear(displayHandle);
@@ -95,81 +152,70 @@ void illegal_move(PIN_Handle buzzerHandle, Display_Handle displayHandle, PIN_Han
 	Display_print0(displayHandle, 8, 2, "Montako olet");
 	Display_print0(displayHandle, 9, 1, "oikein ottanut?");
 
-	// Flash the red LED in a discouraging fashion.
-	// ...and some discouraging tones to boot.
-	PIN_setOutputValue(ledHandle, Board_LED1, 1);
-	buzzerOpen(buzzerHandle);
-	buzzerSetFrequency(NOTE_B4);
-	Task_sleep(500000 / Clock_tickPeriod);
-	PIN_setOutputValue(ledHandle, Board_LED1, 0);
-	buzzerSetFrequency(NOTE_AS4);
-	Task_sleep(500000 / Clock_tickPeriod);
-	PIN_setOutputValue(ledHandle, Board_LED1, 1);
-	buzzerSetFrequency(NOTE_A4);
-	Task_sleep(800000 / Clock_tickPeriod);
-	PIN_setOutputValue(ledHandle, Board_LED1, 0);
-	buzzerClose();
-
-	Task_sleep(2000000 / Clock_tickPeriod);
+	illegal.buzzerHandle = buzzerHandle;
+	illegal.ledHandle = ledHandle;
+	pt_spawn(&illegal.pt, illegal_thread);
 }
 
+static struct {
+	pt_t pt;
+	tContext *pContext;
+	uint8_t note; // Drawn up to this note.
+	uint8_t point_index;
+	music_t music;
+} celebration;
+
 /*
- * Informing the user about winning the game: displays a galaxy animation and
- * further celebrates by playing the chorus of the iconic Sexbomb by Tom Jones.
+ * The galaxy animation: three more points whenever the music moves on
+ * to the next note.
  */
-void win(PIN_Handle buzzerHandle, Display_Handle displayHandle, PIN_Handle ledHandle) {
-	Display_clear(displayHandle);
-	tContext *pContext = DisplayExt_getGrlibContext(displayHandle);
-	Display_print0(displayHandle, 9, 1, "Voitto kotiin!"); // Notify about winning the game.
-
-	uint8_t i = 0;
-	uint8_t j = 0;
-	uint8_t point_index = 0;
-
-	/*
-	 * Melody, durations and harmony for Sexbomb.
-	 * Used the sheet music from https://sheets-piano.ru/wp-content/uploads/2012/02/Tom-Jones-Sexbomb.pdf.
-	 */
-	uint16_t melody[] = {
-	    NOTE_B4, NOTE_GS4, NOTE_B4, NOTE_GS4, 0, NOTE_CS5, NOTE_B4, NOTE_DS5, NOTE_B4, NOTE_CS5,
-	    0, NOTE_B4, NOTE_GS4, NOTE_B4, NOTE_B4, NOTE_B4, NOTE_B4, NOTE_B4, NOTE_B4, NOTE_AS4,
-	    NOTE_AS4, NOTE_AS4, NOTE_GS4, NOTE_B4, NOTE_GS4, NOTE_B4, NOTE_GS4, NOTE_B4, NOTE_GS4, 0,
-	    NOTE_CS5, NOTE_B4, NOTE_DS5, NOTE_B4, NOTE_CS5, 0, NOTE_E4, NOTE_B4, NOTE_GS4, NOTE_B4,
-	    NOTE_DS4, NOTE_FS4, NOTE_FS4, NOTE_GS4
-	};
+static uint8_t galaxy_thread(pt_t *pt) {
+	uint8_t j;
 
-	uint8_t durations[] = {
-	    30*1.25, 30*1.25, 30*1.25, 30*1.25, 15*1.25, 30*1.25, 15*1.25, 30*1.25, 15*1.25, 30*1.25, 15*1.25, 15*1.25, 15*1.25, 15*1.25, 15*1.25, 15*1.25, 15*1.25, 15*1.25, 15*1.25, 15*1.25, 15*1.25, 15*1.25, 15*1.25,
-	    15*1.25, 15*1.25, 30*1.25, 30*1.25, 30*1.25, 30*1.25, 15*1.25, 30*1.25, 15*1.25, 30*1.25, 15*1.25, 15*1.25, 15*1.25, 15*1.25, 15*1.25, 15*1.25, 15*1.25, 15*1.25, 30*1.25, 15*1.25, 45*1.25
-	};
+	if (pt->aborted) { // Skipped: the music too.
+		music_stop(&celebration.music);
+		return PT_ENDED;
+	}
 
-	uint16_t harmony[][3] = {
-	    {0, 0, 0}, {NOTE_DS3, NOTE_GS3, NOTE_B3}, {0, 0, 0}, {NOTE_GS3, 0, 0}, {0, 0, 0}, {NOTE_CS3, NOTE_E3, NOTE_GS3},
-	    {0, 0, 0}, {0, 0, 0}, {NOTE_CS3, 0, 0}, {0, 0, 0}, {0, 0, 0}, {NOTE_DS3, NOTE_GS3, NOTE_B3},
-	    {0, 0, 0}, {0, 0, 0}, {NOTE_GS3, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0},
-	    {NOTE_DS3, NOTE_G3, NOTE_AS3}, {0, 0, 0}, {0, 0, 0}, {NOTE_DS3, 0, 0}, {0, 0, 0}, {0, 0, 0},
-	    {0, 0, 0}, {NOTE_DS3, NOTE_GS3, NOTE_B3}, {0, 0, 0}, {NOTE_GS3, 0, 0}, {0, 0, 0}, {NOTE_CS3, NOTE_E3, NOTE_GS3},
-	    {0, 0, 0}, {0, 0, 0}, {NOTE_CS3, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {NOTE_DS3, NOTE_GS3, NOTE_B3},
-	    {0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {NOTE_DS3, NOTE_G3, NOTE_AS3}, {0, 0, 0}, {NOTE_DS3, NOTE_GS3, NOTE_B3}
-	};
+	PT_BEGIN(pt);
 
-	buzzerOpen(buzzerHandle);
+	celebration.note = 0;
+	celebration.point_index = 0;
 
-	for (i = 0; i <= 43; i++) {
-		play_notes(buzzerHandle, harmony[i], melody, durations, i);
+	while (celebration.point_index <= 100) {
+		PT_WAIT_UNTIL(pt, celebration.music.i != celebration.note || !celebration.music.playing);
+		celebration.note = celebration.music.i;
 
-	    // Draw the animation simultaneously.
 	    for (j = 1; j <= 3; j++) {
-	    	if (point_index <= 100) {
-	    		GrCircleDraw(pContext, 48 + point_index * 1/3 * cos(point_index * 1/3), 96 - (60 + point_index * 1/3 * sin(point_index * 1/3)), 1.5);
-	    		point_index++;
+	    	if (celebration.point_index <= 100) {
+	    		GrCircleDraw(celebration.pContext, 48 + celebration.point_index * 1/3 * cos(celebration.point_index * 1/3),
+	    				96 - (60 + celebration.point_index * 1/3 * sin(celebration.point_index * 1/3)), 1.5);
+	    		celebration.point_index++;
 	    	}
 	    }
 
-	    GrFlush(pContext);
+	    GrFlush(celebration.pContext);
+
+	    if (!celebration.music.playing) break;
 	}
 
-	buzzerClose();
+	PT_WAIT_UNTIL(pt, !celebration.music.playing); // The galaxy is full: let the song finish.
+
+	PT_END(pt);
+}
+
+/*
+ * Informing the user about winning the game: displays a galaxy animation and
+ * further celebrates by playing the chorus of the iconic Sexbomb by Tom Jones.
+ * The music and the animation go on after this returns.
+ */
+void win(PIN_Handle buzzerHandle, Display_Handle displayHandle, PIN_Handle ledHandle) {
+	Display_clear(displayHandle);
+	celebration.pContext = DisplayExt_getGrlibContext(displayHandle);
+	Display_print0(displayHandle, 9, 1, "Voitto kotiin!"); // Notify about winning the game.
+
+	music_start(&celebration.music, buzzerHandle, sexbomb); // Sexbomb by Tom Jones (songs/sexbomb.score).
+	pt_spawn(&celebration.pt, galaxy_thread); // Draw the animation simultaneously.
 }
 
 /*
@@ -242,13 +288,8 @@ void draw_arrows(Display_Handle displayHandle, PIN_Handle buzzerHandle) {
 			}
 		}
 
-		// Notify the user with a weird sound.
-		for (i = 0; i < 10; i++){
-			buzzerOpen(buzzerHandle);
-		    buzzerSetFrequency(500 + 400*sin(2 * i));
-		    Task_sleep((20000 + 20000 * sin(i)) / Clock_tickPeriod);
-		    buzzerClose();
-		}
+		// Notify the user with a weird sound: it cuts short the one of the move before.
+		sfx_play(buzzerHandle, SFX_ARROWS);
 	}
 
 	GrFlush(pContext);
@@ -256,208 +297,189 @@ void draw_arrows(Display_Handle displayHandle, PIN_Handle buzzerHandle) {
 
 /*
  * Draws the maze and the ball on the display.
- * If starting a new game, generate the maze and draw it once.
- * On subsequent calls, draw just the ball at its updated location.
- *
- * The maze is generated with a simple algorithm.
- * The 96x96-display is divided into 16x16 blocks (36);
- * the origin is at the bottom-left corner.
+ * If starting a new game, generate the maze and draw the view of it.
+ * On subsequent calls, scroll the view after the ball if it has to,
+ * and draw the ball at its updated location.
  *
- * (0,2) is used as a starting point in (i,j)-coordinates;
- * on each iteration, select a random adjacent block (up, right, down)
- * until an accessible block is found. Iterate 30 times and
- * use the last block as the end point.
- *
- * Could surely be further optimized but suffices for a small
- * array like this.
+ * The maze is a perfect one (maze.c) of MAZE_CELLS x MAZE_CELLS cells,
+ * drawn as its blocks of 8x8 pixels: the walls are filled, the cells
+ * and the open walls between them are not. The display shows 12x12
+ * blocks of it around the ball (maze_view.c); only the rows of the view
+ * that changed are rendered and blitted, a band of them at a time. The
+ * ball starts from the middle of the left side, and the end is the cell
+ * furthest from it along the way.
  */
 void draw_labyrinth(Display_Handle displayHandle) {
 	tContext *pContext = DisplayExt_getGrlibContext(displayHandle);
-
-	uint8_t i;
-	uint8_t j;
-
-	int8_t i_temp = 0;
-	int8_t j_temp = 0;
-
-	uint8_t count = 0;
-	uint8_t rand_dir;
-
-	srand(Clock_getTicks());
+	tImage rows = {
+		.BPP = IMAGE_FMT_1BPP_UNCOMP,
+		.NumColors = 2,
+		.XSize = MAZE_VIEW,
+		.pPalette = mazePalette,
+		.pPixel = view.band
+	};
+	uint8_t y;
 
 	if (clear) { // If it's a new game...
 		Display_clear(displayHandle); // Clear the display to begin with.
 
-		// Iterate through all the blocks (6 * 6 = 36).
-		for (i = 0; i < 6; i++) {
-		    for (j = 0; j < 6; j++) {
-		        if (i == 0 && j == 2) {
-		            blocks[i][j] = 1; // If starting point, set it accessible.
-		        } else {
-		            blocks[i][j] = 0; // Else set the point non-accessible.
-		        }
-		    }
-		}
-
-		i = 0;
-		j = 2; // Begin iterating from the starting point.
-
-		while (count < 30) { // Iterate 30 times.
-		    rand_dir = rand() % 3; // Select a (pseudo-)random direction.
-
-		    switch (rand_dir) {
-		        case 0: // Up!
-		            i_temp = i;
-		            j_temp = j + 1;
-		            break;
-		        case 1: // Right!
-		            i_temp = i + 1;
-		            j_temp = j;
-		            break;
-		        case 2: // Down!
-		            i_temp = i;
-		            j_temp = j - 1;
-		            break;
-		    }
-
-		    // The block might be out of bounds: select another direction if this is the case.
-		    while (i_temp < 0 || i_temp > 5 || j_temp < 0 || j_temp > 5) {
-		        rand_dir = rand() % 3; // Select a (pseudo-)random direction.
-
-		        switch (rand_dir) {
-		            case 0: // Up!
-		                i_temp = i;
-		                j_temp = j + 1;
-		                break;
-		            case 1: // Right!
-		                i_temp = i + 1;
-		                j_temp = j;
-		                break;
-		            case 2: // Down!
-		                i_temp = i;
-		                j_temp = j - 1;
-		                break;
-		        }
-		    }
-
-		    blocks[i_temp][j_temp] = 1; // Set the block (i_temp, j_temp) accessible.
-		    i = i_temp;
-		    j = j_temp; // Begin the new iteration from the new accessible block.
-
-		    end_i = i;
-		    end_j = j; // The last block handled by the algorithm will be stored here.
-
-		    count++; // Ensure that the algorithm won't run forever...
-		}
+		maze_generate(&maze, MAZE_CELLS, MAZE_CELLS, 0, Clock_getTicks());
 
 		clear = 0; // The game isn't new after generating the maze and drawing it.
 
-		// Draw the maze.
-		for (i = 0; i < 6; i++) { // Yet another pair of nested for-loops...
-		    for (j = 0; j < 6; j++) {
-		        if (blocks[i][j] == 0) { // If the block is non-accessible...
-		        	// Setting the dimensions.
-		        	// 96 - y is used to account for the different placement of the origin.
-		            tRectangle rect = {16 * i, 96 - 16 * j, 16 * (i + 1), 96 - 16 * (j + 1)};
-		            GrRectDraw(pContext, &rect); // Draw a rectangle on it...
-		            GrRectFill(pContext, &rect); // ...and fill it.
-		        }
-		    }
-		}
-
-		// Draw the end block icon.
-		GrCircleDraw(pContext, 16 * end_i + 8, 96 - (16 * end_j + 8), 4);
-		GrCircleDraw(pContext, 16 * end_i + 8, 96 - (16 * end_j + 8), 2);
-		GrCircleDraw(pContext, 16 * end_i + 8, 96 - (16 * end_j + 8), 1);
+		// The ball to the middle of the start block, and the view around it.
+		ball_x = MAZE_BLOCK * (2 * maze.start_x + 1) + MAZE_BLOCK / 2;
+		ball_y = MAZE_BLOCK * (2 * maze.start_y + 1) + MAZE_BLOCK / 2;
+		ball.x = (int32_t) ball_x << BALL_SHIFT;
+		ball.y = (int32_t) ball_y << BALL_SHIFT;
+		ball.vx = ball.vy = 0;
+		maze_view_init(&view, &maze, ball_x, ball_y);
+	} else {
+		maze_view_follow(&view, &maze, ball_x, ball_y);
 	}
 
-	// On every call, draw a small circle on the new ball location.
-	// The circles form a trace.
-	GrCircleDraw(pContext, ball_x, ball_y, 1);
+	// On every call, draw a small circle on the new ball location, and
+	// a dot in the cell it left. The dots form a trace.
+	while ((rows.YSize = maze_view_render(&view, &maze, &y)) > 0) {
+		GrImageDraw(pContext, &rows, 0, y);
+	}
 	GrFlush(pContext);
 }
 
 /*
- * Handles the labyrinth. Uses accelerometer values (ax, ay) to
- * update the coordinates of the ball. Also checks if we have lost
- * or won the game based on the location of the ball.
+ * The velocity after a step: sped up by the tilt (cm/s^2), slowed down
+ * by the friction and limited to BALL_MAX.
+ */
+static int32_t accelerate(int32_t v, int16_t a) {
+	if (a > BALL_DEAD || a < -BALL_DEAD) {
+		v += a / (1 << BALL_GAIN);
+	} else if (v > -(1 << BALL_FRICTION) && v < (1 << BALL_FRICTION)) {
+		v = 0; // Too slow for the friction to take anything more: stopped.
+	}
+	v -= v / (1 << BALL_FRICTION);
+
+	if (v > BALL_MAX) return BALL_MAX;
+	if (v < -BALL_MAX) return -BALL_MAX;
+	return v;
+}
+
+/*
+ * The fixed-point coordinate to the block it is in.
+ */
+static int16_t block_of(int32_t coordinate) {
+	return (coordinate >> BALL_SHIFT) / MAZE_BLOCK;
+}
+
+/*
+ * Handles the labyrinth. Uses accelerometer values (ax, ay, in cm/s^2)
+ * to take a step of the ball physics. Also checks if we have lost or
+ * won the game based on the location of the ball.
+ *
+ * The ball has a fixed-point position and velocity: the tilt speeds it
+ * up and the friction slows it down, so it rolls on between the samples
+ * and creeps at a slight tilt. The step is swept: the blocks the ball
+ * passes on the way are checked, not only the one it ends up in, so it
+ * can't jump over a wall. Being under a block a step, it crosses at most
+ * one block edge along each axis; when it crosses both, the one it
+ * reaches first tells which block in between it passed. Each block is
+ * found directly from the position (maze_wall), so the step takes the
+ * same time whatever the size of the maze.
  *
  * Return values:
  *  0, lost the game.
  *  1, won the game!
  *  2, nothing special.
+ *  3, the ball stayed on the same pixel: nothing to draw.
  *
  */
-uint8_t handle_labyrinth(float ax, float ay) {
-	uint8_t i = 0;
-	uint8_t j = 0;
-
-	// Move the ball if enough movement was detected (over 0.5 m/s^2 in either direction).
-	if (abs(ax) > 0.5 || abs(ay) > 0.5) {
-		// However, move it only if we won't exceed the display bounds (0 and 96).
-		if (ball_x + ax > 0 && ball_x + ax < 96) {
-			ball_x = ball_x + ax;
-		}
-
-		if (ball_y + ay > 0 && ball_y + ay < 96) {
-			ball_y = ball_y + ay;
+uint8_t handle_labyrinth(int16_t ax, int16_t ay) {
+	int32_t x, y;
+	int16_t bx, by; // The block the ball was in...
+	int16_t nx, ny; // ...and the one it goes to.
+	int32_t to_x, to_y; // How far to the block edges crossed, along each axis.
+
+	if (clear) return 2; // The maze hasn't been initialized yet.
+
+	ball.vx = accelerate(ball.vx, ax);
+	ball.vy = accelerate(ball.vy, ay);
+	x = ball.x + ball.vx;
+	y = ball.y + ball.vy;
+
+	bx = block_of(ball.x);
+	by = block_of(ball.y);
+	nx = block_of(x);
+	ny = block_of(y);
+
+	if (nx != bx && ny != by) { // Over a corner: past the block beside first, or the one below or above?
+		to_x = ball.vx > 0 ? ((int32_t) nx * MAZE_BLOCK << BALL_SHIFT) - ball.x : ball.x - ((int32_t) bx * MAZE_BLOCK << BALL_SHIFT);
+		to_y = ball.vy > 0 ? ((int32_t) ny * MAZE_BLOCK << BALL_SHIFT) - ball.y : ball.y - ((int32_t) by * MAZE_BLOCK << BALL_SHIFT);
+
+		// The edge reached first has the smaller distance / |v| (compared multiplied out).
+		if ((int64_t) to_x * (ball.vy < 0 ? -ball.vy : ball.vy) < (int64_t) to_y * (ball.vx < 0 ? -ball.vx : ball.vx)
+				? maze_wall(&maze, nx, by) : maze_wall(&maze, bx, ny)) {
+			clear = 1; // Prepare for a new game.
+
+			return 0; // Lost the game on the way!
 		}
 	}
 
-	// Iterate through all the blocks.
-	for (i = 0; i < 6; i++) { // Yet another nested for-loop...
-		for (j = 0; j < 6; j++) {
-			if (blocks[i][j] == 0 && !clear) { // If the block is non-accessible and the maze has been initialized...
-				// ...check if the ball is in a non-accessible block.
-				if (ball_x < 16 * (i + 1) && ball_x > 16 * i && ball_y < 96 - 16 * j && ball_y > 96 - 16 * (j + 1)) {
-					ball_x = 8;
-					ball_y = 56;
-					clear = 1; // Prepare for a new game.
-
-					return 0; // Lost the game!
-				}
-			}
-		}
+	if (maze_wall(&maze, nx, ny)) { // The ball went into a wall...
+		clear = 1; // Prepare for a new game.
+
+		return 0; // Lost the game!
 	}
 
+	ball.x = x;
+	ball.y = y;
+
 	// Check if the ball is is in the winning block.
-	if (ball_x < 16 * (end_i + 1) && ball_x > 16 * end_i && ball_y < 96 - 16 * end_j && ball_y > 96 - 16 * (end_j + 1)) {
-		ball_x = 8;
-		ball_y = 56;
+	if (nx == 2 * maze.end_x + 1 && ny == 2 * maze.end_y + 1) {
 		clear = 1; // Prepare for a new game.
 
 		return 1; // Won the game!
 	}
 
+	if (ball_x == x >> BALL_SHIFT && ball_y == y >> BALL_SHIFT) return 3;
+
+	ball_x = x >> BALL_SHIFT;
+	ball_y = y >> BALL_SHIFT;
 	return 2; // If nothing special emerged, return 2.
 }
 
 /*
  * Determines the direction of the movement from
- * the x and y acceleration.
+ * the x and y acceleration. Only computes it: the sensorTask
+ * passes it on to uiTask, which calls set_direction.
  */
-void determine_direction(float ax, float ay) {
+uint8_t determine_direction(float ax, float ay) {
 	float angle = atan2(ay, -ax); // Determine the argument of the vector (-ax, ay).
 
 	// Divide the circle into 8 equal pieces.
 	// ...and determine the corresponding interval.
     if (angle < PI/8 && angle > -PI/8) {
-        dir = RIGHT;
+        return RIGHT;
     } else if (angle > PI/8 && angle < 3 * PI/8) {
-        dir = UPRIGHT;
+        return UPRIGHT;
     } else if (angle >= 3 * PI/8 && angle < 5 * PI/8) {
-        dir = UP;
+        return UP;
     } else if (angle >= 5 * PI/8 && angle < 7 * PI/8) {
-        dir = UPLEFT;
+        return UPLEFT;
     } else if (angle <= -PI/8 && angle > -3 * PI/8) {
-        dir = DOWNRIGHT;
+        return DOWNRIGHT;
     } else if (angle <= -3 * PI/8 && angle > -5 * PI/8) {
-        dir = DOWN;
+        return DOWN;
     } else if (angle <= -5 * PI/8 && angle > -7 * PI/8) {
-        dir = DOWNLEFT;
-    } else {
-        dir = LEFT;
+        return DOWNLEFT;
     }
+
+    return LEFT;
+}
+
+/*
+ * Sets the current direction.
+ */
+void set_direction(uint8_t direction) {
+	dir = (enum direction) direction;
 }
 
 /*
@@ -583,7 +605,7 @@ void empty_all() {
 }
 
 /*
- * Sends a message to the backend.
+ * Sends a message to the backend through the link layer (link.c).
  * Stores the directions in an array if not in win mode.
  */
 void send_message(uint8_t win) {
@@ -594,6 +616,8 @@ void send_message(uint8_t win) {
 	char msg_2[16];
 	memset(&msg_2[0], 0, sizeof(msg_2));
 
+	if (win == 0) session_move(dir); // Keep the history for the session upload.
+
 	switch (dir) {
 		case RIGHT:
 			strcat(msg_1, "RIGHT");
@@ -667,12 +691,12 @@ void send_message(uint8_t win) {
 			break;
 	}
 
-	Send6LoWPAN(IEEE80154_SERVER_ADDR, msg_1, strlen(msg_1)); // Send the first message.
-
-	Task_sleep(100000 / Clock_tickPeriod); // Err on the side of caution: sleep between messages.
+	// Queue the messages: the link layer sends them in order, one at a time,
+	// and resends them until the backend acknowledges.
+	link_send(msg_1); // Send the first message.
 
 	if (msg_2[0] == 'e') {
-		Send6LoWPAN(IEEE80154_SERVER_ADDR, msg_2, strlen(msg_2)); // Send the second message if present.
+		link_send(msg_2); // Send the second message if present.
 	}
 
 	if (win == 0) index++; // If not in WIN mode, increment the index.
@@ -0,0 +1,481 @@
+'''
+A local stand-in for the TRON game backend.
+
+Listens for the UDP frames of the host comm_lib shim (host/comm_lib.c),
+plays the game for every player and answers "<addr>,WIN" or
+"<addr>,LOST GAME" just like the course gateway. Records the service
+latency of every message and the throughput so that protocol changes
+can be load-tested locally.
+
+Events may carry a sequence number ("event:LEFT#12", see link.c). Those
+are acknowledged with "<addr>,ACK,12" and applied only once, however
+many times they are retransmitted; a retransmitted move that ended the
+game gets its result again, in case that was lost along with the ACK.
+--loss drops frames in both directions to test the retransmissions.
+
+After every game the device uploads the session history in fragments
+("sess:<id>,<n>/<count>,<base64>", see session.c). They are reassembled
+per player, the CRC and the move records are checked, and the decoded
+sessions can be written out with --sessions.
+
+Devices also send their input-to-display latency histogram now and
+then ("lat:" and two hex digits of new counts per bucket, see
+latency.c); the counts of every device are added up.
+
+Usage:
+    python3 Backend_server.py serve [--port 15154] [--grid 20] [--win-moves 30] [--sessions out.jsonl]
+    python3 Backend_server.py load --clients 100 --rate 10 --duration 10
+
+Frame format (both directions): 2 bytes of 6LoWPAN address
+(little-endian) followed by the ASCII payload.
+'''
+
+import argparse
+import base64
+import binascii
+import collections
+import json
+import random
+import select
+import signal
+import socket
+import struct
+import sys
+import time
+
+DEFAULT_PORT = 15154
+SERVER_ADDR = 0x1234
+
+# Unit steps for the directions in the "event:<DIR>" frames.
+STEPS = {"UP": (0, 1), "DOWN": (0, -1), "LEFT": (-1, 0), "RIGHT": (1, 0)}
+
+# enum direction in game.c and the outcomes in session.h.
+DIRECTIONS = ["DOWN", "DOWNRIGHT", "RIGHT", "UPRIGHT", "UP", "UPLEFT", "LEFT", "DOWNLEFT"]
+OUTCOMES = {1: "WIN", 2: "LOST", 3: "QUIT"}
+SESSION_VERSION = 1
+LATENCY_BUCKETS = 12 # latency.h: under 1 ms, then up to 2, 4, ... 1024 ms and more.
+SESSION_TRUNCATED = 0x80
+
+
+def percentile(values, p):
+    ''' Nearest-rank percentile of an already sorted list. '''
+    if not values:
+        return 0.0
+    k = max(0, min(len(values) - 1, int(round(p / 100.0 * len(values) + 0.5)) - 1))
+    return values[k]
+
+
+def decode_session(record):
+    '''
+    Decodes and verifies a session record (see session.c). Returns a dict,
+    raises ValueError if the record is damaged.
+    '''
+    if len(record) < 7:
+        raise ValueError("short record")
+    if binascii.crc_hqx(record[:-2], 0xFFFF) != struct.unpack("<H", record[-2:])[0]:
+        raise ValueError("bad CRC")
+
+    version, outcome, count, duration = struct.unpack("<BBBH", record[:5])
+    if version != SESSION_VERSION or (outcome & ~SESSION_TRUNCATED) not in OUTCOMES:
+        raise ValueError("bad header")
+
+    moves = []
+    t = 0
+    i = 5
+    body = record[:-2]
+
+    for _ in range(count):
+        if i >= len(body):
+            raise ValueError("moves missing")
+        packed = body[i]
+        i += 1
+
+        delta = shift = 0
+        while True: # Base-128 varint, lowest seven bits first.
+            if i >= len(body):
+                raise ValueError("moves missing")
+            delta |= (body[i] & 0x7F) << shift
+            shift += 7
+            i += 1
+            if not body[i - 1] & 0x80:
+                break
+
+        t += delta
+        moves.append({"dir": DIRECTIONS[packed & 0x07], "confidence": packed >> 3, "t": t / 10.0})
+
+    if i != len(body):
+        raise ValueError("trailing bytes")
+    if t > duration:
+        raise ValueError("moves after the end")
+
+    return {"outcome": OUTCOMES[outcome & ~SESSION_TRUNCATED], "truncated": bool(outcome & SESSION_TRUNCATED),
+            "duration": duration / 10.0, "moves": moves}
+
+
+class Player:
+    ''' One light-cycle on its own grid. '''
+
+    def __init__(self, grid):
+        self.grid = grid
+        self.seen = collections.deque(maxlen=64) # Recent sequence numbers.
+        self.result = None # (seq, reply) of the last move that ended a game.
+        self.upload_id = None # Session being reassembled...
+        self.fragments = {} # ...fragment number -> base64 text.
+        self.reset()
+
+    def reset(self):
+        self.x = self.y = self.grid // 2 # Start from the middle...
+        self.trail = {(self.x, self.y)} # ...with only the start cell lit.
+        self.moves = 0
+
+    def move(self, direction, win_moves):
+        '''
+        Moves one cell. Returns "WIN", "LOST GAME" or None if the game
+        goes on. The player is reset after either result.
+        '''
+        dx, dy = STEPS[direction]
+        self.x += dx
+        self.y += dy
+        self.moves += 1
+
+        out = not (0 <= self.x < self.grid and 0 <= self.y < self.grid)
+
+        if out or (self.x, self.y) in self.trail: # Hit the wall or a trail.
+            self.reset()
+            return "LOST GAME"
+
+        self.trail.add((self.x, self.y))
+
+        if self.moves >= win_moves: # Survived long enough!
+            self.reset()
+            return "WIN"
+
+        return None
+
+
+class Stats:
+    ''' Per-message latency and throughput bookkeeping. '''
+
+    def __init__(self):
+        self.started = time.monotonic()
+        self.frames = 0
+        self.bytes = 0
+        self.replies = 0
+        self.errors = 0
+        self.acks = 0
+        self.duplicates = 0
+        self.lost = 0 # Frames dropped by --loss, in either direction.
+        self.sessions = 0 # Session uploads reassembled and verified...
+        self.sessions_bad = 0 # ...failed verification or never completed.
+        self.latency = [0] * LATENCY_BUCKETS # Input-to-display histogram of all devices.
+        self.latencies = [] # Service latency (s) of every frame.
+        self.window_start = self.started
+        self.window_frames = 0
+        self.peak_rate = 0.0
+
+    def record(self, size, latency):
+        self.frames += 1
+        self.bytes += size
+        self.window_frames += 1
+        self.latencies.append(latency)
+
+    def tick(self, now):
+        ''' Closes the current one-second window and returns its rate. '''
+        rate = self.window_frames / max(now - self.window_start, 1e-9)
+        self.peak_rate = max(self.peak_rate, rate)
+        self.window_start = now
+        self.window_frames = 0
+        return rate
+
+    def summary(self):
+        elapsed = max(time.monotonic() - self.started, 1e-9)
+        lat = sorted(self.latencies)
+        us = lambda s: s * 1e6
+
+        return ("frames %d (%d B), replies %d, errors %d, acks %d, duplicates %d, lost %d, sessions %d (%d bad)\n"
+                "%.1f msg/s avg, %.1f msg/s peak, cpu %.2f s (%.1f%%)\n"
+                "service latency us: p50 %.1f  p95 %.1f  p99 %.1f  max %.1f\n"
+                "device input-to-display histogram: %s"
+                % (self.frames, self.bytes, self.replies, self.errors,
+                   self.acks, self.duplicates, self.lost, self.sessions, self.sessions_bad,
+                   self.frames / elapsed, self.peak_rate,
+                   time.process_time(), 100.0 * time.process_time() / elapsed,
+                   us(percentile(lat, 50)), us(percentile(lat, 95)),
+                   us(percentile(lat, 99)), us(lat[-1] if lat else 0),
+                   " ".join(str(n) for n in self.latency)))
+
+    def as_dict(self):
+        elapsed = max(time.monotonic() - self.started, 1e-9)
+        lat = sorted(self.latencies)
+
+        return {"elapsed_s": elapsed, "frames": self.frames, "bytes": self.bytes,
+                "replies": self.replies, "errors": self.errors,
+                "acks": self.acks, "duplicates": self.duplicates, "lost": self.lost,
+                "sessions": self.sessions, "sessions_bad": self.sessions_bad,
+                "latency_histogram": self.latency,
+                "cpu_s": time.process_time(), "peak_rate": self.peak_rate,
+                "service_p50_us": percentile(lat, 50) * 1e6,
+                "service_p99_us": percentile(lat, 99) * 1e6}
+
+
+class Backend:
+    ''' The game server: one Player per UDP peer. '''
+
+    def __init__(self, args):
+        self.args = args
+        self.players = {}
+        self.stats = Stats()
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 22)
+        self.sock.bind((args.host, args.port))
+        self.log = open(args.log, "w") if args.log else None
+        self.sessions = open(args.sessions, "w") if args.sessions else None
+
+    def reply(self, peer, addr, text):
+        if random.random() < self.args.loss:
+            self.stats.lost += 1
+            return
+        self.sock.sendto(struct.pack("<H", addr) + text.encode(), peer)
+        self.stats.replies += 1
+
+    def handle(self, data, peer):
+        ''' Handles one frame. Returns the reply text or None. '''
+        if len(data) < 2:
+            self.stats.errors += 1
+            return None
+
+        addr = struct.unpack("<H", data[:2])[0]
+        payload = data[2:].decode(errors="replace")
+        payload, _, seq = payload.partition("#")
+        upload = payload.startswith("sess:")
+        histogram = payload.startswith("lat:")
+
+        if not (upload or histogram or payload.startswith("event:") and payload[6:] in STEPS) or (seq and not seq.isdigit()):
+            self.stats.errors += 1
+            return None
+
+        player = self.players.get(peer)
+        if player is None:
+            player = self.players[peer] = Player(self.args.grid)
+
+        if seq:
+            self.stats.acks += 1
+            self.reply(peer, SERVER_ADDR, "%d,ACK,%s" % (addr, seq))
+
+            if int(seq) in player.seen: # A retransmission: already applied.
+                self.stats.duplicates += 1
+                if player.result and player.result[0] == int(seq): # The result may have been lost with the ACK.
+                    self.reply(peer, SERVER_ADDR, player.result[1])
+                    return player.result[1]
+                return None
+
+            player.seen.append(int(seq))
+
+        if upload:
+            self.upload(player, addr, payload[5:])
+            return None
+
+        if histogram:
+            self.histogram(payload[4:])
+            return None
+
+        result = player.move(payload[6:], self.args.win_moves)
+
+        if result is not None:
+            text = "%d,%s" % (addr, result)
+            if seq:
+                player.result = (int(seq), text)
+            self.reply(peer, SERVER_ADDR, text)
+            return text
+
+        return None
+
+    def upload(self, player, addr, text):
+        ''' Collects a session fragment; decodes the session once complete. '''
+        try:
+            sid, part, data = text.split(",", 2)
+            n, count = (int(x) for x in part.split("/"))
+        except ValueError:
+            self.stats.errors += 1
+            return
+
+        if sid != player.upload_id: # A new session: the last one never completed.
+            if player.fragments:
+                self.stats.sessions_bad += 1
+            player.upload_id = sid
+            player.fragments = {}
+
+        player.fragments[n] = data
+
+        if len(player.fragments) < count:
+            return
+
+        try:
+            record = base64.b64decode("".join(player.fragments[i] for i in range(1, count + 1)), validate=True)
+            session = decode_session(record)
+        except (KeyError, ValueError, binascii.Error):
+            self.stats.sessions_bad += 1
+        else:
+            self.stats.sessions += 1
+            session.update(addr=addr, id=int(sid), bytes=len(record), fragments=count)
+
+            if self.sessions:
+                self.sessions.write(json.dumps(session) + "\n")
+            if not self.args.quiet:
+                print("[backend] session %s from %d: %s after %.1f s, %d moves in %d B"
+                      % (sid, addr, session["outcome"], session["duration"], len(session["moves"]), len(record)),
+                      flush=True)
+
+        player.fragments = {}
+
+    def histogram(self, text):
+        ''' Adds the new counts of a device to the latency histogram. '''
+        try:
+            if len(text) != 2 * LATENCY_BUCKETS:
+                raise ValueError(text)
+            counts = [int(text[2 * i:2 * i + 2], 16) for i in range(LATENCY_BUCKETS)]
+        except ValueError:
+            self.stats.errors += 1
+            return
+
+        self.stats.latency = [a + b for a, b in zip(self.stats.latency, counts)]
+
+    def serve(self, duration=None):
+        now = time.monotonic()
+        deadline = now + duration if duration else None
+        next_report = now + self.args.report
+
+        while deadline is None or now < deadline:
+            ready, _, _ = select.select([self.sock], [], [], 0.05)
+
+            if ready:
+                data, peer = self.sock.recvfrom(256)
+
+                if random.random() < self.args.loss:
+                    self.stats.lost += 1
+                    continue
+
+                t0 = time.perf_counter()
+                text = self.handle(data, peer)
+                latency = time.perf_counter() - t0
+                self.stats.record(len(data), latency)
+
+                if self.log:
+                    self.log.write("%.6f,%s:%d,%r,%r,%.1f\n" % (time.time(), peer[0], peer[1],
+                                   data[2:].decode(errors="replace"), text, latency * 1e6))
+
+            now = time.monotonic()
+
+            if now >= next_report:
+                rate = self.stats.tick(now)
+                if not self.args.quiet:
+                    print("[backend] %d players, %.1f msg/s, %d frames"
+                          % (len(self.players), rate, self.stats.frames), flush=True)
+                next_report = now + self.args.report
+
+        self.finish()
+
+    def finish(self):
+        print("[backend] " + self.stats.summary(), flush=True)
+        if self.log:
+            self.log.close()
+        if self.sessions:
+            self.sessions.close()
+        if self.args.stats_json:
+            with open(self.args.stats_json, "w") as f:
+                json.dump(self.stats.as_dict(), f)
+
+
+def load(args):
+    '''
+    Load generator: many fake devices sending random moves at a fixed rate.
+    Measures the round trip from the move that ended a game to its result.
+    '''
+    socks = []
+    for _ in range(args.clients):
+        s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        s.setblocking(False)
+        s.connect((args.host, args.port))
+        socks.append(s)
+
+    by_fd = {s.fileno(): i for i, s in enumerate(socks)}
+    last_sent = [0.0] * args.clients
+    rtts = []
+    sent = results = 0
+    period = 1.0 / args.rate
+    next_send = [time.monotonic() + random.random() * period for _ in socks]
+    end = time.monotonic() + args.duration
+
+    while time.monotonic() < end:
+        now = time.monotonic()
+
+        for i, s in enumerate(socks):
+            if now >= next_send[i]:
+                frame = struct.pack("<H", args.addr) + ("event:" + random.choice(list(STEPS))).encode()
+                s.send(frame)
+                last_sent[i] = time.perf_counter()
+                next_send[i] += period
+                sent += 1
+
+        timeout = max(0.0, min(next_send) - time.monotonic())
+        ready, _, _ = select.select(socks, [], [], timeout)
+
+        for s in ready:
+            try:
+                s.recv(256)
+            except OSError:
+                continue
+            results += 1
+            rtts.append(time.perf_counter() - last_sent[by_fd[s.fileno()]])
+
+    rtts.sort()
+    print("[load] %d clients, sent %d frames (%.1f msg/s), %d results" %
+          (args.clients, sent, sent / args.duration, results))
+    print("[load] result round trip us: p50 %.1f  p95 %.1f  p99 %.1f" %
+          (percentile(rtts, 50) * 1e6, percentile(rtts, 95) * 1e6, percentile(rtts, 99) * 1e6))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Stand-in TRON backend")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    serve = sub.add_parser("serve", help="run the backend")
+    serve.add_argument("--host", default="127.0.0.1")
+    serve.add_argument("--port", type=int, default=DEFAULT_PORT)
+    serve.add_argument("--grid", type=int, default=20, help="arena size in cells")
+    serve.add_argument("--win-moves", type=int, default=30, help="moves survived to win")
+    serve.add_argument("--duration", type=float, default=None, help="stop after N seconds")
+    serve.add_argument("--report", type=float, default=1.0, help="report interval (s)")
+    serve.add_argument("--log", default=None, help="CSV log of every frame")
+    serve.add_argument("--stats-json", default=None, help="write the final statistics here")
+    serve.add_argument("--sessions", default=None, help="JSON lines of the uploaded sessions")
+    serve.add_argument("--loss", type=float, default=0.0, help="drop probability per frame")
+    serve.add_argument("--seed", type=int, default=None, help="seed for --loss")
+    serve.add_argument("--quiet", action="store_true")
+
+    gen = sub.add_parser("load", help="generate load against a running backend")
+    gen.add_argument("--host", default="127.0.0.1")
+    gen.add_argument("--port", type=int, default=DEFAULT_PORT)
+    gen.add_argument("--clients", type=int, default=10)
+    gen.add_argument("--rate", type=float, default=10.0, help="frames/s per client")
+    gen.add_argument("--duration", type=float, default=5.0)
+    gen.add_argument("--addr", type=int, default=251)
+
+    args = parser.parse_args()
+
+    if args.cmd == "load":
+        load(args)
+        return
+
+    random.seed(args.seed)
+    backend = Backend(args)
+    signal.signal(signal.SIGTERM, lambda *_: sys.exit(0))
+
+    try:
+        backend.serve(args.duration)
+    except (KeyboardInterrupt, SystemExit):
+        backend.finish()
+
+
+if __name__ == "__main__":
+    main()
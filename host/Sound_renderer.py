@@ -0,0 +1,241 @@
+'''
+Renders what the buzzer plays to a WAV file, and checks the timing of
+the sounds against stored golden timelines.
+
+A sound is run on a simulated device (see host/rtos.c for the build
+line) in virtual time, with the buttons pressed to bring it on, and the
+host buzzer writes its timeline (SIM_BUZZER, host/drivers.c): the time
+of every tone set and when it is closed. The timeline is rendered as a
+square wave, the way the buzzer sounds, far faster than real time.
+
+The sounds are the songs of the library (songs.c, by their name there:
+pelimies, sexbomb, ...), "win" (the winning move and the song after it),
+"illegal" (a losing move) and "arrows" (the beep of a chosen direction).
+
+The golden timelines are in host/golden/<sound>.timeline, with the
+times counted from the first tone. "check" runs every sound (or the
+ones given) and compares: any tone at another time or frequency is a
+regression in the music engine, or in what drives it. After a change
+meant to alter the sounds, "check --update" stores the new timelines.
+
+Usage:
+    python3 Sound_renderer.py --binary ./sim_device render pelimies -o pelimies.wav
+    python3 Sound_renderer.py render timeline.txt -o out.wav
+    python3 Sound_renderer.py --binary ./sim_device check [--update] [sound ...]
+'''
+
+import argparse
+import os
+import re
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+import wave
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(HERE)
+GOLDEN = os.path.join(HERE, "golden")
+
+BOOT = "0 mpu 0 0 -1 0 0 0\n"
+MOVE = BOOT + "400 press 1 250\n1000 press 1 250\n" # GAME from the menu, then a random move.
+
+# Sound: (input script, environment, seconds of device time).
+SOUNDS = {
+    "arrows": (MOVE, {}, 3),
+    "illegal": (MOVE, {"SIM_GRID": "1"}, 8), # No room: the first move loses.
+    "win": (MOVE, {"SIM_WIN_MOVES": "1"}, 25), # The first move wins.
+}
+
+RATE = 22050
+AMPLITUDE = 8000
+
+
+def songs():
+    ''' The names of the songs in song_library (songs.c), in order. '''
+    with open(os.path.join(ROOT, "songs.c"), encoding="latin-1") as f:
+        library = re.search(r"song_library\[\] = \{(.*?)\};", f.read(), re.S).group(1)
+
+    return re.findall(r'\{"[^"]*", (\w+),', library)
+
+
+def scenario(sound):
+    ''' The input script, environment and duration that play the sound. '''
+    if sound in SOUNDS:
+        return SOUNDS[sound]
+
+    library = songs()
+    if sound not in library:
+        raise SystemExit("unknown sound %s: one of %s" % (sound, ", ".join(sorted(SOUNDS) + library)))
+
+    # Karaoke in the menu, then down the list of songs to this one.
+    script = BOOT + "400 press 0 250\n1000 press 0 250\n1600 press 1 250\n"
+    at = 2200
+    for _ in range(library.index(sound)):
+        script += "%d press 0 250\n" % at
+        at += 600
+    script += "%d press 1 250\n" % at
+
+    return script, {}, 150
+
+
+def record(binary, sound):
+    ''' Runs the sound on a simulated device: its timeline, from the first tone. '''
+    script, env, duration = scenario(sound)
+
+    with tempfile.TemporaryDirectory() as tmp:
+        trace = os.path.join(tmp, "sound.trace")
+        timeline = os.path.join(tmp, "sound.timeline")
+        with open(trace, "w") as f:
+            f.write(script)
+
+        env = dict(os.environ, SIM_VIRTUAL="1", SIM_JITTER="0", SIM_TRACE=trace, SIM_BUZZER=timeline,
+                   SIM_DURATION=str(duration), **env)
+        subprocess.run([binary], env=env, stdout=subprocess.DEVNULL, check=True)
+
+        events = read_timeline(timeline)
+
+    if not events:
+        raise SystemExit("%s: the buzzer stayed quiet" % sound)
+
+    start = events[0][0]
+    return [(us - start, hz) for us, hz in events]
+
+
+def read_timeline(path):
+    events = []
+    with open(path) as f:
+        for line in f:
+            line = line.split("#")[0].split()
+            if line:
+                events.append((int(line[0]), int(line[1])))
+    return events
+
+
+def write_timeline(path, sound, events):
+    with open(path, "w") as f:
+        f.write("# %s: microseconds from the first tone, Hz (0: closed)\n" % sound)
+        for us, hz in events:
+            f.write("%d %d\n" % (us, hz))
+
+
+def render(events, path, rate=RATE):
+    ''' Writes the timeline as a square wave: returns the seconds of sound. '''
+    high = struct.pack("<h", AMPLITUDE)
+    low = struct.pack("<h", -AMPLITUDE)
+    quiet = struct.pack("<h", 0)
+    chunks = []
+    written = 0 # Samples.
+
+    for (us, hz), (end, _) in zip(events, events[1:] + [(events[-1][0] + 500000, 0)]):
+        first = us * rate // 1000000
+        last = end * rate // 1000000
+
+        if first > written: # A gap before the tone.
+            chunks.append(quiet * (first - written))
+            written = first
+        if hz == 0 or last <= written:
+            continue
+
+        # Half periods, rounded to whole samples without drifting.
+        half = rate / (2.0 * hz)
+        count = last - written
+        edge = 0
+        level = 0
+        while edge < count:
+            following = min(count, int(round((level + 1) * half)))
+            chunks.append((high if level % 2 == 0 else low) * max(following - edge, 0))
+            edge = max(edge, following)
+            level += 1
+        written = last
+
+    with wave.open(path, "wb") as out:
+        out.setnchannels(1)
+        out.setsampwidth(2)
+        out.setframerate(rate)
+        out.writeframes(b"".join(chunks))
+
+    return written / rate
+
+
+def compare(golden, events):
+    ''' The differences between two timelines, as lines to print. '''
+    problems = []
+
+    for i, (want, got) in enumerate(zip(golden, events)):
+        if want != got:
+            problems.append("tone %d: %d Hz at %.3f s, was %d Hz at %.3f s"
+                            % (i, got[1], got[0] / 1e6, want[1], want[0] / 1e6))
+            if len(problems) == 5:
+                break
+
+    if len(golden) != len(events):
+        problems.append("%d tones, were %d; %.3f s long, was %.3f s"
+                        % (len(events), len(golden), events[-1][0] / 1e6, golden[-1][0] / 1e6))
+
+    return problems
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Buzzer sound renderer and timing check")
+    parser.add_argument("--binary", default="./sim_device")
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    render_parser = commands.add_parser("render", help="render a sound, or a timeline file, to WAV")
+    render_parser.add_argument("sound")
+    render_parser.add_argument("-o", "--output", help="the WAV file (default <sound>.wav)")
+    render_parser.add_argument("--timeline", help="also write the timeline here")
+    render_parser.add_argument("--rate", type=int, default=RATE)
+
+    check_parser = commands.add_parser("check", help="compare the sounds with the golden timelines")
+    check_parser.add_argument("sounds", nargs="*")
+    check_parser.add_argument("--update", action="store_true", help="store the timelines as the golden ones")
+
+    args = parser.parse_args()
+
+    if args.command == "render":
+        began = time.perf_counter()
+        if os.path.exists(args.sound):
+            events = read_timeline(args.sound)
+            name = os.path.splitext(os.path.basename(args.sound))[0]
+        else:
+            events = record(args.binary, args.sound)
+            name = args.sound
+        if args.timeline:
+            write_timeline(args.timeline, name, events)
+
+        output = args.output or name + ".wav"
+        seconds = render(events, output, args.rate)
+        took = time.perf_counter() - began
+        print("%s: %d tones, %.1f s of sound in %.2f s (%.0fx real time)"
+              % (output, len(events), seconds, took, seconds / took if took else 0))
+        return
+
+    failed = 0
+    for sound in args.sounds or sorted(SOUNDS) + songs():
+        events = record(args.binary, sound)
+        path = os.path.join(GOLDEN, sound + ".timeline")
+
+        if args.update:
+            os.makedirs(GOLDEN, exist_ok=True)
+            write_timeline(path, sound, events)
+            print("%-10s %d tones stored" % (sound, len(events)))
+            continue
+
+        if not os.path.exists(path):
+            print("%-10s no golden timeline (check --update)" % sound)
+            failed += 1
+            continue
+
+        problems = compare(read_timeline(path), events)
+        print("%-10s %s" % (sound, "FAIL" if problems else "ok (%d tones)" % len(events)))
+        for problem in problems:
+            print("    " + problem)
+        failed += bool(problems)
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,301 @@
+'''
+Runs many simulated SensorTags against one local backend stand-in.
+
+Every device is a sim_device process (see host/rtos.c for the build
+line) running the real firmware tasks, fed from a recorded input trace.
+The firmware keeps its state in globals, so a process per device is how
+the tasks of each SensorTag get their own copy; inside a device the
+tasks and clocks are threads.
+
+Reports, for all the devices together:
+ - the message rate, the frame loss in both directions, the tail
+   latency of the backend replies and the CPU used by the backend;
+ - the goodput and delivery latency of the link layer (link.c) and
+   the session uploads (session.c);
+ - the mailbox latency of uiTask (events.c);
+ - the button and gesture latency (input.c) and the input-to-display
+   latency histogram (latency.c), as the devices report it and as the
+   backend received it;
+ - the receiver duty cycle per program state (radio.c) and the
+   wakeups and estimated current per state (power.c);
+ - the overhead of the timer wheel (timer.c);
+ - the timing of the music (music.c);
+ - the CPU share, switch rate and deepest stack of each task
+   (monitor.c).
+
+Pass --backend-args "--loss 0.2" to run it over a lossy link.
+
+Usage:
+    python3 Swarm.py --binary ./sim_device --devices 200 --duration 20 \
+        --trace traces/game_buttons.trace
+'''
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+# enum state in main.c, indexed by value.
+STATES = ["-", "MENU", "KARAOKE", "GAME", "CLOCK", "MAZE", "SLIDESHOW",
+          "SHUTDOWN", "WAIT", "ILLEGAL_MOVE", "WIN", "REVERSE", "MONITOR", "SONGS"]
+
+
+def percentile(values, p):
+    ''' Nearest-rank percentile of an already sorted list. '''
+    if not values:
+        return 0.0
+    k = max(0, min(len(values) - 1, int(round(p / 100.0 * len(values) + 0.5)) - 1))
+    return values[k]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Multi-device SensorTag simulator")
+    parser.add_argument("--binary", default="./sim_device")
+    parser.add_argument("--devices", type=int, default=50)
+    parser.add_argument("--duration", type=float, default=10.0, help="device run time (s)")
+    parser.add_argument("--trace", default=os.path.join(HERE, "traces", "game_buttons.trace"))
+    parser.add_argument("--port", type=int, default=15154)
+    parser.add_argument("--jitter", type=int, default=200, help="per-event trace jitter (ms)")
+    parser.add_argument("--backend-args", default="", help="extra arguments for Backend_server.py")
+    parser.add_argument("--json", default=None, help="write the aggregate report here")
+    args = parser.parse_args()
+
+    stats_path = tempfile.mktemp(suffix=".json")
+
+    # The backend outlives the devices a little so that the last frames are counted.
+    backend = subprocess.Popen([sys.executable, os.path.join(HERE, "Backend_server.py"), "serve",
+                                "--port", str(args.port), "--quiet",
+                                "--duration", str(args.duration + 2),
+                                "--stats-json", stats_path] + args.backend_args.split())
+    time.sleep(0.5)
+
+    devices = []
+    for i in range(args.devices):
+        env = dict(os.environ, SIM_SERVER="127.0.0.1:%d" % args.port, SIM_TRACE=args.trace,
+                   SIM_DURATION=str(args.duration), SIM_SEED=str(i + 1), SIM_JITTER=str(args.jitter))
+        devices.append(subprocess.Popen([args.binary], env=env, stdout=subprocess.PIPE, text=True))
+
+    reports = []
+    for dev in devices:
+        out, _ = dev.communicate()
+        for line in out.splitlines():
+            if line.startswith("SIMSTATS "):
+                reports.append(json.loads(line[9:]))
+
+    backend.wait()
+    with open(stats_path) as f:
+        server = json.load(f)
+    os.unlink(stats_path)
+
+    tx = sum(r["tx"] for r in reports)
+    rx = sum(r["rx"] for r in reports)
+    rtts = sorted(v for r in reports for v in r["rtt_us"])
+    uplink_loss = 1.0 - server["frames"] / tx if tx else 0.0
+    downlink_loss = 1.0 - rx / server["replies"] if server["replies"] else 0.0
+
+    result = {
+        "devices": len(reports),
+        "duration_s": args.duration,
+        "tx_frames": tx,
+        "msg_rate": tx / args.duration,
+        "backend_frames": server["frames"],
+        "uplink_loss": uplink_loss,
+        "backend_replies": server["replies"],
+        "rx_frames": rx,
+        "downlink_loss": downlink_loss,
+        "reply_p50_us": percentile(rtts, 50),
+        "reply_p99_us": percentile(rtts, 99),
+        "reply_p999_us": percentile(rtts, 99.9),
+        "reply_max_us": rtts[-1] if rtts else 0,
+        "backend_cpu_s": server["cpu_s"],
+        "backend_cpu_pct": 100.0 * server["cpu_s"] / server["elapsed_s"],
+        "backend_service_p99_us": server["service_p99_us"],
+    }
+
+    print("%d devices for %.0f s: %d frames sent, %.1f msg/s aggregate"
+          % (result["devices"], args.duration, tx, result["msg_rate"]))
+    print("uplink loss %.2f%% (%d received by backend), downlink loss %.2f%% (%d of %d replies received)"
+          % (100 * uplink_loss, server["frames"], 100 * downlink_loss, rx, server["replies"]))
+    print("reply latency us: p50 %.0f  p99 %.0f  p99.9 %.0f  max %.0f"
+          % (result["reply_p50_us"], result["reply_p99_us"], result["reply_p999_us"], result["reply_max_us"]))
+    print("backend cpu %.2f s (%.1f%%), service p99 %.1f us"
+          % (server["cpu_s"], result["backend_cpu_pct"], server["service_p99_us"]))
+
+    links = [r["link"] for r in reports if "link" in r]
+
+    if links:
+        total = lambda key: sum(l[key] for l in links)
+        delivered = total("delivered")
+        transmissions = total("transmissions")
+
+        result["link"] = {key: total(key) for key in links[0] if key != "latency_ms_max"}
+        result["link"]["latency_ms_max"] = max(l["latency_ms_max"] for l in links)
+        result["goodput"] = delivered / args.duration
+
+        print("link: %d events queued, %d delivered (%.1f events/s goodput), %d failed, %d dropped"
+              % (total("queued"), delivered, result["goodput"], total("failed"), total("dropped")))
+        print("link: %d transmissions for %d deliveries (%.2f per event), %d retransmissions"
+              % (transmissions, delivered, transmissions / max(delivered, 1), total("retransmissions")))
+        print("link: delivery latency avg %.0f ms, max %d ms"
+              % (total("latency_ms_sum") / max(delivered, 1), result["link"]["latency_ms_max"]))
+
+    sessions = [r["session"] for r in reports if "session" in r]
+
+    if sessions:
+        total = lambda key: sum(s[key] for s in sessions)
+        result["session"] = {key: total(key) for key in sessions[0]}
+        result["session"]["verified"] = server.get("sessions", 0)
+
+        print("session: %d finished, %d uploaded in %d fragments (%d B), %d verified by the backend, %d bad"
+              % (total("sessions"), total("uploaded"), total("fragments"), total("bytes"),
+                 server.get("sessions", 0), server.get("sessions_bad", 0)))
+
+    events = [r["events"] for r in reports if "events" in r]
+
+    if events:
+        total = lambda key: sum(e[key] for e in events)
+        result["events"] = {key: total(key) for key in events[0] if key != "latency_us_max"}
+        result["events"]["latency_us_max"] = max(e["latency_us_max"] for e in events)
+
+        print("events: %d posted to uiTask, %d dropped, %d stale, latency avg %.0f us, max %d us"
+              % (total("posted"), total("dropped"), total("stale"),
+                 total("latency_us_sum") / max(total("posted"), 1), result["events"]["latency_us_max"]))
+
+    inputs = [r["input"] for r in reports if "input" in r]
+
+    if inputs:
+        total = lambda key: sum(sum(i[key]) if isinstance(i[key], list) else i[key] for i in inputs)
+        result["input"] = {key: total(key) for key in inputs[0] if not key.endswith("_max")}
+        result["input"]["button_us_max"] = max(i["button_us_max"] for i in inputs)
+        result["input"]["motion_us_max"] = max(i["motion_us_max"] for i in inputs)
+        buttons = total("presses") + total("releases") + total("long_presses") + total("repeats")
+
+        print("input: %d presses, %d long, %d repeats, %d bounces filtered, %d gestures, %d dropped"
+              % (total("presses"), total("long_presses"), total("repeats"), total("bounces"),
+                 total("gestures"), total("dropped")))
+        print("input: button to uiTask avg %.1f ms, max %.1f ms; gesture avg %.1f ms, max %.1f ms"
+              % (total("button_us_sum") / max(buttons, 1) / 1000.0, result["input"]["button_us_max"] / 1000.0,
+                 total("motion_us_sum") / max(total("gestures"), 1) / 1000.0,
+                 result["input"]["motion_us_max"] / 1000.0))
+
+    latencies = [r["latency"] for r in reports if "latency" in r]
+
+    if latencies:
+        total = lambda key: sum(l[key] for l in latencies)
+        histogram = [sum(l["histogram"][i] for l in latencies) for i in range(len(latencies[0]["histogram"]))]
+        samples = max(total("samples"), 1)
+        result["latency"] = {key: total(key) for key in latencies[0] if key not in ("histogram", "total_us_max")}
+        result["latency"].update(histogram=histogram, total_us_max=max(l["total_us_max"] for l in latencies),
+                                 backend_histogram=server.get("latency_histogram"))
+
+        # Bucket i holds up to 2^i ms: the percentile is the bucket's upper bound.
+        def bucket_percentile(p):
+            seen = 0
+            for i, n in enumerate(histogram):
+                seen += n
+                if seen >= p / 100.0 * samples:
+                    return 2 ** i
+            return 2 ** len(histogram)
+
+        print("latency: %d inputs to the screen, p50 < %d ms, p99 < %d ms, max %.1f ms"
+              % (total("samples"), bucket_percentile(50), bucket_percentile(99),
+                 result["latency"]["total_us_max"] / 1000.0))
+        print("latency: avg %.1f ms to the handler, %.1f ms to the drawing, %.1f ms drawing"
+              % (total("queue_us_sum") / samples / 1000.0, total("wait_us_sum") / samples / 1000.0,
+                 total("draw_us_sum") / samples / 1000.0))
+        print("latency: histogram %s on the devices, %s at the backend (%d dumps)"
+              % (" ".join(str(n) for n in histogram),
+                 " ".join(str(n) for n in server.get("latency_histogram", [])), total("dumps")))
+
+    radios = [r["radio"] for r in reports if "radio" in r]
+
+    if radios:
+        result["radio"] = {}
+        on_total = sum(sum(r["rx_on_ms"]) for r in radios)
+        state_total = sum(sum(r["state_ms"]) for r in radios)
+
+        for i, name in enumerate(STATES):
+            state_ms = sum(r["state_ms"][i] for r in radios)
+            rx_on_ms = sum(r["rx_on_ms"][i] for r in radios)
+            if state_ms == 0:
+                continue
+
+            result["radio"][name] = {"state_ms": state_ms, "rx_on_ms": rx_on_ms,
+                                     "tx_frames": sum(r["tx_frames"][i] for r in radios)}
+            print("radio: %-12s rx on %5.1f%% of %d ms" % (name, 100.0 * rx_on_ms / state_ms, state_ms))
+
+        print("radio: rx on %.1f%% of the time overall, %d missed frames"
+              % (100.0 * on_total / max(state_total, 1), sum(r.get("rx_missed", 0) for r in reports)))
+
+    powers = [r["power"] for r in reports if "power" in r]
+
+    if powers:
+        result["power"] = {}
+
+        for i, name in enumerate(STATES):
+            active_ms = sum(p["active_ms"][i] for p in powers)
+            idle_ms = sum(p["idle_ms"][i] for p in powers)
+            if active_ms + idle_ms == 0:
+                continue
+
+            wakeups = sum(p["wakeups"][i] for p in powers)
+            current_ua = sum(p["current_ua"][i] * (p["active_ms"][i] + p["idle_ms"][i])
+                             for p in powers) / (active_ms + idle_ms)
+            result["power"][name] = {"wakeups": wakeups, "active_ms": active_ms, "idle_ms": idle_ms,
+                                     "current_ua": round(current_ua)}
+            print("power: %-12s %6.1f wakeups/s, idle %5.1f%%, ~%d uA"
+                  % (name, 1000.0 * wakeups / (active_ms + idle_ms), 100.0 * idle_ms / (active_ms + idle_ms),
+                     current_ua))
+
+    timers = [r["timer"] for r in reports if "timer" in r]
+
+    if timers:
+        total = lambda key: sum(t[key] for t in timers)
+        result["timer"] = {key: total(key) for key in timers[0] if key != "swi_us_max"}
+        result["timer"]["swi_us_max"] = max(t["swi_us_max"] for t in timers)
+
+        print("timer: %d started, %d expired in %d Swi runs, %d cascades, Swi avg %.0f us, max %d us"
+              % (total("started"), total("expired"), total("swi_runs"), total("cascades"),
+                 total("swi_us_sum") / max(total("swi_runs"), 1), result["timer"]["swi_us_max"]))
+
+    musics = [r["music"] for r in reports if "music" in r]
+
+    if musics and sum(m["songs"] for m in musics):
+        total = lambda key: sum(m[key] for m in musics)
+        result["music"] = {key: total(key) for key in musics[0] if key != "late_ms_max"}
+        result["music"]["late_ms_max"] = max(m["late_ms_max"] for m in musics)
+
+        print("music: %d songs, %d steps, %d late (max %d ms)"
+              % (total("songs"), total("steps"), total("late"), result["music"]["late_ms_max"]))
+
+    monitors = [r["monitor"] for r in reports if "monitor" in r]
+
+    if monitors:
+        uptime_ms = sum(r["uptime_us"] for r in reports if "monitor" in r) / 1000.0
+        result["monitor"] = {}
+
+        for i, task in enumerate(monitors[0]["tasks"]):
+            cpu_ms = sum(m["tasks"][i]["cpu_ms"] for m in monitors)
+            switches = sum(m["tasks"][i]["switches"] for m in monitors)
+            stack_used = max(m["tasks"][i]["stack_used"] for m in monitors)
+            result["monitor"][task["name"]] = {"cpu_ms": cpu_ms, "switches": switches, "stack_used": stack_used,
+                                               "stack_size": task["stack_size"]}
+            print("task: %-5s cpu %5.2f%%, %6.1f switches/s, stack %d of %d bytes"
+                  % (task["name"], 100.0 * cpu_ms / uptime_ms, 1000.0 * switches / uptime_ms,
+                     stack_used, task["stack_size"]))
+
+    if len(reports) != args.devices:
+        print("warning: only %d of %d devices reported" % (len(reports), args.devices))
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(result, f, indent=2)
+
+
+if __name__ == "__main__":
+    main()
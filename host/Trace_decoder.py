@@ -0,0 +1,116 @@
+'''
+Turns a dump of the binary trace log (trace.c) into a readable timeline.
+
+The dump is the System_putch output of the device: 12-byte records of
+ticks (4 bytes), id (2), a (2) and b (4), little-endian. The simulator
+writes it to the file named by SIM_TRACE_DUMP; on the device it is the
+SysMin output buffer, saved from the debugger.
+
+The names of the record types, the events and the states are read from
+trace.h, events.h and main.c, so the decoder follows the firmware.
+
+Usage:
+    SIM_TRACE_DUMP=trace.bin SIM_TRACE=traces/game_buttons.trace ./sim_device
+    python3 Trace_decoder.py trace.bin [--tick-us 10] [--since 0] [--only STATE,EVENT]
+'''
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.dirname(HERE)
+
+RECORD = struct.Struct("<IHHI")
+
+
+def enum(path, name):
+    ''' The names of enum name in the source file, by value. '''
+    with open(path, encoding="latin-1") as f:
+        match = re.search(r"enum\s+%s\s*\{([^}]*)\}" % name, f.read())
+
+    names = {}
+    value = 0
+
+    for item in match.group(1).split(","):
+        item = item.strip()
+        if not item:
+            continue
+        if "=" in item:
+            item, value = (x.strip() for x in item.split("="))
+            value = int(value, 0)
+        names[value] = item
+        value += 1
+
+    return names
+
+
+def describe(rec_id, a, b, ids, events, states):
+    ''' The record as text: its type and its arguments. '''
+    kind = ids.get(rec_id, "?%d" % rec_id)
+
+    if kind == "TRACE_STATE":
+        text = "%s -> %s" % (states.get(a, a), states.get(b, b))
+    elif kind in ("TRACE_EVENT", "TRACE_DROP"):
+        text = "%s arg %d" % (events.get(a, a), b)
+    elif kind == "TRACE_EDGE":
+        text = "button %d" % a
+    elif kind == "TRACE_PRESS":
+        text = "button %d %s" % (a, "down" if b else "up")
+    elif kind == "TRACE_RX":
+        chars = struct.pack("<I", b).split(b"\0")[0].decode("latin-1")
+        text = "from 0x%04x \"%s...\"" % (a, chars)
+    elif kind == "TRACE_TX":
+        text = "frame #%d, try %d" % (a, b)
+    elif kind == "TRACE_CPU":
+        text = "task %d %.1f%%, %d switches/s" % (a, (b >> 16) / 10.0, b & 0xFFFF)
+    elif kind == "TRACE_STACK":
+        text = "task %d %d bytes deep" % (a, b)
+    else:
+        text = "a %d b %d" % (a, b)
+
+    return kind[len("TRACE_"):] if kind.startswith("TRACE_") else kind, text
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("dump", help="binary trace dump")
+    parser.add_argument("--tick-us", type=float, default=10.0, help="Clock_tickPeriod of the device (us)")
+    parser.add_argument("--since", type=float, default=0.0, help="skip records before this time (ms)")
+    parser.add_argument("--only", default="", help="comma-separated record types to show, e.g. STATE,EVENT")
+    args = parser.parse_args()
+
+    ids = enum(os.path.join(ROOT, "trace.h"), "trace_id")
+    events = {k: v[len("EV_"):] for k, v in enum(os.path.join(ROOT, "events.h"), "event_type").items()}
+    states = enum(os.path.join(ROOT, "main.c"), "state")
+    only = set(x.strip().upper() for x in args.only.split(",") if x.strip())
+
+    with open(args.dump, "rb") as f:
+        data = f.read()
+
+    if len(data) % RECORD.size:
+        print("warning: %d trailing bytes ignored" % (len(data) % RECORD.size), file=sys.stderr)
+
+    last = None
+
+    for offset in range(0, len(data) - RECORD.size + 1, RECORD.size):
+        ticks, rec_id, a, b = RECORD.unpack_from(data, offset)
+        ms = ticks * args.tick_us / 1000.0
+
+        if ms < args.since:
+            continue
+
+        kind, text = describe(rec_id, a, b, ids, events, states)
+
+        if only and kind not in only:
+            continue
+
+        delta = "" if last is None else "+%.2f" % (ms - last)
+        print("%10.2f ms %9s  %-6s %s" % (ms, delta, kind, text))
+        last = ms
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,181 @@
+/*
+ * In-process stand-in for the TRON game backend, for the virtual-time
+ * simulator: the same game and replies as host/Backend_server.py, but
+ * called directly by comm_lib.c so that no socket (and no wall clock)
+ * gets between the device and its replies.
+ *
+ * One device, one player: events with a sequence number are acknowledged
+ * ("<addr>,ACK,<seq>") and applied once; a move that hits the wall or a
+ * trail answers "<addr>,LOST GAME", surviving SIM_WIN_MOVES moves (30)
+ * on a SIM_GRID (20) square arena "<addr>,WIN", and a retransmission of
+ * that move gets the result again. Session fragments and latency
+ * histograms are only acknowledged and counted.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+#define GRID_MAX 64
+#define SEEN 64 // Recent sequence numbers, as the backend remembers them.
+
+static uint8_t grid = 20;
+static uint16_t win_moves = 30;
+
+static uint8_t trail[GRID_MAX][GRID_MAX];
+static int x, y;
+static uint16_t moves;
+
+static unsigned long seen[SEEN];
+static uint8_t seen_count = 0;
+static uint8_t seen_next = 0;
+
+static unsigned long result_seq; // The last move that ended a game...
+static const char *result = NULL; // ...and how.
+
+static struct {
+	uint32_t frames;
+	uint32_t errors;
+	uint32_t acks;
+	uint32_t duplicates;
+	uint32_t moves;
+	uint32_t wins;
+	uint32_t losses;
+	uint32_t fragments;
+	uint32_t histograms;
+} stats;
+
+static void reset(void) {
+	memset(trail, 0, sizeof(trail));
+	x = y = grid / 2; // Start from the middle...
+	trail[x][y] = 1; // ...with only the start cell lit.
+	moves = 0;
+}
+
+static void init(void) {
+	static uint8_t done = 0;
+	const char *env;
+
+	if (done) return;
+	done = 1;
+
+	if ((env = getenv("SIM_GRID")) != NULL) grid = atoi(env);
+	if ((env = getenv("SIM_WIN_MOVES")) != NULL) win_moves = atoi(env);
+	if (grid < 1 || grid > GRID_MAX) grid = 20;
+
+	reset();
+}
+
+/*
+ * Moves one cell. Returns "WIN", "LOST GAME" or NULL if the game goes on.
+ */
+static const char *move(const char *direction) {
+	if (strcmp(direction, "UP") == 0) y++;
+	else if (strcmp(direction, "DOWN") == 0) y--;
+	else if (strcmp(direction, "LEFT") == 0) x--;
+	else x++;
+
+	moves++;
+	stats.moves++;
+
+	if (x < 0 || x >= grid || y < 0 || y >= grid || trail[x][y]) { // Hit the wall or a trail.
+		reset();
+		stats.losses++;
+		return "LOST GAME";
+	}
+
+	trail[x][y] = 1;
+
+	if (moves >= win_moves) { // Survived long enough!
+		reset();
+		stats.wins++;
+		return "WIN";
+	}
+
+	return NULL;
+}
+
+static uint8_t was_seen(unsigned long seq) {
+	uint8_t i;
+
+	for (i = 0; i < seen_count; i++) {
+		if (seen[i] == seq) return 1;
+	}
+
+	seen[seen_next] = seq;
+	seen_next = (seen_next + 1) % SEEN;
+	if (seen_count < SEEN) seen_count++;
+
+	return 0;
+}
+
+/*
+ * Handles one frame from addr. Fills in the reply texts and returns how
+ * many there are (at most two: the acknowledgement and the result).
+ */
+uint8_t backend_handle(uint16_t addr, const char *payload, char replies[][COMM_MAX_PAYLOAD + 1]) {
+	char text[COMM_MAX_PAYLOAD + 1];
+	const char *ended;
+	char *hash;
+	char *end = NULL;
+	unsigned long seq = 0;
+	uint8_t upload, histogram, event;
+	uint8_t n = 0;
+
+	init();
+	stats.frames++;
+
+	snprintf(text, sizeof(text), "%s", payload);
+	hash = strchr(text, '#');
+
+	if (hash) {
+		*hash = 0;
+		seq = strtoul(hash + 1, &end, 10);
+	}
+
+	upload = strncmp(text, "sess:", 5) == 0;
+	histogram = strncmp(text, "lat:", 4) == 0;
+	event = strncmp(text, "event:", 6) == 0 && (strcmp(text + 6, "UP") == 0 || strcmp(text + 6, "DOWN") == 0
+			|| strcmp(text + 6, "LEFT") == 0 || strcmp(text + 6, "RIGHT") == 0);
+
+	if (!(upload || histogram || event) || (hash && (end == hash + 1 || *end != 0))) {
+		stats.errors++;
+		return 0;
+	}
+
+	if (hash) {
+		stats.acks++;
+		snprintf(replies[n++], COMM_MAX_PAYLOAD + 1, "%u,ACK,%lu", addr, seq);
+
+		if (was_seen(seq)) { // A retransmission: already applied.
+			stats.duplicates++;
+			if (result && seq == result_seq) { // The result may have been lost with the ACK.
+				snprintf(replies[n++], COMM_MAX_PAYLOAD + 1, "%u,%s", addr, result);
+			}
+			return n;
+		}
+	}
+
+	if (upload) {
+		stats.fragments++;
+	} else if (histogram) {
+		stats.histograms++;
+	} else if ((ended = move(text + 6)) != NULL) {
+		snprintf(replies[n++], COMM_MAX_PAYLOAD + 1, "%u,%s", addr, ended);
+		if (hash) {
+			result = ended;
+			result_seq = seq;
+		}
+	}
+
+	return n;
+}
+
+void backend_report(FILE *out) {
+	fprintf(out, ", \"backend\": {\"frames\": %u, \"errors\": %u, \"acks\": %u, \"duplicates\": %u, "
+			"\"moves\": %u, \"wins\": %u, \"losses\": %u, \"fragments\": %u, \"histograms\": %u}",
+			stats.frames, stats.errors, stats.acks, stats.duplicates, stats.moves, stats.wins,
+			stats.losses, stats.fragments, stats.histograms);
+}
@@ -0,0 +1,282 @@
+/*
+ * Host implementation of the 6LoWPAN library on top of a UDP socket.
+ *
+ * The firmware only ever talks to IEEE80154_SERVER_ADDR, so every
+ * frame is sent to the backend stand-in given by SIM_SERVER. The
+ * backend answers to the UDP port we sent from, which lets any number
+ * of simulated devices share the same 6LoWPAN address.
+ *
+ * In virtual time (SIM_VIRTUAL, see host/rtos.c) there is no socket:
+ * frames go to the in-process backend (host/backend.c) and its replies
+ * arrive SIM_RTT_US (2000) microseconds of device time later.
+ *
+ * Build (together with the firmware or a test driver):
+ *   gcc -Ihost/include -c host/comm_lib.c
+ */
+
+#define _GNU_SOURCE
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "wireless/comm_lib.h"
+#include "sim.h"
+
+#define RX_QUEUE 8 // Replies on their way in virtual time.
+
+static int sock = -1;
+static struct sockaddr_in server;
+static uint16_t my_addr = IEEE80154_MY_ADDR;
+static uint8_t rx_on = 0;
+static comm_stats_t stats;
+
+static uint64_t last_tx; // For the round trip of the replies.
+static uint8_t turnaround = 0; // Transmitted, StartReceive6LoWPAN not called yet.
+static uint32_t rtts[COMM_MAX_RTTS];
+static uint32_t rtt_count = 0;
+
+static struct {
+	uint64_t due; // Arrives then.
+	uint8_t len;
+	uint8_t frame[2 + COMM_MAX_PAYLOAD];
+} rx_queue[RX_QUEUE];
+static uint8_t rx_head = 0;
+static uint8_t rx_count = 0;
+static uint8_t virtual = 0;
+static uint32_t rtt_us = 2000;
+
+// Provided by host/rtos.c when running inside the simulated device.
+void sim_idle(uint32_t us) __attribute__((weak));
+uint64_t sim_now_us(void) __attribute__((weak));
+uint8_t sim_virtual(void) __attribute__((weak));
+uint8_t backend_handle(uint16_t addr, const char *payload, char replies[][COMM_MAX_PAYLOAD + 1]) __attribute__((weak));
+
+static uint64_t now_us(void) {
+	struct timespec now;
+
+	if (sim_now_us) return sim_now_us();
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000ull + now.tv_nsec / 1000;
+}
+
+/*
+ * Virtual time: queues the backend's replies to a frame.
+ */
+static void backend_send(uint16_t addr, const char *payload) {
+	char replies[2][COMM_MAX_PAYLOAD + 1];
+	uint8_t n = backend_handle ? backend_handle(addr, payload, replies) : 0;
+	uint8_t i;
+
+	for (i = 0; i < n && rx_count < RX_QUEUE; i++) {
+		uint8_t slot = (rx_head + rx_count++) % RX_QUEUE;
+
+		rx_queue[slot].due = now_us() + rtt_us;
+		rx_queue[slot].len = 2 + strlen(replies[i]);
+		rx_queue[slot].frame[0] = IEEE80154_SERVER_ADDR & 0xFF;
+		rx_queue[slot].frame[1] = IEEE80154_SERVER_ADDR >> 8;
+		memcpy(&rx_queue[slot].frame[2], replies[i], rx_queue[slot].len - 2);
+	}
+}
+
+/*
+ * Like recv with MSG_DONTWAIT (and MSG_PEEK if peek): the next frame
+ * that has arrived, from the socket or in virtual time from the queue.
+ */
+static ssize_t receive(void *frame, size_t size, uint8_t peek) {
+	ssize_t len;
+
+	if (!virtual) return sock < 0 ? -1 : recv(sock, frame, size, MSG_DONTWAIT | (peek ? MSG_PEEK : 0));
+
+	if (rx_count == 0 || rx_queue[rx_head].due > now_us()) return -1;
+
+	len = rx_queue[rx_head].len < size ? rx_queue[rx_head].len : size;
+	memcpy(frame, rx_queue[rx_head].frame, len);
+
+	if (!peek) {
+		rx_head = (rx_head + 1) % RX_QUEUE;
+		rx_count--;
+	}
+
+	return len;
+}
+
+/*
+ * Opens the socket and resolves the backend address.
+ * Returns 0 on success, -1 if the socket could not be set up.
+ */
+int32_t Init6LoWPAN(void) {
+	char host[64];
+	const char *env = getenv("SIM_SERVER");
+	char *colon;
+
+	if (env == NULL) env = COMM_DEFAULT_SERVER;
+
+	snprintf(host, sizeof(host), "%s", env);
+	colon = strchr(host, ':');
+
+	memset(&server, 0, sizeof(server));
+	server.sin_family = AF_INET;
+	server.sin_port = htons(colon ? atoi(colon + 1) : 15154);
+
+	if (colon) *colon = 0;
+
+	if (inet_pton(AF_INET, host, &server.sin_addr) != 1) {
+		fprintf(stderr, "comm_lib: bad SIM_SERVER '%s'\n", env);
+		return -1;
+	}
+
+	env = getenv("SIM_ADDR");
+	if (env != NULL) my_addr = (uint16_t) strtoul(env, NULL, 0);
+
+	memset(&stats, 0, sizeof(stats));
+
+	if (sim_virtual && sim_virtual()) {
+		virtual = 1;
+		env = getenv("SIM_RTT_US");
+		if (env != NULL) rtt_us = strtoul(env, NULL, 0);
+		return 0;
+	}
+
+	sock = socket(AF_INET, SOCK_DGRAM, 0);
+	if (sock < 0) {
+		perror("comm_lib: socket");
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Frames the backend sent while the receiver was off would never have
+ * been heard by the real radio, so they are thrown away (and counted).
+ */
+static void drain(void) {
+	char frame[2 + COMM_MAX_PAYLOAD];
+
+	if (rx_on) return;
+
+	while (receive(frame, sizeof(frame), 0) >= 0) {
+		stats.rx_missed++;
+	}
+}
+
+/*
+ * Puts the "radio" into receive mode. Right after a transmission the
+ * real radio is back in RX long before any reply can arrive, but here
+ * the backend may beat us to it, so that turnaround keeps its frames.
+ */
+int32_t StartReceive6LoWPAN(void) {
+	if (!turnaround) drain();
+
+	turnaround = 0;
+	rx_on = 1;
+	return 0;
+}
+
+/*
+ * Takes the "radio" out of receive mode.
+ */
+int32_t StopReceive6LoWPAN(void) {
+	turnaround = 0;
+	rx_on = 0;
+	return 0;
+}
+
+/*
+ * Returns 1 if the receiver is on and a frame is waiting. commTask
+ * polls this in a tight loop, so an empty poll lets the other
+ * simulated tasks run for a millisecond.
+ */
+uint8_t GetRXFlag(void) {
+	char probe;
+
+	if (rx_on && receive(&probe, 1, 1) >= 0) {
+		return 1;
+	}
+
+	if (sim_idle) sim_idle(1000);
+
+	return 0;
+}
+
+/*
+ * Sends a frame to the backend. As on the real radio, transmitting
+ * takes the receiver out of RX mode until StartReceive6LoWPAN.
+ */
+void Send6LoWPAN(uint16_t DestAddr, char *ptr_Payload, uint8_t u8_length) {
+	uint8_t frame[2 + COMM_MAX_PAYLOAD];
+
+	if (sock < 0 && !virtual) return;
+	if (u8_length > COMM_MAX_PAYLOAD) u8_length = COMM_MAX_PAYLOAD;
+
+	frame[0] = my_addr & 0xFF;
+	frame[1] = my_addr >> 8;
+	memcpy(&frame[2], ptr_Payload, u8_length);
+
+	drain(); // Missed while the receiver was off, before this transmission.
+	rx_on = 0;
+	turnaround = 1;
+	last_tx = now_us();
+
+	if (virtual) {
+		char payload[COMM_MAX_PAYLOAD + 1];
+
+		memcpy(payload, ptr_Payload, u8_length);
+		payload[u8_length] = 0;
+		backend_send(my_addr, payload);
+
+		stats.tx_frames++;
+		stats.tx_bytes += u8_length;
+	} else if (sendto(sock, frame, 2 + u8_length, 0, (struct sockaddr *) &server, sizeof(server)) > 0) {
+		stats.tx_frames++;
+		stats.tx_bytes += u8_length;
+	}
+
+	(void) DestAddr; // Everything goes to the backend stand-in.
+}
+
+/*
+ * Copies the next frame into payload (at most maxLen - 1 bytes, always
+ * terminated). Returns the payload length, or -1 if nothing was waiting.
+ */
+int8_t Receive6LoWPAN(uint16_t *senderAddr, char *payload, uint8_t maxLen) {
+	uint8_t frame[2 + COMM_MAX_PAYLOAD];
+	ssize_t len;
+
+	if (maxLen == 0) return -1;
+
+	len = receive(frame, sizeof(frame), 0);
+	if (len < 2) return -1;
+
+	if (rtt_count < COMM_MAX_RTTS) { // Time since our last transmission.
+		rtts[rtt_count++] = now_us() - last_tx;
+	}
+
+	*senderAddr = frame[0] | (frame[1] << 8);
+	len -= 2;
+	if (len > maxLen - 1) len = maxLen - 1;
+
+	memcpy(payload, &frame[2], len);
+	payload[len] = 0;
+
+	stats.rx_frames++;
+	stats.rx_bytes += len;
+
+	return len;
+}
+
+void comm_get_stats(comm_stats_t *out) {
+	*out = stats;
+}
+
+uint32_t comm_get_rtts(const uint32_t **samples) {
+	*samples = rtts;
+	return rtt_count;
+}
@@ -0,0 +1,389 @@
+/*
+ * Host stand-ins for the SensorTag drivers: PIN (buttons and LEDs),
+ * I2C and the MPU9250/TMP007 sensors, the buzzer, the board and power
+ * functions and a 96x96 pixel display with the grlib primitives the
+ * firmware draws with.
+ *
+ * Inputs (button levels, MPU samples, temperature) are set by the
+ * input script through the sim_set_* functions.
+ *
+ * With SIM_BUZZER set, the buzzer writes its timeline to that file: a
+ * line "<us> <Hz>" for every tone set, and 0 Hz when it is closed
+ * (host/Sound_renderer.py).
+ */
+
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <xdc/std.h>
+#include <ti/drivers/PIN.h>
+#include <ti/drivers/pin/PINCC26XX.h>
+#include <ti/drivers/I2C.h>
+#include <ti/drivers/Power.h>
+#include <ti/mw/display/Display.h>
+#include <ti/mw/display/DisplayExt.h>
+#include "Board.h"
+#include "buzzer.h"
+#include "sensors/mpu9250.h"
+#include "sensors/tmp007.h"
+#include "sim.h"
+
+#define MAX_PIN_HANDLES 8
+#define SCREEN 96
+#define TEXT_LINES 12
+#define TEXT_COLUMNS 16
+
+/*
+ * PIN.
+ */
+static PIN_Handle pin_handles[MAX_PIN_HANDLES];
+static uint8_t pin_handle_count = 0;
+static uint8_t levels[256]; // Current level of every pin id.
+static uint32_t led_toggles = 0;
+static uint32_t button_irqs = 0;
+
+PIN_Handle PIN_open(PIN_State *state, const PIN_Config pinList[]) {
+	uint8_t i;
+
+	state->config = pinList;
+	state->callback = NULL;
+
+	for (i = 0; PIN_ID(pinList[i]) != PIN_TERMINATE; i++) {
+		PIN_Config cfg = pinList[i];
+
+		if (cfg & PIN_INPUT_EN) {
+			levels[PIN_ID(cfg)] = (cfg & PIN_PULLUP) ? 1 : 0;
+		} else {
+			levels[PIN_ID(cfg)] = (cfg & PIN_GPIO_HIGH) ? 1 : 0;
+		}
+	}
+
+	if (pin_handle_count < MAX_PIN_HANDLES) pin_handles[pin_handle_count++] = state;
+
+	return state;
+}
+
+void PIN_close(PIN_Handle handle) {
+	uint8_t i;
+
+	for (i = 0; i < pin_handle_count; i++) {
+		if (pin_handles[i] == handle) pin_handles[i] = NULL;
+	}
+}
+
+int PIN_registerIntCb(PIN_Handle handle, PIN_IntCb callbackFxn) {
+	handle->callback = callbackFxn;
+	return 0;
+}
+
+int PIN_setOutputValue(PIN_Handle handle, PIN_Id pinId, uint32_t val) {
+	if (levels[PIN_ID(pinId)] != (val != 0)) led_toggles++;
+	levels[PIN_ID(pinId)] = val != 0;
+
+	(void) handle; // The firmware drives the LEDs through a handle it never opens.
+	return 0;
+}
+
+uint32_t PIN_getOutputValue(PIN_Id pinId) {
+	return levels[PIN_ID(pinId)];
+}
+
+uint32_t PIN_getInputValue(PIN_Id pinId) {
+	return levels[PIN_ID(pinId)];
+}
+
+int PINCC26XX_setWakeup(const PIN_Config pinConfig[]) {
+	(void) pinConfig;
+	return 0;
+}
+
+/*
+ * Drives an input pin and runs the registered callback on the edges it
+ * is configured for, in "hardware interrupt" context (the caller holds
+ * the CPU).
+ */
+void sim_set_input(PIN_Id pin, uint8_t level) {
+	uint8_t old = levels[PIN_ID(pin)];
+	uint32_t edge = old && !level ? PIN_IRQ_NEGEDGE : !old && level ? PIN_IRQ_POSEDGE : 0;
+	uint8_t i, j;
+
+	levels[PIN_ID(pin)] = level;
+
+	if (!edge) return;
+
+	for (i = 0; i < pin_handle_count; i++) {
+		PIN_Handle handle = pin_handles[i];
+
+		if (handle == NULL || handle->callback == NULL) continue;
+
+		for (j = 0; PIN_ID(handle->config[j]) != PIN_TERMINATE; j++) {
+			if (PIN_ID(handle->config[j]) == PIN_ID(pin) && (handle->config[j] & edge)) {
+				button_irqs++;
+				handle->callback(handle, PIN_ID(pin));
+			}
+		}
+	}
+}
+
+/*
+ * I2C and sensors.
+ */
+static float mpu[6] = {0, 0, -1, 0, 0, 0}; // Lying face up.
+static double temperature = 22.0;
+static uint32_t mpu_reads = 0;
+
+void I2C_Params_init(I2C_Params *params) {
+	memset(params, 0, sizeof(*params));
+}
+
+I2C_Handle I2C_open(unsigned int index, I2C_Params *params) {
+	(void) params;
+	return (I2C_Handle) (uintptr_t) (index + 1);
+}
+
+void I2C_close(I2C_Handle handle) {
+	(void) handle;
+}
+
+void mpu9250_setup(I2C_Handle *i2c) {
+	(void) i2c;
+}
+
+void mpu9250_get_data(I2C_Handle *i2c, float *ax, float *ay, float *az, float *gx, float *gy, float *gz) {
+	*ax = mpu[0]; *ay = mpu[1]; *az = mpu[2];
+	*gx = mpu[3]; *gy = mpu[4]; *gz = mpu[5];
+	mpu_reads++;
+
+	(void) i2c;
+}
+
+void tmp007_setup(I2C_Handle *i2c) {
+	(void) i2c;
+}
+
+double tmp007_get_data(I2C_Handle *i2c) {
+	(void) i2c;
+	return temperature;
+}
+
+void sim_set_mpu(const float sample[6]) {
+	memcpy(mpu, sample, sizeof(mpu));
+}
+
+void sim_set_temp(double celsius) {
+	temperature = celsius;
+}
+
+/*
+ * Buzzer.
+ */
+static uint8_t buzzer_open = 0;
+static uint32_t buzzer_opens = 0;
+static uint32_t buzzer_notes = 0;
+
+/*
+ * Logs a tone to SIM_BUZZER, if set.
+ */
+static void buzzer_log(uint16_t freq) {
+	static FILE *log = NULL;
+	static uint8_t opened = 0;
+
+	if (!opened) {
+		opened = 1;
+		if (getenv("SIM_BUZZER") && (log = fopen(getenv("SIM_BUZZER"), "w")) == NULL) perror(getenv("SIM_BUZZER"));
+	}
+
+	if (log) fprintf(log, "%llu %u\n", (unsigned long long) sim_now_us(), freq);
+}
+
+void buzzerOpen(PIN_Handle hPinGpio) {
+	buzzer_open = 1;
+	buzzer_opens++;
+	(void) hPinGpio;
+}
+
+bool buzzerSetFrequency(uint16_t freq) {
+	if (!buzzer_open) return false;
+
+	buzzer_notes++;
+	buzzer_log(freq);
+	return true;
+}
+
+void buzzerClose(void) {
+	if (buzzer_open) buzzer_log(0);
+	buzzer_open = 0;
+}
+
+/*
+ * Board and power.
+ */
+static uint32_t power_policy = 0; // Power_enablePolicy was called.
+
+void Board_initGeneral(void) {
+}
+
+void Board_initI2C(void) {
+}
+
+void Power_enablePolicy(void) {
+	power_policy = 1;
+}
+
+void Power_disablePolicy(void) {
+	power_policy = 0;
+}
+
+int Power_shutdown(void *shutdownState, uint32_t shutdownTime) {
+	(void) shutdownState;
+	(void) shutdownTime;
+
+	sim_report(stdout); // The device is gone: report what it did.
+	exit(0);
+}
+
+/*
+ * Display and grlib.
+ */
+static uint8_t frame[SCREEN * SCREEN];
+static char text[TEXT_LINES][TEXT_COLUMNS + 1];
+static tContext context = {frame, 1};
+static uint32_t flushes = 0;
+static uint32_t clears = 0;
+static uint32_t line_clears = 0;
+static uint32_t image_rows = 0; // Rows of pixels drawn by GrImageDraw.
+
+void Display_Params_init(Display_Params *params) {
+	params->lineClearMode = DISPLAY_CLEAR_NONE;
+}
+
+Display_Handle Display_open(int id, Display_Params *params) {
+	(void) params;
+	return (Display_Handle) (uintptr_t) id;
+}
+
+void Display_clear(Display_Handle handle) {
+	memset(frame, 0, sizeof(frame));
+	memset(text, 0, sizeof(text));
+	clears++;
+	(void) handle;
+}
+
+void Display_clearLines(Display_Handle handle, uint8_t fromLine, uint8_t toLine) {
+	uint8_t line;
+
+	for (line = fromLine; line <= toLine && line < TEXT_LINES; line++) {
+		memset(&frame[line * 8 * SCREEN], 0, 8 * SCREEN);
+		memset(text[line], 0, sizeof(text[line]));
+		line_clears++;
+	}
+	(void) handle;
+}
+
+void Display_close(Display_Handle handle) {
+	(void) handle;
+}
+
+void Display_print0(Display_Handle handle, uint8_t line, uint8_t column, const char *str) {
+	if (line >= TEXT_LINES || column >= TEXT_COLUMNS) return;
+
+	strncpy(&text[line][column], str, TEXT_COLUMNS - column);
+	flushes++; // Display_print0 writes straight to the LCD.
+	(void) handle;
+}
+
+tContext *DisplayExt_getGrlibContext(Display_Handle handle) {
+	(void) handle;
+	return &context;
+}
+
+void GrPixelDraw(const tContext *pContext, int32_t x, int32_t y) {
+	if (x >= 0 && x < SCREEN && y >= 0 && y < SCREEN) {
+		pContext->frame[y * SCREEN + x] = 1;
+	}
+}
+
+void GrLineDraw(const tContext *pContext, int32_t x1, int32_t y1, int32_t x2, int32_t y2) {
+	int32_t dx = abs(x2 - x1), sx = x1 < x2 ? 1 : -1;
+	int32_t dy = -abs(y2 - y1), sy = y1 < y2 ? 1 : -1;
+	int32_t err = dx + dy, e2;
+
+	while (1) { // Bresenham.
+		GrPixelDraw(pContext, x1, y1);
+		if (x1 == x2 && y1 == y2) break;
+
+		e2 = 2 * err;
+		if (e2 >= dy) { err += dy; x1 += sx; }
+		if (e2 <= dx) { err += dx; y1 += sy; }
+	}
+}
+
+void GrCircleDraw(const tContext *pContext, int32_t x, int32_t y, int32_t radius) {
+	int32_t px = radius, py = 0, err = 1 - radius;
+
+	while (px >= py) { // Midpoint circle, one octant mirrored eight times.
+		GrPixelDraw(pContext, x + px, y + py); GrPixelDraw(pContext, x - px, y + py);
+		GrPixelDraw(pContext, x + px, y - py); GrPixelDraw(pContext, x - px, y - py);
+		GrPixelDraw(pContext, x + py, y + px); GrPixelDraw(pContext, x - py, y + px);
+		GrPixelDraw(pContext, x + py, y - px); GrPixelDraw(pContext, x - py, y - px);
+
+		py++;
+		if (err < 0) {
+			err += 2 * py + 1;
+		} else {
+			px--;
+			err += 2 * (py - px) + 1;
+		}
+	}
+}
+
+void GrRectDraw(const tContext *pContext, const tRectangle *pRect) {
+	GrLineDraw(pContext, pRect->i16XMin, pRect->i16YMin, pRect->i16XMax, pRect->i16YMin);
+	GrLineDraw(pContext, pRect->i16XMax, pRect->i16YMin, pRect->i16XMax, pRect->i16YMax);
+	GrLineDraw(pContext, pRect->i16XMax, pRect->i16YMax, pRect->i16XMin, pRect->i16YMax);
+	GrLineDraw(pContext, pRect->i16XMin, pRect->i16YMax, pRect->i16XMin, pRect->i16YMin);
+}
+
+void GrRectFill(const tContext *pContext, const tRectangle *pRect) {
+	int32_t x0 = pRect->i16XMin < pRect->i16XMax ? pRect->i16XMin : pRect->i16XMax;
+	int32_t x1 = pRect->i16XMin < pRect->i16XMax ? pRect->i16XMax : pRect->i16XMin;
+	int32_t y0 = pRect->i16YMin < pRect->i16YMax ? pRect->i16YMin : pRect->i16YMax;
+	int32_t y1 = pRect->i16YMin < pRect->i16YMax ? pRect->i16YMax : pRect->i16YMin;
+	int32_t x, y;
+
+	for (y = y0; y <= y1; y++) {
+		for (x = x0; x <= x1; x++) {
+			GrPixelDraw(pContext, x, y);
+		}
+	}
+}
+
+void GrImageDraw(const tContext *pContext, const tImage *pImage, int32_t x, int32_t y) {
+	uint16_t stride = (pImage->XSize + 7) / 8;
+	uint16_t i, j;
+
+	for (j = 0; j < pImage->YSize; j++) {
+		for (i = 0; i < pImage->XSize; i++) {
+			if (x + i < 0 || x + i >= SCREEN || y + j < 0 || y + j >= SCREEN) continue;
+
+			// Opaque, like grlib: the 0 bits are drawn in the background color.
+			pContext->frame[(y + j) * SCREEN + x + i] = (pImage->pPixel[j * stride + i / 8] & (0x80 >> (i % 8))) != 0;
+		}
+	}
+	image_rows += pImage->YSize;
+}
+
+void GrFlush(const tContext *pContext) {
+	flushes++;
+	(void) pContext;
+}
+
+void sim_driver_report(FILE *out) {
+	fprintf(out, "\"flushes\": %u, \"clears\": %u, \"line_clears\": %u, \"image_rows\": %u, \"mpu_reads\": %u, \"button_irqs\": %u, "
+			"\"led_toggles\": %u, \"buzzer_opens\": %u, \"buzzer_notes\": %u, \"power_policy\": %u",
+			flushes, clears, line_clears, image_rows, mpu_reads, button_irqs, led_toggles, buzzer_opens, buzzer_notes, power_policy);
+}
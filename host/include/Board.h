@@ -0,0 +1,27 @@
+/*
+ * Host stand-in for the SensorTag board file.
+ */
+
+#ifndef BOARD_H_
+#define BOARD_H_
+
+#include <stdint.h>
+
+#define Board_BUTTON0        4
+#define Board_BUTTON1        0
+#define Board_LED0           10
+#define Board_LED1           15
+#define Board_BUZZER         21
+#define Board_MPU_POWER      12
+#define Board_MPU_POWER_ON   1
+#define Board_MPU_POWER_OFF  0
+#define Board_I2C0_SDA1      29
+#define Board_I2C0_SCL1      30
+#define Board_I2C            0
+
+void Board_initGeneral(void);
+void Board_initI2C(void);
+
+int Power_shutdown(void *shutdownState, uint32_t shutdownTime);
+
+#endif
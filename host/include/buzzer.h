@@ -0,0 +1,16 @@
+/*
+ * Host stand-in for the course buzzer library.
+ */
+
+#ifndef BUZZER_H_
+#define BUZZER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <ti/drivers/PIN.h>
+
+void buzzerOpen(PIN_Handle hPinGpio);
+bool buzzerSetFrequency(uint16_t freq);
+void buzzerClose(void);
+
+#endif
@@ -0,0 +1,8 @@
+/*
+ * Host stand-in for driverlib/timer.h (nothing from it is used on the host).
+ */
+
+#ifndef DRIVERLIB_TIMER_H_
+#define DRIVERLIB_TIMER_H_
+
+#endif
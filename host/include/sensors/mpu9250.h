@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for the MPU9250 driver: samples come from the input script.
+ */
+
+#ifndef MPU9250_H_
+#define MPU9250_H_
+
+#include <ti/drivers/I2C.h>
+
+void mpu9250_setup(I2C_Handle *i2c);
+void mpu9250_get_data(I2C_Handle *i2c, float *ax, float *ay, float *az, float *gx, float *gy, float *gz);
+
+#endif
@@ -0,0 +1,13 @@
+/*
+ * Host stand-in for the TMP007 driver: temperature comes from the input script.
+ */
+
+#ifndef TMP007_H_
+#define TMP007_H_
+
+#include <ti/drivers/I2C.h>
+
+void tmp007_setup(I2C_Handle *i2c);
+double tmp007_get_data(I2C_Handle *i2c);
+
+#endif
@@ -0,0 +1,24 @@
+/*
+ * Host stand-in for the TI-RTOS I2C driver. The sensors are simulated
+ * directly, so the handles carry no state.
+ */
+
+#ifndef I2C_H_
+#define I2C_H_
+
+#include <stdint.h>
+
+typedef struct I2C_Config *I2C_Handle;
+
+typedef enum {I2C_100kHz = 0, I2C_400kHz = 1} I2C_BitRate;
+
+typedef struct {
+	I2C_BitRate bitRate;
+	uintptr_t custom;
+} I2C_Params;
+
+void I2C_Params_init(I2C_Params *params);
+I2C_Handle I2C_open(unsigned int index, I2C_Params *params);
+void I2C_close(I2C_Handle handle);
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * Host stand-in for the TI-RTOS PIN driver. Input levels are driven
+ * by the input script (SIM_TRACE), outputs are only recorded.
+ */
+
+#ifndef PIN_H_
+#define PIN_H_
+
+#include <stdint.h>
+
+typedef uint32_t PIN_Config;
+typedef uint32_t PIN_Id;
+
+typedef struct PIN_State_s {
+	const PIN_Config *config;
+	void (*callback)(struct PIN_State_s *handle, PIN_Id pinId);
+} PIN_State;
+
+typedef PIN_State *PIN_Handle;
+typedef void (*PIN_IntCb)(PIN_Handle handle, PIN_Id pinId);
+
+#define PIN_ID(x)           ((x) & 0xFF)
+#define PIN_TERMINATE       0xFE
+
+#define PIN_INPUT_EN        (1u << 8)
+#define PIN_PULLUP          (1u << 9)
+#define PIN_HYSTERESIS      (1u << 10)
+#define PIN_IRQ_NEGEDGE     (1u << 11)
+#define PIN_GPIO_OUTPUT_EN  (1u << 12)
+#define PIN_GPIO_LOW        (1u << 13)
+#define PIN_GPIO_HIGH       (1u << 14)
+#define PIN_PUSHPULL        (1u << 15)
+#define PIN_DRVSTR_MAX      (1u << 16)
+#define PIN_IRQ_POSEDGE     (1u << 17)
+#define PIN_IRQ_BOTHEDGES   (PIN_IRQ_NEGEDGE | PIN_IRQ_POSEDGE)
+
+PIN_Handle PIN_open(PIN_State *state, const PIN_Config pinList[]);
+void PIN_close(PIN_Handle handle);
+int PIN_registerIntCb(PIN_Handle handle, PIN_IntCb callbackFxn);
+int PIN_setOutputValue(PIN_Handle handle, PIN_Id pinId, uint32_t val);
+uint32_t PIN_getOutputValue(PIN_Id pinId);
+uint32_t PIN_getInputValue(PIN_Id pinId);
+
+#endif
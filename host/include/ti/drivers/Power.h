@@ -0,0 +1,15 @@
+/*
+ * Host stand-in for ti/drivers/Power.h. There is no standby on the
+ * host: the policy switch is only recorded for the report.
+ */
+
+#ifndef DRIVERS_POWER_H_
+#define DRIVERS_POWER_H_
+
+#include <stdint.h>
+
+void Power_enablePolicy(void);
+void Power_disablePolicy(void);
+int Power_shutdown(void *shutdownState, uint32_t shutdownTime);
+
+#endif
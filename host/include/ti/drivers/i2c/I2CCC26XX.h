@@ -0,0 +1,15 @@
+/*
+ * Host stand-in for the CC26xx I2C pin configuration.
+ */
+
+#ifndef I2CCC26XX_H_
+#define I2CCC26XX_H_
+
+#include <stdint.h>
+
+typedef struct {
+	uint8_t pinSDA;
+	uint8_t pinSCL;
+} I2CCC26XX_I2CPinCfg;
+
+#endif
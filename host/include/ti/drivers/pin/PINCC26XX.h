@@ -0,0 +1,14 @@
+/*
+ * Host stand-in for the CC26xx PIN extensions.
+ */
+
+#ifndef PINCC26XX_H_
+#define PINCC26XX_H_
+
+#include <ti/drivers/PIN.h>
+
+#define PINCC26XX_WAKEUP_NEGEDGE (1u << 20)
+
+int PINCC26XX_setWakeup(const PIN_Config pinConfig[]);
+
+#endif
@@ -0,0 +1,27 @@
+/*
+ * Host stand-in for the TI-RTOS Display middleware. Text lines are kept
+ * in a 12x16 character buffer next to the 96x96 pixel buffer.
+ */
+
+#ifndef DISPLAY_H_
+#define DISPLAY_H_
+
+#include <stdint.h>
+
+typedef struct Display_Config *Display_Handle;
+
+#define Display_Type_LCD    1
+#define DISPLAY_CLEAR_NONE  0
+
+typedef struct {
+	int lineClearMode;
+} Display_Params;
+
+void Display_Params_init(Display_Params *params);
+Display_Handle Display_open(int id, Display_Params *params);
+void Display_clear(Display_Handle handle);
+void Display_clearLines(Display_Handle handle, uint8_t fromLine, uint8_t toLine);
+void Display_close(Display_Handle handle);
+void Display_print0(Display_Handle handle, uint8_t line, uint8_t column, const char *str);
+
+#endif
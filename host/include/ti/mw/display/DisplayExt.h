@@ -0,0 +1,44 @@
+/*
+ * Host stand-in for the grlib subset used by the firmware.
+ */
+
+#ifndef DISPLAYEXT_H_
+#define DISPLAYEXT_H_
+
+#include <stdint.h>
+#include <ti/mw/display/Display.h>
+
+#define IMAGE_FMT_1BPP_UNCOMP 0x01
+
+typedef struct {
+	int16_t i16XMin;
+	int16_t i16YMin;
+	int16_t i16XMax;
+	int16_t i16YMax;
+} tRectangle;
+
+typedef struct {
+	uint8_t BPP;
+	uint16_t NumColors;
+	uint16_t XSize;
+	uint16_t YSize;
+	const uint32_t *pPalette;
+	const uint8_t *pPixel;
+} tImage;
+
+typedef struct {
+	uint8_t *frame; // 96x96 pixels, one byte each.
+	uint32_t foreground;
+} tContext;
+
+tContext *DisplayExt_getGrlibContext(Display_Handle handle);
+
+void GrPixelDraw(const tContext *pContext, int32_t x, int32_t y);
+void GrLineDraw(const tContext *pContext, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+void GrCircleDraw(const tContext *pContext, int32_t x, int32_t y, int32_t radius);
+void GrRectDraw(const tContext *pContext, const tRectangle *pRect);
+void GrRectFill(const tContext *pContext, const tRectangle *pRect);
+void GrImageDraw(const tContext *pContext, const tImage *pImage, int32_t x, int32_t y);
+void GrFlush(const tContext *pContext);
+
+#endif
@@ -0,0 +1,16 @@
+/*
+ * Host stand-in for ti.sysbios.BIOS. BIOS_start runs the simulated
+ * device until SIM_DURATION seconds have passed and never returns.
+ */
+
+#ifndef BIOS_H_
+#define BIOS_H_
+
+#include <xdc/std.h>
+
+#define BIOS_NO_WAIT 0
+#define BIOS_WAIT_FOREVER (~(UInt32) 0)
+
+void BIOS_start(void);
+
+#endif
@@ -0,0 +1,14 @@
+/*
+ * Host stand-in for ti.sysbios.hal.Hwi. The pin callbacks only run while
+ * they hold the simulated CPU, so disabling interrupts is a no-op here.
+ */
+
+#ifndef HWI_H_
+#define HWI_H_
+
+#include <xdc/std.h>
+
+UInt Hwi_disable(void);
+void Hwi_restore(UInt key);
+
+#endif
@@ -0,0 +1,28 @@
+/*
+ * Host stand-in for ti.sysbios.knl.Clock.
+ */
+
+#ifndef CLOCK_H_
+#define CLOCK_H_
+
+#include <xdc/std.h>
+
+typedef struct Clock_Object *Clock_Handle;
+typedef void (*Clock_FuncPtr)(UArg arg0);
+
+typedef struct {
+	uint32_t period;
+	Bool startFlag;
+	UArg arg;
+} Clock_Params;
+
+extern const uint32_t Clock_tickPeriod; // Microseconds per tick.
+
+void Clock_Params_init(Clock_Params *params);
+Clock_Handle Clock_create(Clock_FuncPtr clockFxn, uint32_t timeout, const Clock_Params *params, void *eb);
+void Clock_start(Clock_Handle handle);
+void Clock_stop(Clock_Handle handle);
+void Clock_setTimeout(Clock_Handle handle, uint32_t timeout);
+uint32_t Clock_getTicks(void);
+
+#endif
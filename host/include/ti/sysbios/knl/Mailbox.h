@@ -0,0 +1,24 @@
+/*
+ * Host stand-in for ti.sysbios.knl.Mailbox: fixed-size messages copied
+ * into a bounded queue.
+ */
+
+#ifndef MAILBOX_H_
+#define MAILBOX_H_
+
+#include <xdc/std.h>
+
+typedef struct Mailbox_Object *Mailbox_Handle;
+
+typedef struct {
+	void *buf; // Unused here: the queue is allocated by Mailbox_create.
+	UInt bufSize;
+} Mailbox_Params;
+
+void Mailbox_Params_init(Mailbox_Params *params);
+Mailbox_Handle Mailbox_create(SizeT msgSize, UInt numMsgs, const Mailbox_Params *params, void *eb);
+Bool Mailbox_post(Mailbox_Handle handle, Ptr msg, UInt32 timeout);
+Bool Mailbox_pend(Mailbox_Handle handle, Ptr msg, UInt32 timeout);
+Int Mailbox_getNumPendingMsgs(Mailbox_Handle handle);
+
+#endif
@@ -0,0 +1,27 @@
+/*
+ * Host stand-in for ti.sysbios.knl.Semaphore: counting and binary
+ * semaphores.
+ */
+
+#ifndef SEMAPHORE_H_
+#define SEMAPHORE_H_
+
+#include <xdc/std.h>
+
+typedef struct Semaphore_Object *Semaphore_Handle;
+
+typedef enum {
+	Semaphore_Mode_COUNTING,
+	Semaphore_Mode_BINARY
+} Semaphore_Mode;
+
+typedef struct {
+	Semaphore_Mode mode;
+} Semaphore_Params;
+
+void Semaphore_Params_init(Semaphore_Params *params);
+Semaphore_Handle Semaphore_create(Int count, const Semaphore_Params *params, void *eb);
+void Semaphore_post(Semaphore_Handle handle);
+Bool Semaphore_pend(Semaphore_Handle handle, UInt32 timeout);
+
+#endif
@@ -0,0 +1,14 @@
+/*
+ * Host stand-in for ti.sysbios.knl.Swi. Clock functions only run while
+ * they hold the simulated CPU, so disabling Swis is a no-op here.
+ */
+
+#ifndef SWI_H_
+#define SWI_H_
+
+#include <xdc/std.h>
+
+UInt Swi_disable(void);
+void Swi_restore(UInt key);
+
+#endif
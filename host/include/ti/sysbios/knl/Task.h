@@ -0,0 +1,36 @@
+/*
+ * Host stand-in for ti.sysbios.knl.Task.
+ */
+
+#ifndef TASK_H_
+#define TASK_H_
+
+#include <xdc/std.h>
+
+typedef struct Task_Object *Task_Handle;
+typedef void (*Task_FuncPtr)(UArg arg0, UArg arg1);
+
+typedef struct {
+	UArg arg0;
+	UArg arg1;
+	Int priority;
+	void *stack;
+	size_t stackSize;
+} Task_Params;
+
+typedef struct {
+	Int priority;
+	Ptr stack;
+	SizeT stackSize;
+	Ptr sp;
+	SizeT used; // The deepest the stack has been.
+} Task_Stat;
+
+void Task_Params_init(Task_Params *params);
+Task_Handle Task_create(Task_FuncPtr fxn, const Task_Params *params, void *eb);
+void Task_sleep(uint32_t nticks);
+void Task_stat(Task_Handle handle, Task_Stat *statbuf);
+UInt Task_disable(void);
+void Task_restore(UInt key);
+
+#endif
@@ -0,0 +1,51 @@
+/*
+ * Host stand-in for the course 6LoWPAN library (wireless/comm_lib.h).
+ *
+ * Provides the same calls as the SensorTag library but carries the
+ * frames over UDP to a local backend (see host/Backend_server.py).
+ * Each datagram starts with the 16-bit address of the sender (or the
+ * recipient, in the backend -> device direction) in little-endian
+ * order, followed by the payload.
+ *
+ * Environment variables:
+ *   SIM_SERVER  backend address as host:port (default 127.0.0.1:15154).
+ *   SIM_ADDR    our own address (default IEEE80154_MY_ADDR).
+ *   SIM_RTT_US  virtual time only: delay of the in-process backend's
+ *               replies (default 2000, see host/backend.c).
+ */
+
+#ifndef COMM_LIB_H_
+#define COMM_LIB_H_
+
+#include <stdint.h>
+
+#define IEEE80154_MY_ADDR     251
+#define IEEE80154_SERVER_ADDR 0x1234
+
+#define COMM_DEFAULT_SERVER "127.0.0.1:15154"
+#define COMM_MAX_PAYLOAD    80
+#define COMM_MAX_RTTS       4096
+
+int32_t Init6LoWPAN(void);
+int32_t StartReceive6LoWPAN(void);
+int32_t StopReceive6LoWPAN(void);
+#define COMM_STOP_RX // Host only: the course library has no StopReceive6LoWPAN.
+uint8_t GetRXFlag(void);
+void Send6LoWPAN(uint16_t DestAddr, char *ptr_Payload, uint8_t u8_length);
+int8_t Receive6LoWPAN(uint16_t *senderAddr, char *payload, uint8_t maxLen);
+
+// Host-only: counters for the load tests.
+typedef struct {
+	uint32_t tx_frames;
+	uint32_t tx_bytes;
+	uint32_t rx_frames;
+	uint32_t rx_bytes;
+	uint32_t rx_missed; // Frames that arrived while the receiver was off.
+} comm_stats_t;
+
+void comm_get_stats(comm_stats_t *stats);
+
+// Microseconds from our last transmission to each received frame.
+uint32_t comm_get_rtts(const uint32_t **samples);
+
+#endif
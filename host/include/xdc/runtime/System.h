@@ -0,0 +1,18 @@
+/*
+ * Host stand-in for xdc.runtime.System: output goes to stdout when
+ * SIM_VERBOSE is set and is discarded otherwise. System_putch writes
+ * to the file named by SIM_TRACE_DUMP, so the binary trace log can be
+ * decoded (host/Trace_decoder.py).
+ */
+
+#ifndef XDC_SYSTEM_H_
+#define XDC_SYSTEM_H_
+
+#include <xdc/std.h>
+
+int System_printf(const char *fmt, ...);
+void System_flush(void);
+void System_putch(Char ch);
+void System_abort(const char *str);
+
+#endif
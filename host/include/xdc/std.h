@@ -0,0 +1,26 @@
+/*
+ * Host stand-in for the XDCtools base types.
+ */
+
+#ifndef XDC_STD_H_
+#define XDC_STD_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef void Void;
+typedef char Char;
+typedef int Int;
+typedef unsigned int UInt;
+typedef uint32_t UInt32;
+typedef uintptr_t UArg;
+typedef uint8_t Bool;
+typedef size_t SizeT;
+typedef void *Ptr;
+
+#ifndef TRUE
+#define TRUE  1
+#define FALSE 0
+#endif
+
+#endif
@@ -0,0 +1,199 @@
+/*
+ * Host benchmark for the maze generator (maze.c): the time to carve a
+ * maze and the memory it takes, for each size up to MAZE_MAX, and a
+ * check that every maze carved is perfect (all the cells reachable, by
+ * exactly one way) with the end where the length asked for puts it.
+ *
+ * Then the scrolling view (maze_view.c): the ball goes the whole way
+ * from the end back to the start, MAZE_STEP pixels a frame (a fast
+ * tilt at the sensor rate), and the view follows it. The time, the
+ * blocks looked up and the rows rendered per frame are compared with
+ * rendering the whole view every frame.
+ *
+ * Build and run from the repository root:
+ *   gcc -std=c99 -O2 -DMAZE_MAX=48 -I. maze.c maze_view.c host/maze_bench.c -o maze_bench
+ *   ./maze_bench [mazes per size]
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "maze.h"
+#include "maze_view.h"
+
+#if MAZE_MAX < 48
+#error "Build with -DMAZE_MAX=48 for the largest of the sizes."
+#endif
+
+#define MAZE_STEP 4 // Pixels the ball moves a frame.
+
+static const uint8_t sizes[] = {6, 8, 12, 16, 24, 32, 48};
+
+static uint64_t now_ns() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+ * Whether the maze is perfect: as many open walls as cells less one,
+ * and every cell reachable from the start. Counts the way to the end.
+ */
+static int check(const maze_t *maze) {
+	static uint16_t queue[MAZE_MAX * MAZE_MAX];
+	static uint16_t distance[MAZE_MAX * MAZE_MAX];
+	static const int8_t dx[4] = {1, 0, -1, 0};
+	static const int8_t dy[4] = {0, 1, 0, -1};
+	uint16_t cells = maze->width * maze->height;
+	uint16_t head = 0, tail = 0, open = 0;
+	uint16_t cell;
+	uint8_t x, y, d;
+
+	for (y = 0; y < maze->height; y++) {
+		for (x = 0; x < maze->width; x++) {
+			open += maze_open(maze, x, y, MAZE_EAST) + maze_open(maze, x, y, MAZE_SOUTH);
+		}
+	}
+	if (open != cells - 1) return 0;
+
+	memset(distance, 0, sizeof(distance));
+	cell = maze->start_y * maze->width + maze->start_x;
+	distance[cell] = 1;
+	queue[tail++] = cell;
+
+	while (head < tail) {
+		cell = queue[head++];
+		x = cell % maze->width;
+		y = cell / maze->width;
+		for (d = 0; d < 4; d++) {
+			uint16_t next = (y + dy[d]) * maze->width + x + dx[d];
+			if (maze_open(maze, x, y, d) && !distance[next]) {
+				distance[next] = distance[cell] + 1;
+				queue[tail++] = next;
+			}
+		}
+	}
+
+	return tail == cells && distance[maze->end_y * maze->width + maze->end_x] == maze->length;
+}
+
+/*
+ * Walks the ball from the end to the start along the way back, with the
+ * view following it (or rendered whole, if full). Returns the frames.
+ */
+static uint32_t walk(const maze_t *maze, maze_view_t *view, int full, uint64_t *ns, uint64_t *max_ns) {
+	static const int8_t dx[4] = {1, 0, -1, 0};
+	static const int8_t dy[4] = {0, 1, 0, -1};
+	int16_t x = MAZE_BLOCK * (2 * maze->end_x + 1) + MAZE_BLOCK / 2;
+	int16_t y = MAZE_BLOCK * (2 * maze->end_y + 1) + MAZE_BLOCK / 2;
+	uint8_t cx = maze->end_x, cy = maze->end_y, d;
+	uint32_t frames = 0;
+	uint64_t began, took;
+	uint8_t row;
+	int step;
+
+	maze_view_init(view, maze, x, y);
+
+	while (cx != maze->start_x || cy != maze->start_y) {
+		d = maze_back(maze, cx, cy);
+		for (step = 0; step < 2 * MAZE_BLOCK; step += MAZE_STEP) { // Two blocks to the next cell.
+			x += dx[d] * MAZE_STEP;
+			y += dy[d] * MAZE_STEP;
+
+			began = now_ns();
+			if (full) {
+				maze_view_init(view, maze, x, y);
+			} else {
+				maze_view_follow(view, maze, x, y);
+			}
+			while (maze_view_render(view, maze, &row) > 0); // Blitted as they come.
+			took = now_ns() - began;
+
+			*ns += took;
+			if (took > *max_ns) *max_ns = took;
+			frames++;
+		}
+		cx += dx[d];
+		cy += dy[d];
+	}
+
+	return frames;
+}
+
+int main(int argc, char **argv) {
+	static maze_t maze;
+	int runs = argc > 1 ? atoi(argv[1]) : 1000;
+	uint8_t i;
+	int run;
+
+	printf("%-7s %10s %10s %12s %14s %14s %8s\n", "size", "us/maze", "cells/us", "grid bytes",
+			"carving bytes", "longest way", "perfect");
+
+	for (i = 0; i < sizeof(sizes); i++) {
+		uint8_t size = sizes[i];
+		uint32_t cells = size * size;
+		uint64_t ns = 0, began;
+		uint64_t longest = 0;
+		int perfect = 0;
+
+		for (run = 0; run < runs; run++) {
+			began = now_ns();
+			maze_generate(&maze, size, size, 0, run + 1);
+			ns += now_ns() - began;
+
+			longest += maze.length;
+			perfect += check(&maze);
+		}
+
+		printf("%2ux%-4u %10.2f %10.1f %12u %14u %13.1f%% %7d/%d\n", size, size,
+				ns / 1000.0 / runs, cells * runs / (ns / 1000.0), (cells + 1) / 2, (cells + 7) / 8,
+				100.0 * longest / runs / cells, perfect, runs);
+	}
+
+	// The length is what it is asked for, where the maze has it.
+	for (run = 0; run < runs; run++) {
+		maze_generate(&maze, 24, 24, 100, run + 1);
+		if (maze.length != 100 || !check(&maze)) {
+			printf("length 100 in 24x24, seed %d: %u\n", run + 1, maze.length);
+			return 1;
+		}
+	}
+	printf("24x24 with a way of 100 cells: %d/%d\n", runs, runs);
+	printf("maze_t: %u bytes, carving: %u bytes, maze_view_t: %u bytes\n", (unsigned int) sizeof(maze_t),
+			(unsigned int) (MAZE_MAX * MAZE_MAX + 7) / 8, (unsigned int) sizeof(maze_view_t));
+
+	printf("\n%-7s %-8s %8s %10s %10s %12s %10s %10s\n", "size", "view", "frames", "ns/frame", "max ns",
+			"blocks/frame", "scrolls", "rows/frame");
+
+	for (i = 0; i < sizeof(sizes); i++) {
+		static maze_view_t view;
+		uint8_t size = sizes[i];
+		int full;
+
+		maze_generate(&maze, size, size, 0, 1);
+
+		for (full = 0; full <= 1; full++) {
+			maze_view_stats_t before, after;
+			uint64_t ns = 0, max_ns = 0;
+			uint32_t frames = 0;
+
+			maze_view_get_stats(&before);
+			for (run = 0; run < runs / 100 + 1; run++) {
+				frames += walk(&maze, &view, full, &ns, &max_ns);
+			}
+			maze_view_get_stats(&after);
+
+			printf("%2ux%-4u %-8s %8u %10.0f %10llu %12.1f %10u %10.1f\n", size, size, full ? "full" : "scrolled",
+					frames, (double) ns / frames, (unsigned long long) max_ns,
+					(double) (after.blocks - before.blocks) / frames, after.scrolls - before.scrolls,
+					(double) (after.rows - before.rows) / frames);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,971 @@
+/*
+ * Host stand-in for the parts of TI-RTOS the firmware uses: tasks,
+ * clocks, mailboxes, semaphores, BIOS_start and System. Tasks and the
+ * clock service run as POSIX threads in real time, serialized by the
+ * simulated CPU lock.
+ *
+ * With SIM_VIRTUAL set, the same firmware runs in virtual time instead:
+ * BIOS_start becomes a discrete-event kernel. It hands the CPU to one
+ * ready task at a time (the highest priority, the longest waiting first)
+ * and takes it back when the task blocks; with every task blocked it
+ * runs the due clock functions and script events and the idle functions,
+ * and jumps the clock to the next deadline. Code takes no device time,
+ * nothing depends on the wall clock and the backend is the in-process
+ * one (host/backend.c), so a run is the same every time for the same
+ * SIM_SEED, and minutes of device time take a fraction of a second.
+ *
+ * One process is one SensorTag: the firmware keeps its state in
+ * globals, so host/Swarm.py starts a process per simulated device.
+ *
+ * Build a simulated device from the repository root:
+ *   gcc -std=c99 -O2 -Ihost/include -I. *.c host/comm_lib.c host/rtos.c \
+ *       host/drivers.c host/script.c host/backend.c -lpthread -lm -o sim_device
+ *
+ * Environment variables:
+ *   SIM_DURATION  seconds of device time to run (default 10).
+ *   SIM_TRACE     input script (see host/script.c).
+ *   SIM_SEED      per-device seed for the script jitter.
+ *   SIM_VERBOSE   echo System_printf output.
+ *   SIM_VIRTUAL   run in virtual time, against the in-process backend.
+ *   SIM_TRACE_DUMP  file for the System_putch output: the binary trace
+ *                 log, drained by the idle loop (host/Trace_decoder.py).
+ *   SIM_BUZZER    file for the buzzer timeline (host/Sound_renderer.py).
+ */
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Mailbox.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Swi.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include "wireless/comm_lib.h"
+#include "events.h"
+#include "fsm.h"
+#include "input.h"
+#include "latency.h"
+#include "monitor.h"
+#include "music.h"
+#include "link.h"
+#include "maze_view.h"
+#include "power.h"
+#include "radio.h"
+#include "session.h"
+#include "sfx.h"
+#include "trace.h"
+#include "timer.h"
+#include "sim.h"
+
+#define MAX_TASKS  8
+#define MAX_CLOCKS 16
+#define MAX_MAILBOXES 4
+#define MAX_SEMAPHORES 4
+
+// Host stacks: the firmware's TASKSTACKSIZE is too small for the C
+// library here. Filled like the kernel does, so Task_stat can measure.
+#define HOST_STACK_SIZE (256 * 1024)
+#define STACK_FILL 0xBE
+
+const uint32_t Clock_tickPeriod = 10; // Same 10 us tick as the SensorTag.
+
+struct Task_Object {
+	Task_FuncPtr fxn;
+	UArg arg0;
+	UArg arg1;
+	Int priority;
+	pthread_t thread;
+	uint8_t *stack;
+	// Virtual time: what the task waits for, and when it last ran.
+	uint64_t wake_at;
+	struct Mailbox_Object *mailbox;
+	struct Semaphore_Object *semaphore;
+	uint32_t last_run;
+	uint8_t done;
+};
+
+struct Clock_Object {
+	Clock_FuncPtr fxn;
+	UArg arg;
+	uint32_t timeout; // Ticks until the first expiry.
+	uint32_t period; // Ticks between expiries, 0 for one-shot.
+	uint8_t active;
+	uint64_t deadline; // Microseconds.
+};
+
+struct Mailbox_Object {
+	uint8_t *queue;
+	SizeT size; // Bytes per message.
+	UInt length; // Messages the queue holds.
+	UInt head;
+	UInt count;
+	pthread_cond_t posted;
+};
+
+struct Semaphore_Object {
+	Int count;
+	Semaphore_Mode mode;
+	pthread_cond_t posted;
+};
+
+static struct Task_Object tasks[MAX_TASKS];
+static uint8_t task_count = 0;
+
+static struct Clock_Object clocks[MAX_CLOCKS];
+static uint8_t clock_count = 0;
+
+static struct Mailbox_Object mailboxes[MAX_MAILBOXES];
+static uint8_t mailbox_count = 0;
+
+static struct Semaphore_Object semaphores[MAX_SEMAPHORES];
+static uint8_t semaphore_count = 0;
+
+static pthread_mutex_t cpu = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t clock_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t clock_cond = PTHREAD_COND_INITIALIZER;
+static uint32_t clock_generation = 0; // Bumped whenever a deadline may have moved.
+
+static struct timespec boot;
+static uint8_t verbose = 0;
+
+static uint64_t task_switches = 0;
+static uint64_t clock_fires = 0;
+
+static FILE *putch_file = NULL; // SIM_TRACE_DUMP.
+
+static __thread struct Task_Object *self = NULL; // The task of this thread, NULL for the rest.
+static struct Task_Object *running = NULL; // The task holding the CPU.
+
+Void monitor_switch(Task_Handle prev, Task_Handle next) __attribute__((weak));
+
+/*
+ * The CPU changes hands: call the Task switch hook like the kernel
+ * does. The clock service and the idle loop count as no task.
+ */
+static void switch_to(struct Task_Object *next) {
+	if (next == running) return;
+	if (monitor_switch) monitor_switch(running, next);
+	running = next;
+}
+
+void sim_lock(void) {
+	pthread_mutex_lock(&cpu);
+	switch_to(self);
+}
+
+void sim_unlock(void) {
+	switch_to(NULL);
+	pthread_mutex_unlock(&cpu);
+}
+
+/*
+ * Blocks on cond, giving the CPU away meanwhile.
+ */
+static int wait_cpu(pthread_cond_t *cond, const struct timespec *until) {
+	int result;
+
+	switch_to(NULL);
+	result = until ? pthread_cond_timedwait(cond, &cpu, until) : pthread_cond_wait(cond, &cpu);
+	switch_to(self);
+
+	return result;
+}
+
+/*
+ * Virtual time. The kernel is the thread in BIOS_start; turn says who
+ * holds the CPU, and whoever doesn't waits on turn_cond.
+ */
+static uint8_t virtual_time = 0;
+static uint64_t virtual_now = 0;
+static struct Task_Object *turn = NULL; // The task on the CPU, NULL for the kernel.
+static pthread_cond_t turn_cond = PTHREAD_COND_INITIALIZER;
+static uint32_t dispatches = 0;
+
+uint8_t sim_virtual(void) {
+	return virtual_time;
+}
+
+/*
+ * Gives the CPU back to the kernel until the task can go on: at wake_at,
+ * or earlier once the mailbox or the semaphore has something.
+ */
+static void block(uint64_t wake_at, struct Mailbox_Object *mailbox, struct Semaphore_Object *semaphore) {
+	struct Task_Object *task = self;
+
+	if (task == NULL) return; // Not a task: nothing to block.
+
+	task->wake_at = wake_at;
+	task->mailbox = mailbox;
+	task->semaphore = semaphore;
+
+	turn = NULL;
+	pthread_cond_broadcast(&turn_cond);
+	while (turn != task) pthread_cond_wait(&turn_cond, &cpu);
+
+	task->mailbox = NULL;
+	task->semaphore = NULL;
+}
+
+static uint64_t wall_us(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - boot.tv_sec) * 1000000ull + (now.tv_nsec - boot.tv_nsec) / 1000;
+}
+
+uint64_t sim_now_us(void) {
+	return virtual_time ? virtual_now : wall_us();
+}
+
+static void sleep_us(uint64_t us) {
+	struct timespec ts = {us / 1000000, (us % 1000000) * 1000};
+	while (nanosleep(&ts, &ts) != 0);
+}
+
+void sim_idle(uint32_t us) {
+	if (virtual_time) {
+		block(virtual_now + us, NULL, NULL);
+		return;
+	}
+
+	sim_unlock();
+	sleep_us(us);
+	sim_lock();
+}
+
+/*
+ * Tasks.
+ */
+void Task_Params_init(Task_Params *params) {
+	memset(params, 0, sizeof(*params));
+	params->priority = 1;
+}
+
+Task_Handle Task_create(Task_FuncPtr fxn, const Task_Params *params, void *eb) {
+	if (task_count >= MAX_TASKS) System_abort("Task_create: too many tasks");
+
+	struct Task_Object *task = &tasks[task_count++];
+	task->fxn = fxn;
+	task->arg0 = params ? params->arg0 : 0;
+	task->arg1 = params ? params->arg1 : 0;
+	task->priority = params ? params->priority : 1;
+
+	(void) eb;
+	return task;
+}
+
+void Task_sleep(uint32_t nticks) {
+	task_switches++;
+	sim_idle(nticks * Clock_tickPeriod);
+}
+
+/*
+ * The high-water mark: the fill pattern is intact below it.
+ */
+void Task_stat(Task_Handle handle, Task_Stat *statbuf) {
+	size_t free = 0;
+
+	while (free < HOST_STACK_SIZE && handle->stack[free] == STACK_FILL) free++;
+
+	statbuf->priority = handle->priority;
+	statbuf->stack = handle->stack;
+	statbuf->stackSize = HOST_STACK_SIZE;
+	statbuf->sp = NULL;
+	statbuf->used = HOST_STACK_SIZE - free;
+}
+
+/*
+ * Tasks only switch at Task_sleep and the other blocking calls here, so
+ * holding the CPU already keeps the scheduler away.
+ */
+UInt Task_disable(void) {
+	return 0;
+}
+
+void Task_restore(UInt key) {
+	(void) key;
+}
+
+/*
+ * Clock functions run with the CPU held too, so they can't interrupt a
+ * task either.
+ */
+UInt Swi_disable(void) {
+	return 0;
+}
+
+void Swi_restore(UInt key) {
+	(void) key;
+}
+
+/*
+ * And so do the pin callbacks.
+ */
+UInt Hwi_disable(void) {
+	return 0;
+}
+
+void Hwi_restore(UInt key) {
+	(void) key;
+}
+
+static void *task_main(void *arg) {
+	struct Task_Object *task = arg;
+
+	self = task;
+
+	if (virtual_time) {
+		pthread_mutex_lock(&cpu);
+		while (turn != task) pthread_cond_wait(&turn_cond, &cpu);
+
+		task->fxn(task->arg0, task->arg1);
+
+		task->done = 1;
+		turn = NULL;
+		pthread_cond_broadcast(&turn_cond);
+		pthread_mutex_unlock(&cpu);
+
+		return NULL;
+	}
+
+	sim_lock();
+	task->fxn(task->arg0, task->arg1);
+	sim_unlock();
+
+	return NULL;
+}
+
+/*
+ * Mailboxes. A pending task waits on the CPU lock's condition, so it
+ * gives the CPU away exactly like a blocked task on the device.
+ */
+void Mailbox_Params_init(Mailbox_Params *params) {
+	memset(params, 0, sizeof(*params));
+}
+
+Mailbox_Handle Mailbox_create(SizeT msgSize, UInt numMsgs, const Mailbox_Params *params, void *eb) {
+	if (mailbox_count >= MAX_MAILBOXES) System_abort("Mailbox_create: too many mailboxes");
+
+	struct Mailbox_Object *mbx = &mailboxes[mailbox_count++];
+	mbx->queue = malloc(msgSize * numMsgs);
+	mbx->size = msgSize;
+	mbx->length = numMsgs;
+	pthread_cond_init(&mbx->posted, NULL);
+
+	(void) params;
+	(void) eb;
+	return mbx;
+}
+
+/*
+ * Only BIOS_NO_WAIT posts: a full mailbox returns FALSE at once.
+ */
+Bool Mailbox_post(Mailbox_Handle handle, Ptr msg, UInt32 timeout) {
+	(void) timeout;
+
+	if (handle->count == handle->length) return FALSE;
+
+	memcpy(handle->queue + ((handle->head + handle->count) % handle->length) * handle->size, msg, handle->size);
+	handle->count++;
+	pthread_cond_signal(&handle->posted);
+
+	return TRUE;
+}
+
+Bool Mailbox_pend(Mailbox_Handle handle, Ptr msg, UInt32 timeout) {
+	struct timespec until;
+	uint64_t us = (uint64_t) timeout * Clock_tickPeriod;
+
+	if (handle->count == 0 && timeout != BIOS_NO_WAIT && virtual_time) {
+		task_switches++;
+		block(timeout == BIOS_WAIT_FOREVER ? UINT64_MAX : virtual_now + us, handle, NULL);
+	} else if (handle->count == 0 && timeout != BIOS_NO_WAIT) {
+		task_switches++;
+
+		clock_gettime(CLOCK_REALTIME, &until);
+		until.tv_nsec += (us % 1000000) * 1000;
+		until.tv_sec += us / 1000000 + until.tv_nsec / 1000000000;
+		until.tv_nsec %= 1000000000;
+
+		while (handle->count == 0) {
+			if (wait_cpu(&handle->posted, timeout == BIOS_WAIT_FOREVER ? NULL : &until) != 0) {
+				break;
+			}
+		}
+	}
+
+	if (handle->count == 0) return FALSE;
+
+	memcpy(msg, handle->queue + handle->head * handle->size, handle->size);
+	handle->head = (handle->head + 1) % handle->length;
+	handle->count--;
+
+	return TRUE;
+}
+
+Int Mailbox_getNumPendingMsgs(Mailbox_Handle handle) {
+	return handle->count;
+}
+
+/*
+ * Semaphores, pended on like the mailboxes.
+ */
+void Semaphore_Params_init(Semaphore_Params *params) {
+	memset(params, 0, sizeof(*params));
+	params->mode = Semaphore_Mode_COUNTING;
+}
+
+Semaphore_Handle Semaphore_create(Int count, const Semaphore_Params *params, void *eb) {
+	if (semaphore_count >= MAX_SEMAPHORES) System_abort("Semaphore_create: too many semaphores");
+
+	struct Semaphore_Object *sem = &semaphores[semaphore_count++];
+	sem->mode = params ? params->mode : Semaphore_Mode_COUNTING;
+	sem->count = sem->mode == Semaphore_Mode_BINARY && count > 1 ? 1 : count;
+	pthread_cond_init(&sem->posted, NULL);
+
+	(void) eb;
+	return sem;
+}
+
+void Semaphore_post(Semaphore_Handle handle) {
+	if (handle->mode == Semaphore_Mode_BINARY) {
+		handle->count = 1;
+	} else {
+		handle->count++;
+	}
+
+	pthread_cond_signal(&handle->posted);
+}
+
+Bool Semaphore_pend(Semaphore_Handle handle, UInt32 timeout) {
+	struct timespec until;
+	uint64_t us = (uint64_t) timeout * Clock_tickPeriod;
+
+	if (handle->count == 0 && timeout != BIOS_NO_WAIT && virtual_time) {
+		task_switches++;
+		block(timeout == BIOS_WAIT_FOREVER ? UINT64_MAX : virtual_now + us, NULL, handle);
+	} else if (handle->count == 0 && timeout != BIOS_NO_WAIT) {
+		task_switches++;
+
+		clock_gettime(CLOCK_REALTIME, &until);
+		until.tv_nsec += (us % 1000000) * 1000;
+		until.tv_sec += us / 1000000 + until.tv_nsec / 1000000000;
+		until.tv_nsec %= 1000000000;
+
+		while (handle->count == 0) {
+			if (wait_cpu(&handle->posted, timeout == BIOS_WAIT_FOREVER ? NULL : &until) != 0) {
+				break;
+			}
+		}
+	}
+
+	if (handle->count == 0) return FALSE;
+
+	handle->count--;
+	return TRUE;
+}
+
+/*
+ * Clocks.
+ */
+static void clock_kick(void) {
+	pthread_mutex_lock(&clock_mutex);
+	clock_generation++;
+	pthread_cond_signal(&clock_cond);
+	pthread_mutex_unlock(&clock_mutex);
+}
+
+void Clock_Params_init(Clock_Params *params) {
+	memset(params, 0, sizeof(*params));
+}
+
+Clock_Handle Clock_create(Clock_FuncPtr clockFxn, uint32_t timeout, const Clock_Params *params, void *eb) {
+	if (clock_count >= MAX_CLOCKS) System_abort("Clock_create: too many clocks");
+
+	struct Clock_Object *clk = &clocks[clock_count++];
+	clk->fxn = clockFxn;
+	clk->timeout = timeout;
+	clk->period = params ? params->period : 0;
+	clk->arg = params ? params->arg : 0;
+
+	if (params && params->startFlag) Clock_start(clk);
+
+	(void) eb;
+	return clk;
+}
+
+void Clock_start(Clock_Handle handle) {
+	handle->deadline = sim_now_us() + (uint64_t) handle->timeout * Clock_tickPeriod;
+	handle->active = 1;
+	clock_kick();
+}
+
+void Clock_stop(Clock_Handle handle) {
+	handle->active = 0;
+}
+
+void Clock_setTimeout(Clock_Handle handle, uint32_t timeout) {
+	handle->timeout = timeout; // Takes effect at the next Clock_start.
+}
+
+uint32_t Clock_getTicks(void) {
+	return sim_now_us() / Clock_tickPeriod;
+}
+
+/*
+ * Runs the expired clock functions; the caller holds the CPU, as the
+ * Clock Swi would. Returns the next deadline, UINT64_MAX if none.
+ */
+static uint64_t clock_run(void) {
+	uint64_t next = UINT64_MAX;
+	uint8_t i;
+
+	for (i = 0; i < clock_count; i++) {
+		struct Clock_Object *clk = &clocks[i];
+
+		if (clk->active && clk->deadline <= sim_now_us()) {
+			if (clk->period) {
+				clk->deadline += (uint64_t) clk->period * Clock_tickPeriod;
+			} else {
+				clk->active = 0;
+			}
+
+			clock_fires++;
+			clk->fxn(clk->arg);
+		}
+
+		if (clk->active && clk->deadline < next) next = clk->deadline;
+	}
+
+	return next;
+}
+
+/*
+ * Clock service: runs the expired clock functions, then sleeps until
+ * the next deadline or a Clock_start.
+ */
+static void *clock_main(void *arg) {
+	(void) arg;
+
+	while (1) {
+		uint64_t next;
+		uint32_t generation;
+
+		sim_lock();
+
+		pthread_mutex_lock(&clock_mutex);
+		generation = clock_generation;
+		pthread_mutex_unlock(&clock_mutex);
+
+		next = clock_run();
+
+		sim_unlock();
+
+		pthread_mutex_lock(&clock_mutex);
+
+		if (generation == clock_generation) {
+			if (next == UINT64_MAX) {
+				pthread_cond_wait(&clock_cond, &clock_mutex);
+			} else {
+				uint64_t wait = next > sim_now_us() ? next - sim_now_us() : 0;
+				struct timespec until;
+
+				clock_gettime(CLOCK_REALTIME, &until);
+				until.tv_nsec += (wait % 1000000) * 1000;
+				until.tv_sec += wait / 1000000 + until.tv_nsec / 1000000000;
+				until.tv_nsec %= 1000000000;
+
+				pthread_cond_timedwait(&clock_cond, &clock_mutex, &until);
+			}
+		}
+
+		pthread_mutex_unlock(&clock_mutex);
+	}
+
+	return NULL;
+}
+
+/*
+ * Idle task: on the device the idle functions of the .cfg run whenever
+ * nothing else is ready. Here they get the CPU every IDLE_PERIOD_US.
+ */
+#define IDLE_PERIOD_US 10000
+
+void trace_drain(void) __attribute__((weak));
+
+static void *idle_main(void *arg) {
+	(void) arg;
+
+	while (1) {
+		sleep_us(IDLE_PERIOD_US);
+
+		sim_lock();
+		if (trace_drain) trace_drain();
+		sim_unlock();
+	}
+
+	return NULL;
+}
+
+/*
+ * The virtual-time kernel. Holds the CPU whenever no task does.
+ */
+static struct Task_Object *ready(void) {
+	struct Task_Object *best = NULL;
+	uint8_t i;
+
+	for (i = 0; i < task_count; i++) {
+		struct Task_Object *task = &tasks[i];
+
+		if (task->done) continue;
+
+		if (virtual_now < task->wake_at && !(task->mailbox && task->mailbox->count)
+				&& !(task->semaphore && task->semaphore->count > 0)) {
+			continue; // Still waiting.
+		}
+
+		if (best == NULL || task->priority > best->priority
+				|| (task->priority == best->priority && task->last_run < best->last_run)) {
+			best = task;
+		}
+	}
+
+	return best;
+}
+
+static void dispatch(struct Task_Object *task) {
+	task->last_run = ++dispatches;
+	switch_to(task);
+
+	turn = task;
+	pthread_cond_broadcast(&turn_cond);
+	while (turn != NULL) pthread_cond_wait(&turn_cond, &cpu);
+
+	switch_to(NULL);
+}
+
+static void virtual_run(uint64_t end) {
+	struct Task_Object *task;
+	uint64_t next;
+	uint8_t i;
+
+	while (1) {
+		if ((task = ready()) != NULL) {
+			dispatch(task);
+			continue;
+		}
+
+		if (trace_drain) trace_drain(); // Nothing to do: the idle task.
+
+		next = clock_run(); // Due ones first, then the earliest of everything.
+		if (script_due() < next) next = script_due();
+
+		for (i = 0; i < task_count; i++) {
+			if (!tasks[i].done && tasks[i].wake_at < next) next = tasks[i].wake_at;
+		}
+
+		if (next > virtual_now) {
+			if (next > end) break;
+			virtual_now = next;
+		}
+
+		clock_run();
+		while (script_due() <= virtual_now) script_step();
+	}
+
+	virtual_now = end;
+}
+
+/*
+ * BIOS.
+ */
+void link_get_stats(link_stats_t *stats) __attribute__((weak));
+void radio_get_stats(radio_stats_t *stats) __attribute__((weak));
+void session_get_stats(session_stats_t *stats) __attribute__((weak));
+void events_get_stats(event_stats_t *stats) __attribute__((weak));
+void power_get_stats(power_stats_t *stats) __attribute__((weak));
+uint8_t fsm_get_trace(fsm_trace_t *out, uint32_t *total) __attribute__((weak));
+const char *fsm_name(uint8_t state) __attribute__((weak));
+void timer_get_stats(timer_stats_t *stats) __attribute__((weak));
+void input_get_stats(input_stats_t *stats) __attribute__((weak));
+void latency_get_stats(latency_stats_t *stats) __attribute__((weak));
+void trace_get_stats(trace_stats_t *stats) __attribute__((weak));
+void backend_report(FILE *out) __attribute__((weak));
+void monitor_get_stats(monitor_stats_t *stats) __attribute__((weak));
+void music_get_stats(music_stats_t *stats) __attribute__((weak));
+void sfx_get_stats(sfx_stats_t *stats) __attribute__((weak));
+void maze_view_get_stats(maze_view_stats_t *stats) __attribute__((weak));
+
+static void report_array(FILE *out, const char *name, const uint32_t *values, uint8_t n) {
+	uint8_t i;
+
+	fprintf(out, ", \"%s\": [", name);
+	for (i = 0; i < n; i++) {
+		fprintf(out, i ? ", %u" : "%u", values[i]);
+	}
+	fprintf(out, "]");
+}
+
+void sim_report(FILE *out) {
+	link_stats_t link;
+	radio_stats_t radio;
+	session_stats_t session;
+	event_stats_t events;
+	power_stats_t power;
+	timer_stats_t timer;
+	input_stats_t input;
+	latency_stats_t latency;
+	trace_stats_t tracelog;
+	monitor_stats_t monitor;
+	music_stats_t music;
+	sfx_stats_t sfx;
+	maze_view_stats_t view;
+	fsm_trace_t trace[FSM_TRACE_SIZE];
+	uint32_t transitions;
+	comm_stats_t comm;
+	const uint32_t *rtts;
+	uint32_t n;
+	uint32_t i;
+
+	comm_get_stats(&comm);
+
+	fprintf(out, "SIMSTATS {\"uptime_us\": %llu, \"virtual\": %u, \"wall_us\": %llu, "
+			"\"tx\": %u, \"tx_bytes\": %u, \"rx\": %u, \"rx_missed\": %u, "
+			"\"task_switches\": %llu, \"clock_fires\": %llu, ",
+			(unsigned long long) sim_now_us(), virtual_time, (unsigned long long) wall_us(),
+			comm.tx_frames, comm.tx_bytes, comm.rx_frames, comm.rx_missed,
+			(unsigned long long) task_switches, (unsigned long long) clock_fires);
+	sim_driver_report(out);
+	if (virtual_time && backend_report) backend_report(out);
+
+	if (link_get_stats) {
+		link_get_stats(&link);
+		fprintf(out, ", \"link\": {\"queued\": %u, \"delivered\": %u, \"failed\": %u, \"dropped\": %u, "
+				"\"transmissions\": %u, \"retransmissions\": %u, \"duplicate_acks\": %u, "
+				"\"latency_ms_sum\": %u, \"latency_ms_max\": %u}",
+				link.queued, link.delivered, link.failed, link.dropped, link.transmissions,
+				link.retransmissions, link.duplicate_acks, link.latency_ms_sum, link.latency_ms_max);
+	}
+
+	if (radio_get_stats) {
+		radio_get_stats(&radio);
+		fprintf(out, ", \"radio\": {\"rx_starts\": %u", radio.rx_starts);
+		report_array(out, "rx_on_ms", radio.rx_on_ms, RADIO_STATES);
+		report_array(out, "state_ms", radio.state_ms, RADIO_STATES);
+		report_array(out, "tx_frames", radio.tx_frames, RADIO_STATES);
+		fprintf(out, "}");
+	}
+
+	if (session_get_stats) {
+		session_get_stats(&session);
+		fprintf(out, ", \"session\": {\"sessions\": %u, \"uploaded\": %u, \"discarded\": %u, "
+				"\"moves\": %u, \"fragments\": %u, \"bytes\": %u}",
+				session.sessions, session.uploaded, session.discarded, session.moves,
+				session.fragments, session.bytes);
+	}
+
+	if (events_get_stats) {
+		events_get_stats(&events);
+		fprintf(out, ", \"events\": {\"posted\": %u, \"dropped\": %u, \"stale\": %u, "
+				"\"latency_us_sum\": %u, \"latency_us_max\": %u}",
+				events.posted, events.dropped, events.stale, events.latency_us_sum, events.latency_us_max);
+	}
+
+	if (power_get_stats) {
+		power_get_stats(&power);
+		fprintf(out, ", \"power\": {\"task_wakeups\": [%u, %u, %u]", power.task_wakeups[POWER_UI],
+				power.task_wakeups[POWER_SENSOR], power.task_wakeups[POWER_COMM]);
+		report_array(out, "wakeups", power.wakeups, POWER_STATES);
+		report_array(out, "active_ms", power.active_ms, POWER_STATES);
+		report_array(out, "idle_ms", power.idle_ms, POWER_STATES);
+		report_array(out, "current_ua", power.current_ua, POWER_STATES);
+		fprintf(out, "}");
+	}
+
+	if (timer_get_stats) {
+		timer_get_stats(&timer);
+		fprintf(out, ", \"timer\": {\"started\": %u, \"expired\": %u, \"swi_runs\": %u, \"ticks\": %u, "
+				"\"cascades\": %u, \"swi_us_sum\": %u, \"swi_us_max\": %u}",
+				timer.started, timer.expired, timer.swi_runs, timer.ticks, timer.cascades,
+				timer.swi_us_sum, timer.swi_us_max);
+	}
+
+	if (input_get_stats) {
+		input_get_stats(&input);
+		fprintf(out, ", \"input\": {\"gestures\": %u", input.gestures);
+		report_array(out, "presses", input.presses, INPUT_BUTTONS);
+		report_array(out, "releases", input.releases, INPUT_BUTTONS);
+		report_array(out, "long_presses", input.long_presses, INPUT_BUTTONS);
+		report_array(out, "repeats", input.repeats, INPUT_BUTTONS);
+		report_array(out, "edges", input.edges, INPUT_BUTTONS);
+		report_array(out, "bounces", input.bounces, INPUT_BUTTONS);
+		fprintf(out, ", \"dropped\": %u, \"handled\": %u, \"button_us_sum\": %u, \"button_us_max\": %u, "
+				"\"motion_us_sum\": %u, \"motion_us_max\": %u}",
+				input.dropped, input.handled, input.button_us_sum, input.button_us_max,
+				input.motion_us_sum, input.motion_us_max);
+	}
+
+	if (latency_get_stats) {
+		latency_get_stats(&latency);
+		fprintf(out, ", \"latency\": {\"samples\": %u", latency.samples);
+		report_array(out, "histogram", latency.histogram, LATENCY_BUCKETS);
+		fprintf(out, ", \"queue_us_sum\": %u, \"wait_us_sum\": %u, \"draw_us_sum\": %u, "
+				"\"total_us_max\": %u, \"dumps\": %u}",
+				latency.queue_us_sum, latency.wait_us_sum, latency.draw_us_sum,
+				latency.total_us_max, latency.dumps);
+	}
+
+	if (trace_get_stats) {
+		trace_get_stats(&tracelog);
+		fprintf(out, ", \"tracelog\": {\"logged\": %u, \"dropped\": %u, \"drained\": %u, \"max_used\": %u}",
+				tracelog.logged, tracelog.dropped, tracelog.drained, tracelog.max_used);
+	}
+
+	if (music_get_stats) {
+		music_get_stats(&music);
+		fprintf(out, ", \"music\": {\"songs\": %u, \"steps\": %u, \"late\": %u, \"late_ms_max\": %u}",
+				music.songs, music.steps, music.late, music.late_ms_max);
+	}
+
+	if (sfx_get_stats) {
+		sfx_get_stats(&sfx);
+		fprintf(out, ", \"sfx\": {\"played\": %u, \"preempted\": %u, \"dropped\": %u, \"ducked\": %u, \"opens\": %u}",
+				sfx.played, sfx.preempted, sfx.dropped, sfx.ducked, sfx.opens);
+	}
+
+	if (maze_view_get_stats) {
+		maze_view_get_stats(&view);
+		fprintf(out, ", \"maze_view\": {\"frames\": %u, \"scrolls\": %u, \"blocks\": %u, \"rows\": %u}",
+				view.frames, view.scrolls, view.blocks, view.rows);
+	}
+
+	if (monitor_get_stats) {
+		monitor_get_stats(&monitor);
+		fprintf(out, ", \"monitor\": {\"updates\": %u, \"tasks\": [", monitor.updates);
+		for (i = 0; i < MONITOR_TASKS; i++) {
+			const monitor_task_t *task = &monitor.tasks[i];
+
+			fprintf(out, "%s{\"name\": \"%s\", \"cpu_ms\": %u, \"switches\": %u, "
+					"\"stack_used\": %u, \"stack_size\": %u}", i ? ", " : "", task->name ? task->name : "",
+					task->cpu_ticks / (1000 / Clock_tickPeriod), task->switches,
+					(unsigned int) task->stack_used, (unsigned int) task->stack_size);
+		}
+		fprintf(out, "]}");
+	}
+
+	if (fsm_get_trace && fsm_name) {
+		n = fsm_get_trace(trace, &transitions);
+		fprintf(out, ", \"transitions\": %u, \"trace\": [", transitions);
+		for (i = 0; i < n; i++) {
+			fprintf(out, "%s[%u, \"%s\", \"%s\", %u]", i ? ", " : "",
+					trace[i].ticks / (1000 / Clock_tickPeriod), fsm_name(trace[i].from),
+					fsm_name(trace[i].to), trace[i].cause);
+		}
+		fprintf(out, "]");
+	}
+
+	n = comm_get_rtts(&rtts);
+
+	fprintf(out, ", \"rtt_us\": [");
+
+	for (i = 0; i < n; i++) {
+		fprintf(out, i ? ", %u" : "%u", rtts[i]);
+	}
+
+	fprintf(out, "]}\n");
+	fflush(out);
+}
+
+void BIOS_start(void) {
+	const char *env = getenv("SIM_DURATION");
+	double duration = env ? atof(env) : 10.0;
+	pthread_t clock_thread;
+	pthread_t idle_thread;
+	uint8_t i;
+
+	if (virtual_time) sim_lock(); // The kernel holds the CPU from the start.
+
+	for (i = 0; i < task_count; i++) {
+		pthread_attr_t attr;
+
+		tasks[i].stack = malloc(HOST_STACK_SIZE);
+		memset(tasks[i].stack, STACK_FILL, HOST_STACK_SIZE);
+
+		pthread_attr_init(&attr);
+		pthread_attr_setstack(&attr, tasks[i].stack, HOST_STACK_SIZE);
+		pthread_create(&tasks[i].thread, &attr, task_main, &tasks[i]);
+		pthread_attr_destroy(&attr);
+	}
+
+	if (virtual_time) {
+		script_start(0);
+		virtual_run(duration * 1e6); // Freezes the firmware at the end.
+	} else {
+		pthread_create(&clock_thread, NULL, clock_main, NULL);
+		pthread_create(&idle_thread, NULL, idle_main, NULL);
+		script_start(1);
+
+		sleep_us(duration * 1e6);
+
+		sim_lock(); // Freeze the firmware...
+	}
+
+	if (trace_drain) trace_drain(); // ...write out the rest of the trace log...
+	if (putch_file) fclose(putch_file);
+	sim_report(stdout); // ...and report.
+	exit(0);
+}
+
+/*
+ * System.
+ */
+int System_printf(const char *fmt, ...) {
+	va_list args;
+	int n = 0;
+
+	if (verbose) {
+		va_start(args, fmt);
+		n = vprintf(fmt, args);
+		va_end(args);
+	}
+
+	return n;
+}
+
+void System_flush(void) {
+	if (verbose) fflush(stdout);
+}
+
+void System_putch(Char ch) {
+	if (putch_file) fputc(ch, putch_file);
+}
+
+void System_abort(const char *str) {
+	fprintf(stderr, "System_abort: %s\n", str);
+	exit(1);
+}
+
+/*
+ * Runs before the firmware's main(): Clock_getTicks is used for srand
+ * before BIOS_start, so the time base has to exist already.
+ */
+__attribute__((constructor)) static void rtos_init(void) {
+	clock_gettime(CLOCK_MONOTONIC, &boot);
+	verbose = getenv("SIM_VERBOSE") != NULL;
+	virtual_time = getenv("SIM_VIRTUAL") != NULL && strcmp(getenv("SIM_VIRTUAL"), "0") != 0;
+
+	if (getenv("SIM_TRACE_DUMP")) {
+		putch_file = fopen(getenv("SIM_TRACE_DUMP"), "wb");
+		if (putch_file == NULL) perror(getenv("SIM_TRACE_DUMP"));
+	}
+}
@@ -0,0 +1,206 @@
+/*
+ * Input script for the simulated device: replays a recorded trace of
+ * button presses, MPU samples and temperatures against the drivers.
+ *
+ * Trace format, one event per line, times in milliseconds since boot:
+ *   <ms> press <button 0|1> <hold ms> [bounces]  (contact bounce: that many 1 ms
+ *                                                 glitches after both edges)
+ *   <ms> mpu <ax> <ay> <az> <gx> <gy> <gz>   (g and deg/s, held until the next mpu line)
+ *   <ms> tmp <celsius>
+ *   <ms> loop                                (restart the trace from the top)
+ * Empty lines and lines starting with '#' are ignored.
+ *
+ * SIM_SEED shifts every event by up to SIM_JITTER ms (default 20) so
+ * that many devices replaying the same trace don't run in lockstep.
+ *
+ * In real time the script has a thread of its own; in virtual time
+ * (SIM_VIRTUAL, see host/rtos.c) the kernel calls script_due and
+ * script_step between the tasks instead.
+ */
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "Board.h"
+#include "sim.h"
+
+#define MAX_EVENTS 1024
+
+enum kind {PRESS=1, RELEASE, MPU, TMP, LOOP};
+
+typedef struct {
+	uint32_t ms;
+	enum kind kind;
+	float args[6];
+} event_t;
+
+static event_t events[MAX_EVENTS];
+static uint16_t event_count = 0;
+static unsigned int seed = 1;
+static uint32_t jitter = 20;
+
+static uint16_t next = 0; // The next event...
+static uint64_t next_due = UINT64_MAX; // ...and when, in microseconds.
+static uint64_t base = 0; // Start of the current pass.
+
+static int by_time(const void *a, const void *b) {
+	const event_t *x = a, *y = b;
+	return (x->ms > y->ms) - (x->ms < y->ms);
+}
+
+static void add(uint32_t ms, enum kind kind, const float *args, uint8_t n) {
+	if (event_count >= MAX_EVENTS) return;
+
+	events[event_count].ms = ms;
+	events[event_count].kind = kind;
+	memset(events[event_count].args, 0, sizeof(events[event_count].args));
+	if (n) memcpy(events[event_count].args, args, n * sizeof(float));
+	event_count++;
+}
+
+/*
+ * Reads the trace. Returns the number of events, 0 if there is none.
+ */
+static uint16_t load(const char *path) {
+	char line[160], cmd[16];
+	float args[6];
+	unsigned int ms;
+	int bounces;
+	int k;
+	FILE *f = fopen(path, "r");
+
+	if (f == NULL) {
+		perror(path);
+		return 0;
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+		if (line[0] == '#' || sscanf(line, "%u %15s", &ms, cmd) != 2) continue;
+
+		if (strcmp(cmd, "press") == 0 && sscanf(line, "%*u %*s %f %f", &args[0], &args[1]) == 2) {
+			if (sscanf(line, "%*u %*s %*f %*f %d", &bounces) != 1) bounces = 0;
+
+			add(ms, PRESS, args, 1);
+			add(ms + (uint32_t) args[1], RELEASE, args, 1);
+
+			for (k = 1; k <= bounces; k++) {
+				add(ms + 2 * k - 1, RELEASE, args, 1);
+				add(ms + 2 * k, PRESS, args, 1);
+				add(ms + (uint32_t) args[1] + 2 * k - 1, PRESS, args, 1);
+				add(ms + (uint32_t) args[1] + 2 * k, RELEASE, args, 1);
+			}
+		} else if (strcmp(cmd, "mpu") == 0 && sscanf(line, "%*u %*s %f %f %f %f %f %f",
+				&args[0], &args[1], &args[2], &args[3], &args[4], &args[5]) == 6) {
+			add(ms, MPU, args, 6);
+		} else if (strcmp(cmd, "tmp") == 0 && sscanf(line, "%*u %*s %f", &args[0]) == 1) {
+			add(ms, TMP, args, 1);
+		} else if (strcmp(cmd, "loop") == 0) {
+			add(ms, LOOP, NULL, 0);
+		} else {
+			line[strcspn(line, "\r\n")] = 0;
+			fprintf(stderr, "%s: ignoring '%s'\n", path, line);
+		}
+	}
+
+	fclose(f);
+	qsort(events, event_count, sizeof(event_t), by_time);
+
+	return event_count;
+}
+
+static void apply(const event_t *e) {
+	PIN_Id pin = e->args[0] ? Board_BUTTON1 : Board_BUTTON0;
+
+	switch (e->kind) {
+		case PRESS:
+			sim_set_input(pin, 0); // Buttons are active low.
+			break;
+		case RELEASE:
+			sim_set_input(pin, 1);
+			break;
+		case MPU:
+			sim_set_mpu(e->args);
+			break;
+		case TMP:
+			sim_set_temp(e->args[0]);
+			break;
+		case LOOP:
+			break;
+	}
+}
+
+static void schedule(void) {
+	next_due = base + events[next].ms * 1000ull + (jitter ? rand_r(&seed) % (jitter * 1000) : 0);
+}
+
+/*
+ * When the next event is due, UINT64_MAX once the trace is over.
+ */
+uint64_t script_due(void) {
+	return next_due;
+}
+
+/*
+ * Applies the next event; the caller holds the CPU and the event is due.
+ */
+void script_step(void) {
+	if (next_due == UINT64_MAX) return;
+
+	if (events[next].kind == LOOP) {
+		base = sim_now_us(); // Start over.
+		next = 0;
+	} else {
+		apply(&events[next]);
+		next++;
+	}
+
+	if (next < event_count) {
+		schedule();
+	} else {
+		next_due = UINT64_MAX; // No loop: the trace is over.
+	}
+}
+
+static void *script_main(void *arg) {
+	(void) arg;
+
+	while (script_due() != UINT64_MAX) {
+		uint64_t now = sim_now_us();
+
+		if (script_due() > now) {
+			struct timespec ts = {(script_due() - now) / 1000000, ((script_due() - now) % 1000000) * 1000};
+			nanosleep(&ts, NULL);
+		}
+
+		sim_lock();
+		script_step();
+		sim_unlock();
+	}
+
+	return NULL;
+}
+
+/*
+ * Loads SIM_TRACE; with thread 1 the script runs on its own in real time.
+ */
+void script_start(uint8_t thread) {
+	const char *path = getenv("SIM_TRACE");
+	const char *env;
+	pthread_t script_thread;
+
+	env = getenv("SIM_SEED");
+	if (env) seed = strtoul(env, NULL, 0);
+
+	env = getenv("SIM_JITTER");
+	if (env) jitter = strtoul(env, NULL, 0);
+
+	if (path == NULL || load(path) == 0) return;
+
+	schedule();
+	if (thread) pthread_create(&script_thread, NULL, script_main, NULL);
+}
@@ -0,0 +1,46 @@
+/*
+ * Internal interface between the host stand-ins for TI-RTOS, the
+ * drivers and the input script. Not included by the firmware.
+ *
+ * The simulated device has one "CPU": firmware code (tasks, clock
+ * functions and pin callbacks) only runs while holding sim_lock, so
+ * the firmware globals see the same interleavings as on the
+ * single-core SensorTag, just without priority preemption.
+ *
+ * With SIM_VIRTUAL set the device runs in virtual time instead: a
+ * discrete-event kernel hands the CPU to one task at a time and jumps
+ * the clock to the next deadline whenever every task waits, so runs
+ * are repeatable and take a fraction of the device time.
+ */
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <ti/drivers/PIN.h>
+#include "wireless/comm_lib.h"
+
+void sim_lock(void);
+void sim_unlock(void);
+uint64_t sim_now_us(void); // Microseconds since BIOS_start.
+uint8_t sim_virtual(void); // 1 when running in virtual time.
+void sim_idle(uint32_t us); // Gives the CPU away for a while (busy-waiting tasks).
+void sim_report(FILE *out); // One SIMSTATS line for host/Swarm.py.
+
+// Drivers.
+void sim_set_input(PIN_Id pin, uint8_t level); // Runs the pin callback on a falling edge.
+void sim_set_mpu(const float sample[6]);
+void sim_set_temp(double celsius);
+void sim_driver_report(FILE *out);
+
+// Input script (SIM_TRACE).
+void script_start(uint8_t thread);
+uint64_t script_due(void); // When the next event is due, in microseconds.
+void script_step(void); // Applies it.
+
+// In-process backend for virtual time (host/backend.c).
+uint8_t backend_handle(uint16_t addr, const char *payload, char replies[][COMM_MAX_PAYLOAD + 1]);
+void backend_report(FILE *out);
+
+#endif
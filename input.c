@@ -0,0 +1,223 @@
+/*
+ * Input: the buttons and the motion gestures, on the event queue.
+ *
+ * Every button has a debounce state machine of its own, so a press on
+ * one no longer masks the other. An edge (either way) starts the
+ * button's debounce timer and every further edge restarts it; when the
+ * level has held for INPUT_DEBOUNCE_MS it is read and, if it differs
+ * from the last stable one, the press or release is posted with the
+ * time of the first edge. A button held down for INPUT_LONG_MS posts a
+ * long press and then repeats every INPUT_REPEAT_MS until released.
+ *
+ * The sensorTask posts its gestures through here too, stamped with the
+ * time of the sample, so uiTask sees both kinds in the order they
+ * happened and the latency from the interrupt (or the sample) to
+ * uiTask can be measured: uiTask calls input_handled for every event.
+ *
+ * input_edge runs in the pin callbacks (Hwi), the timers in the Clock
+ * Swi.
+ */
+
+#include <xdc/std.h>
+#include <inttypes.h>
+#include <string.h>
+
+// BIOS header files
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/hal/Hwi.h>
+
+// TI-RTOS header files
+#include <ti/drivers/PIN.h>
+
+// Board header files
+#include "Board.h"
+
+#include "events.h"
+#include "input.h"
+#include "timer.h"
+#include "trace.h"
+
+enum button_state {BUTTON_UP=0, BUTTON_DOWN, BUTTON_LONG};
+
+typedef struct {
+	uint8_t state; // The last stable level, and held long or not.
+	uint8_t settling; // Waiting for the level to settle after an edge.
+	uint32_t edge; // First edge since the level was stable.
+	uint32_t pressed; // When it went down.
+	swtimer_t debounce;
+	swtimer_t hold; // The long press and the repeats.
+} button_t;
+
+static const PIN_Id pins[INPUT_BUTTONS] = {Board_BUTTON0, Board_BUTTON1};
+static const uint8_t press_types[INPUT_BUTTONS] = {EV_BUTTON0, EV_BUTTON1};
+
+static button_t buttons[INPUT_BUTTONS];
+static input_stats_t stats;
+
+static void post(uint8_t type, uint8_t arg, int16_t x, uint32_t ticks) {
+	UInt key;
+
+	if (!event_post_at(type, arg, x, 0, ticks)) {
+		key = Hwi_disable();
+		stats.dropped++;
+		Hwi_restore(key);
+	}
+}
+
+/*
+ * Held down long enough: first the long press, then the repeats.
+ */
+static Void hold_clkFxn(UArg arg0) {
+	button_t *button = &buttons[arg0];
+	uint8_t type;
+	UInt key = Hwi_disable();
+
+	if (button->state == BUTTON_DOWN) {
+		button->state = BUTTON_LONG;
+		stats.long_presses[arg0]++;
+		type = EV_LONG_PRESS;
+	} else {
+		stats.repeats[arg0]++;
+		type = EV_REPEAT;
+	}
+
+	Hwi_restore(key);
+
+	post(type, arg0, 0, Clock_getTicks());
+}
+
+/*
+ * The level has held for the debounce time: see what it is now.
+ */
+static Void debounce_clkFxn(UArg arg0) {
+	button_t *button = &buttons[arg0];
+	uint8_t down = !PIN_getInputValue(pins[arg0]); // Pulled up: low is down.
+	uint8_t type = 0;
+	int16_t held = 0;
+	uint32_t ms;
+	uint32_t edge;
+	UInt key = Hwi_disable();
+
+	button->settling = 0;
+	edge = button->edge;
+
+	if (down && button->state == BUTTON_UP) {
+		button->state = BUTTON_DOWN;
+		button->pressed = button->edge;
+		stats.presses[arg0]++;
+		type = press_types[arg0];
+
+		// The long press counts from the edge, the debounce time is gone already.
+		timer_start(&button->hold, (Clock_FuncPtr) hold_clkFxn, arg0, INPUT_LONG_MS - INPUT_DEBOUNCE_MS, INPUT_REPEAT_MS);
+	} else if (!down && button->state != BUTTON_UP) {
+		button->state = BUTTON_UP;
+		stats.releases[arg0]++;
+		type = EV_RELEASE;
+		ms = (button->edge - button->pressed) / (1000 / Clock_tickPeriod);
+		held = ms > INT16_MAX ? INT16_MAX : (int16_t) ms; // Anything longer than 32.7 s is just long.
+
+		timer_stop(&button->hold);
+	} else { // Back where it was: only bounced.
+		stats.bounces[arg0]++;
+	}
+
+	Hwi_restore(key);
+
+	if (type) {
+		trace_log(TRACE_PRESS, arg0, type != EV_RELEASE);
+		post(type, type == EV_RELEASE ? arg0 : 0, held, edge);
+	}
+}
+
+/*
+ * Call from main before BIOS_start, after timer_init.
+ */
+void input_init() {
+	memset(buttons, 0, sizeof(buttons));
+	memset(&stats, 0, sizeof(stats));
+}
+
+/*
+ * Call from the pin callback of the button on every edge.
+ */
+void input_edge(uint8_t button) {
+	UInt key = Hwi_disable();
+
+	trace_log(TRACE_EDGE, button, 0);
+	stats.edges[button]++;
+
+	if (buttons[button].settling) {
+		stats.bounces[button]++; // Still bouncing: wait for it to settle again.
+	} else {
+		buttons[button].settling = 1;
+		buttons[button].edge = Clock_getTicks();
+	}
+
+	timer_start(&buttons[button].debounce, (Clock_FuncPtr) debounce_clkFxn, button, INPUT_DEBOUNCE_MS, 0);
+
+	Hwi_restore(key);
+}
+
+/*
+ * 1 while the button is down (debounced), for chords.
+ */
+uint8_t input_down(uint8_t button) {
+	return buttons[button].state != BUTTON_UP;
+}
+
+/*
+ * Posts a gesture the sensorTask detected in the sample taken at ticks.
+ */
+void input_motion(uint8_t type, uint8_t arg, int16_t x, int16_t y, uint32_t ticks) {
+	UInt key = Hwi_disable();
+	stats.gestures++;
+	Hwi_restore(key);
+
+	if (!event_post_at(type, arg, x, y, ticks)) {
+		key = Hwi_disable();
+		stats.dropped++;
+		Hwi_restore(key);
+	}
+}
+
+/*
+ * uiTask received the event: if it was an input, count its latency.
+ */
+void input_handled(const event_t *event) {
+	uint32_t latency = (Clock_getTicks() - event->ticks) * Clock_tickPeriod;
+	uint32_t *sum;
+	uint32_t *max;
+	UInt key;
+
+	switch (event->type) {
+		case EV_BUTTON0:
+		case EV_BUTTON1:
+		case EV_RELEASE:
+		case EV_LONG_PRESS:
+		case EV_REPEAT:
+			sum = &stats.button_us_sum;
+			max = &stats.button_us_max;
+			break;
+		case EV_MOVE:
+		case EV_MENU_NEXT:
+		case EV_MENU_SELECT:
+		case EV_TILT:
+			sum = &stats.motion_us_sum;
+			max = &stats.motion_us_max;
+			break;
+		default:
+			return;
+	}
+
+	key = Hwi_disable();
+	stats.handled++;
+	*sum += latency;
+	if (latency > *max) *max = latency;
+	Hwi_restore(key);
+}
+
+void input_get_stats(input_stats_t *out) {
+	UInt key = Hwi_disable();
+	*out = stats;
+	Hwi_restore(key);
+}
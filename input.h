@@ -0,0 +1,39 @@
+/*
+ * Buttons and motion gestures to uiTask.
+ */
+
+#ifndef INPUT_H_
+#define INPUT_H_
+
+#include <inttypes.h>
+#include "events.h"
+
+#define INPUT_BUTTONS 2
+#define INPUT_DEBOUNCE_MS 30 // A level has to hold this long to count.
+#define INPUT_LONG_MS 800 // Held this long: a long press...
+#define INPUT_REPEAT_MS 200 // ...and then a repeat this often.
+
+typedef struct {
+	uint32_t presses[INPUT_BUTTONS];
+	uint32_t releases[INPUT_BUTTONS];
+	uint32_t long_presses[INPUT_BUTTONS];
+	uint32_t repeats[INPUT_BUTTONS];
+	uint32_t edges[INPUT_BUTTONS]; // Interrupts, bounces included.
+	uint32_t bounces[INPUT_BUTTONS]; // Edges that came to nothing.
+	uint32_t gestures;
+	uint32_t dropped; // The event queue was full.
+	uint32_t handled; // Input events uiTask received.
+	uint32_t button_us_sum; // From the button edge to uiTask.
+	uint32_t button_us_max;
+	uint32_t motion_us_sum; // From the sensor sample to uiTask.
+	uint32_t motion_us_max;
+} input_stats_t;
+
+void input_init();
+void input_edge(uint8_t button);
+uint8_t input_down(uint8_t button);
+void input_motion(uint8_t type, uint8_t arg, int16_t x, int16_t y, uint32_t ticks);
+void input_handled(const event_t *event);
+void input_get_stats(input_stats_t *stats);
+
+#endif
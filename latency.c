@@ -0,0 +1,150 @@
+/*
+ * Input-to-display latency.
+ *
+ * A button edge or a gesture sample travels through the input timers
+ * or the sensorTask (input.c), the event queue, the handler in the
+ * state table, the update flag and finally the draw_* function of the
+ * state, which flushes the screen. uiTask stamps the path at three
+ * points, with nothing but a Clock_getTicks() each:
+ *  - latency_input, after the event was handled: if it asked for a
+ *    redraw (or moved to another state), the screen now owes it one;
+ *  - latency_draw, before the state's work runs with a redraw pending;
+ *  - latency_flush, at the end of the round, once the update flag is
+ *    clear: the screen shows the input.
+ * Several inputs before one redraw count once, from the first of them.
+ *
+ * The total goes into a histogram of power-of-two buckets, with the sums
+ * of the three stages beside it. Every LATENCY_DUMP_EVERY samples the
+ * new counts are sent to the backend ("lat:" and two hex digits per
+ * bucket), from the menu like the session uploads. The host simulator
+ * runs this same code, so its SIMSTATS show the same numbers.
+ *
+ * Everything here runs in uiTask.
+ */
+
+#include <xdc/std.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+// BIOS header files
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Task.h>
+
+#include "events.h"
+#include "latency.h"
+#include "link.h"
+
+static uint8_t pending = 0; // An input waits for the screen.
+static uint32_t input_ticks; // The edge or the sample.
+static uint32_t handled_ticks;
+static uint32_t draw_ticks;
+
+static uint32_t sent[LATENCY_BUCKETS]; // Counts already sent to the backend.
+static uint32_t unsent = 0; // Samples since the last dump.
+
+static latency_stats_t stats;
+
+static uint8_t bucket(uint32_t us) {
+	uint32_t ms = us / 1000;
+	uint8_t i = 0;
+
+	while (ms && i < LATENCY_BUCKETS - 1) {
+		ms >>= 1;
+		i++;
+	}
+
+	return i;
+}
+
+/*
+ * The event was handled; redraw is 1 if the screen has to change for it.
+ */
+void latency_input(const event_t *event, uint8_t redraw) {
+	switch (event->type) {
+		case EV_BUTTON0:
+		case EV_BUTTON1:
+		case EV_LONG_PRESS:
+		case EV_REPEAT:
+		case EV_MOVE:
+		case EV_MENU_NEXT:
+		case EV_MENU_SELECT:
+		case EV_TILT:
+			break;
+		default:
+			return; // Not an input, or one the screen doesn't follow (a release).
+	}
+
+	if (!redraw || pending) return;
+
+	pending = 1;
+	input_ticks = event->ticks;
+	handled_ticks = Clock_getTicks();
+	draw_ticks = handled_ticks; // Unless the drawing is left to the state's work.
+}
+
+/*
+ * The state's work is about to run; update is the redraw flag.
+ */
+void latency_draw(uint8_t update) {
+	if (pending && update) draw_ticks = Clock_getTicks();
+}
+
+/*
+ * The round is over; update is the redraw flag.
+ */
+void latency_flush(uint8_t update) {
+	uint32_t now;
+	uint32_t total;
+
+	if (!pending || update) return;
+
+	now = Clock_getTicks();
+	total = (now - input_ticks) * Clock_tickPeriod;
+
+	stats.samples++;
+	stats.histogram[bucket(total)]++;
+	stats.queue_us_sum += (handled_ticks - input_ticks) * Clock_tickPeriod;
+	stats.wait_us_sum += (draw_ticks - handled_ticks) * Clock_tickPeriod;
+	stats.draw_us_sum += (now - draw_ticks) * Clock_tickPeriod;
+	if (total > stats.total_us_max) stats.total_us_max = total;
+
+	unsent++;
+	pending = 0;
+}
+
+/*
+ * Sends the counts since the last dump once there are enough of them.
+ * Call regularly from uiTask; idle is 1 where the link is free for it.
+ */
+void latency_poll(uint8_t idle) {
+	char frame[4 + 2 * LATENCY_BUCKETS + 1];
+	uint32_t delta[LATENCY_BUCKETS];
+	uint8_t i;
+
+	if (!idle || unsent < LATENCY_DUMP_EVERY || link_space() <= 1) return;
+
+	strcpy(frame, "lat:");
+
+	for (i = 0; i < LATENCY_BUCKETS; i++) {
+		delta[i] = stats.histogram[i] - sent[i];
+		if (delta[i] > 0xFF) delta[i] = 0xFF; // The rest goes with the next dump.
+
+		sprintf(&frame[4 + 2 * i], "%02X", (unsigned int) delta[i]);
+	}
+
+	if (!link_send(frame)) return;
+
+	for (i = 0; i < LATENCY_BUCKETS; i++) {
+		sent[i] += delta[i];
+	}
+
+	stats.dumps++;
+	unsent = 0;
+}
+
+void latency_get_stats(latency_stats_t *out) {
+	UInt key = Task_disable();
+	*out = stats;
+	Task_restore(key);
+}
@@ -0,0 +1,32 @@
+/*
+ * Input-to-display latency, measured on the device.
+ */
+
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#include <inttypes.h>
+#include "events.h"
+
+// Bucket 0 is under 1 ms, bucket i from 2^(i-1) to 2^i ms, the last one
+// everything from 1024 ms up.
+#define LATENCY_BUCKETS 12
+#define LATENCY_DUMP_EVERY 32 // Samples per histogram sent to the backend.
+
+typedef struct {
+	uint32_t samples;
+	uint32_t histogram[LATENCY_BUCKETS];
+	uint32_t queue_us_sum; // From the edge or sample to the event handler.
+	uint32_t wait_us_sum; // From the handler to the start of the drawing.
+	uint32_t draw_us_sum; // Drawing and flushing the screen.
+	uint32_t total_us_max;
+	uint32_t dumps; // Histograms handed to the link.
+} latency_stats_t;
+
+void latency_input(const event_t *event, uint8_t redraw);
+void latency_draw(uint8_t update);
+void latency_flush(uint8_t update);
+void latency_poll(uint8_t idle);
+void latency_get_stats(latency_stats_t *stats);
+
+#endif
@@ -0,0 +1,192 @@
+/*
+ * A lightweight reliability layer on top of Send6LoWPAN.
+ *
+ * Every event gets an 8-bit sequence number appended to the payload
+ * ("event:LEFT#12") and stays at the head of a small queue until the
+ * backend answers "<addr>,ACK,12". Unacknowledged frames are resent
+ * with an exponential backoff and given up after LINK_MAX_TRIES.
+ *
+ * Only the head of the queue is ever in flight (stop-and-wait), so the
+ * backend sees the moves in the order they were made; it drops frames
+ * whose sequence number it has already seen and just acknowledges them
+ * again.
+ *
+ * link_send is called from uiTask (send_message), link_handle from
+ * commTask and link_poll from the uiTask loop, so the queue is only
+ * touched with the scheduler disabled.
+ */
+
+#include <xdc/std.h>
+#include <inttypes.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// BIOS header files
+#include <ti/sysbios/knl/Task.h>
+
+#include "wireless/comm_lib.h"
+#include "link.h"
+#include "radio.h"
+#include "timer.h"
+#include "trace.h"
+
+typedef struct {
+	char payload[LINK_PAYLOAD_SIZE];
+	uint8_t seq;
+	uint8_t tries;
+	uint32_t queued_ms;
+	uint32_t due_ms; // Next (re)transmission.
+} frame_t;
+
+static frame_t queue[LINK_QUEUE_SIZE];
+static uint8_t head = 0;
+static uint8_t count = 0;
+static uint8_t next_seq = 0;
+
+static link_stats_t stats;
+
+/*
+ * Resets the queue and the counters.
+ */
+void link_init() {
+	head = 0;
+	count = 0;
+	next_seq = 0;
+	memset(&stats, 0, sizeof(stats));
+}
+
+/*
+ * Queues a payload for delivery. Returns 1 if queued, 0 if the queue
+ * was full and the payload was dropped.
+ */
+uint8_t link_send(const char *payload) {
+	UInt key = Task_disable();
+	uint8_t ok = 0;
+
+	if (count < LINK_QUEUE_SIZE) {
+		frame_t *f = &queue[(head + count) % LINK_QUEUE_SIZE];
+
+		strncpy(f->payload, payload, LINK_PAYLOAD_SIZE - 1);
+		f->payload[LINK_PAYLOAD_SIZE - 1] = 0;
+		f->seq = next_seq++;
+		f->tries = 0;
+		f->queued_ms = timer_ms();
+		f->due_ms = f->queued_ms;
+
+		count++;
+		stats.queued++;
+		ok = 1;
+	} else {
+		stats.dropped++;
+	}
+
+	Task_restore(key);
+
+	return ok;
+}
+
+/*
+ * Transmits the head of the queue if it's due: for the first time, or
+ * again after its retransmit timeout. Call regularly from a task.
+ */
+void link_poll() {
+	char frame[LINK_PAYLOAD_SIZE + 5];
+	UInt key = Task_disable();
+	uint32_t now = timer_ms();
+	frame_t *f = &queue[head];
+
+	if (count == 0 || (int32_t) (now - f->due_ms) < 0) {
+		Task_restore(key);
+		return;
+	}
+
+#if LINK_RELIABLE
+	if (f->tries >= LINK_MAX_TRIES) { // Give up on this one.
+		stats.failed++;
+		head = (head + 1) % LINK_QUEUE_SIZE;
+		count--;
+		Task_restore(key);
+		return;
+	}
+
+	sprintf(frame, "%s#%u", f->payload, f->seq);
+
+	if (f->tries > 0) stats.retransmissions++;
+	f->due_ms = now + ((uint32_t) LINK_TIMEOUT_MS << f->tries); // Exponential backoff.
+	f->tries++;
+#else
+	strcpy(frame, f->payload); // Fire and forget.
+	stats.delivered++;
+	head = (head + 1) % LINK_QUEUE_SIZE;
+	count--;
+#endif
+
+	stats.transmissions++;
+	trace_log(TRACE_TX, f->seq, f->tries);
+	Task_restore(key);
+
+	Send6LoWPAN(IEEE80154_SERVER_ADDR, frame, strlen(frame));
+	radio_tx_done(); // Back to receiving mode for the ACK.
+}
+
+/*
+ * Checks a received message for an acknowledgement ("<addr>,ACK,<seq>").
+ * Returns 1 if it was one (the caller can drop the message), else 0.
+ */
+uint8_t link_handle(const char *message) {
+	const char *ack = strstr(message, ",ACK,");
+	uint8_t seq;
+	uint32_t latency;
+	UInt key;
+
+	if (ack == NULL) return 0;
+
+	seq = atoi(ack + 5);
+	key = Task_disable();
+
+	if (count > 0 && queue[head].seq == seq && queue[head].tries > 0) {
+		latency = timer_ms() - queue[head].queued_ms;
+
+		stats.delivered++;
+		stats.latency_ms_sum += latency;
+		if (latency > stats.latency_ms_max) stats.latency_ms_max = latency;
+
+		head = (head + 1) % LINK_QUEUE_SIZE;
+		count--;
+
+		if (count > 0) queue[head].due_ms = timer_ms(); // Send the next one right away.
+	} else {
+		stats.duplicate_acks++; // An ACK for a retransmission we no longer wait for.
+	}
+
+	Task_restore(key);
+
+	if (count == 0) radio_refresh(); // Nothing more to listen for.
+
+	return 1;
+}
+
+/*
+ * Returns 1 while frames are waiting to be sent or acknowledged.
+ */
+uint8_t link_pending() {
+#if LINK_RELIABLE
+	return count > 0;
+#else
+	return 0;
+#endif
+}
+
+/*
+ * Returns the number of payloads link_send can still queue.
+ */
+uint8_t link_space() {
+	return LINK_QUEUE_SIZE - count;
+}
+
+void link_get_stats(link_stats_t *out) {
+	UInt key = Task_disable();
+	*out = stats;
+	Task_restore(key);
+}
@@ -0,0 +1,39 @@
+/*
+ * Reliable delivery of the game events to the backend.
+ */
+
+#ifndef LINK_H_
+#define LINK_H_
+
+#include <inttypes.h>
+
+// Set to 0 for a backend that doesn't acknowledge: frames are then sent
+// once, in order, without the sequence number.
+#define LINK_RELIABLE 1
+
+#define LINK_QUEUE_SIZE 8
+#define LINK_PAYLOAD_SIZE 48 // Fits a session fragment (session.c).
+#define LINK_TIMEOUT_MS 200 // First retransmit timeout, doubled on every retry.
+#define LINK_MAX_TRIES 5
+
+typedef struct {
+	uint32_t queued; // Events handed to link_send.
+	uint32_t delivered; // Events acknowledged by the backend.
+	uint32_t failed; // Events given up after LINK_MAX_TRIES.
+	uint32_t dropped; // Events that didn't fit into the queue.
+	uint32_t transmissions; // Frames sent, including retransmissions.
+	uint32_t retransmissions;
+	uint32_t duplicate_acks;
+	uint32_t latency_ms_sum; // From link_send to the acknowledgement.
+	uint32_t latency_ms_max;
+} link_stats_t;
+
+void link_init();
+uint8_t link_send(const char *payload);
+void link_poll();
+uint8_t link_handle(const char *message);
+uint8_t link_pending();
+uint8_t link_space();
+void link_get_stats(link_stats_t *stats);
+
+#endif
@@ -28,6 +28,7 @@
 // BIOS header files
 #include <ti/sysbios/BIOS.h>
 #include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Semaphore.h>
 #include <ti/sysbios/knl/Task.h>
 
 // TI-RTOS header files
@@ -46,12 +47,27 @@
 #include "sensors/tmp007.h"
 #include "wireless/comm_lib.h"
 #include "buzzer.h"
+#include "events.h"
+#include "fsm.h"
 #include "karaoke.h"
+#include "latency.h"
+#include "monitor.h"
 #include "game.h"
+#include "input.h"
+#include "link.h"
 #include "pitches.h"
+#include "power.h"
+#include "pt.h"
+#include "radio.h"
+#include "session.h"
+#include "sfx.h"
+#include "songs.h"
+#include "timer.h"
+#include "trace.h"
 #include "ui.h"
 
 #define TASKSTACKSIZE   2048
+#define COMM_POLL_MS    10 // How often commTask looks for frames while receiving.
 
 Char commTaskStack[TASKSTACKSIZE];
 Char uiTaskStack[TASKSTACKSIZE];
@@ -66,21 +82,19 @@ static PIN_State abuttonState;
 static PIN_Handle buzzerHandle;
 static PIN_Handle ledHandle;
 
-Clock_Handle btn0_clkHandle;
-Clock_Handle read_clkHandle;
-Clock_Handle ignore_clkHandle;
-Clock_Handle btn1_clkHandle;
-Clock_Handle timer_clkHandle;
-Clock_Handle debounce_clkHandle;
+static Display_Handle displayHandle;
+
+swtimer_t tick_timer; // The stopwatch and the REVERSE playback, on the timer wheel.
+
+Semaphore_Handle sensor_semHandle; // Wakes the sensorTask in a state that samples.
 
 /*
  * Initializing the program states.
  *   WAIT: display the "Calibrating..." prompt before entering MENU.
- *   MENU: draw the menu and move to the next option if necessary.
- *   MENU_READ: read the MPU in order to move in the menu using gestures.
+ *   MENU: draw the menu and move to the next option if necessary (gestures too).
+ *   SONGS: pick a song of the library (songs.c) for the KARAOKE.
  *   KARAOKE: play the song and display the lyrics, then return to the MENU.
- *   GAME: draw the game UI when requested.
- *   READ: while we're in the game, read the MPU and request a display update if necessary.
+ *   GAME: draw the game UI when requested, while the sensorTask detects the moves.
  *   CLOCK: display the stopwatch.
  *   MAZE: display the maze.
  *   SLIDESHOW: display the slideshow, then return to MENU.
@@ -88,36 +102,38 @@ Clock_Handle debounce_clkHandle;
  *   ILLEGAL_MOVE: discourage the user when he/she has lost either game.
  *   WIN: celebrate and encourage the user when he/she was won either game.
  *   REVERSE: if we were in state GAME, backtrack the route after WINning.
+ *   MONITOR: the hidden task monitor (monitor.c), refreshed every second.
  *
+ * Only uiTask changes the state, through the table of fsm.c below. The
+ * timers, the buttons (input.c), the sensorTask and the commTask post
+ * events (events.c) and uiTask dispatches them in order; the others
+ * read fsm_state().
  */
-enum state {MENU=1, KARAOKE, GAME, READ, MENU_READ, CLOCK, MAZE, SLIDESHOW, SHUTDOWN, WAIT, ILLEGAL_MOVE, WIN, REVERSE};
-enum state mainState = WAIT;
+enum state {MENU=1, KARAOKE, GAME, CLOCK, MAZE, SLIDESHOW, SHUTDOWN, WAIT, ILLEGAL_MOVE, WIN, REVERSE, MONITOR, SONGS, STATE_COUNT};
 
 enum clock {START=1, RUN, STOP};
 enum clock clockState = START;
 
+// uiTask only.
 char temp_str[10]; // String for displaying the temperature data.
 
 uint8_t update = 1; // Flag for updating the display when necessary.
-uint8_t ignore = 0; // Avoid detecting another gesture right after the last one.
 uint8_t send = 0; // Flag for sending a message.
 uint8_t moves = 0; // Counting the moves.
 
-float z_data[10]; // Storing the accelerometer z-values in an array.
-uint8_t z_index = 0; // The array index.
-
 uint16_t seconds = 0; // Seconds of the stopwatch.
-uint8_t button_wait = 0;
 
-uint8_t maze = 0; // "Remembers" if we have come from the maze or not.
+uint8_t song = 0; // The song picked for the KARAOKE; SONG_LIBRARY for none (back).
+
+uint8_t sensors_idle = 0; // The sensorTask waits for sensor_semHandle.
 
 PIN_Config buttonConfig[] = {
-   Board_BUTTON0 | PIN_INPUT_EN | PIN_PULLUP | PIN_HYSTERESIS | PIN_IRQ_NEGEDGE,
+   Board_BUTTON0 | PIN_INPUT_EN | PIN_PULLUP | PIN_HYSTERESIS | PIN_IRQ_BOTHEDGES,
    PIN_TERMINATE
 };
 
 PIN_Config abuttonConfig[] = {
-   Board_BUTTON1 | PIN_INPUT_EN | PIN_PULLUP  | PIN_HYSTERESIS | PIN_IRQ_NEGEDGE,
+   Board_BUTTON1 | PIN_INPUT_EN | PIN_PULLUP  | PIN_HYSTERESIS | PIN_IRQ_BOTHEDGES,
    PIN_TERMINATE
 };
 
@@ -148,141 +164,426 @@ static const I2CCC26XX_I2CPinCfg i2cMPUCfg = {
     .pinSCL = Board_I2C0_SCL1
 };
 
-Void btn0_clkFxn(UArg arg0) {
-	// Debounce: if button still down...
-	if( (mainState == MENU || mainState == MENU_READ) && !PIN_getOutputValue(Board_BUTTON0)) {
-		menu_increment(); // Move to the next menu item.
-	    update = 1; // ...and request a display update.
-	} else if ( (mainState == GAME || mainState == READ) && !PIN_getOutputValue(Board_BUTTON0)) {
-		mainState = MENU; // Back button: return to main menu.
-		clear_direction(); // ...clear the current direction
-		update = 1; //... and request a display update.
-		System_flush();
-	} else if (mainState == CLOCK && !PIN_getOutputValue(Board_BUTTON0)) {
-		seconds = 0; // Set stopwatch seconds to 0...
-		clockState = START; // Reset stopwatch state...
-		mainState = MENU; // Return to the menu...
-		update = 1; // ... and request a display update.
-
-		// Ensure that the LEDs are off.
-		PIN_setOutputValue(ledHandle, Board_LED0, 0);
-		PIN_setOutputValue(ledHandle, Board_LED1, 0);
+Void timer_clkFxn(UArg arg0) {
+	event_post(EV_TICK, 0, 0, 0); // The stopwatch or the REVERSE playback.
+}
+
+/*
+ * The states: entry and exit hooks, the work each one does in uiTask
+ * and the actions on the events. The table after them wires them up.
+ */
+void menu_entry() {
+	update = 1; // Draw the menu.
+	monitor_update(); // The CPU loads and the stacks since the last visit, to the trace log.
+}
 
-		// No need to run the stopwatch clock.
-		Clock_stop(timer_clkHandle);
+uint8_t menu_run(const event_t *event) {
+	if (update == 1) {
+    	draw_menu(displayHandle); // ...unsurprisingly, draw the menu!
+        update = 0;
 	}
 
-	// No need to run this clock.
-	Clock_stop(btn0_clkHandle);
+	return 0;
+}
+
+uint8_t menu_next(const event_t *event) {
+	menu_increment(); // Move to the next menu item.
+    update = 1; // ...and request a display update.
+	return 0;
+}
+
+uint8_t menu_repeat(const event_t *event) {
+	return event->arg == 0 ? menu_next(event) : 0; // Holding button 0 scrolls through the menu.
+}
+
+uint8_t menu_select(const event_t *event) {
+	// The states of the menu items, in the order of ui.c.
+	static const uint8_t items[] = {GAME, MAZE, SONGS, CLOCK, SLIDESHOW, SHUTDOWN};
 
-	button_wait = 1;
-	Clock_start(debounce_clkHandle); // Ignore subsequent button presses for a certain time period.
+	if (event->type == EV_BUTTON1 && input_down(0)) {
+		return MONITOR; // Button 1 with button 0 held: the hidden task monitor.
+	}
+
+	return items[get_index()]; // Change the state according to the chosen menu item.
 }
 
-Void read_clkFxn(UArg arg0) {
-	// Switch to sensor read mode if in state GAME and no display update is requested.
-	if (mainState == GAME && update == 0) {
-		mainState = READ;
-	// Also switch to sensor read if we're in the menu.
-	} else if (mainState == MENU && update == 0) {
-		mainState = MENU_READ;
+uint8_t wait_run(const event_t *event) {
+	if (update == 1) { // If we're just waiting...
+    	draw_calibrate(displayHandle); // ...draw the calibration screen.
+    	update = 0;
 	}
+
+	return 0;
 }
 
-Void ignore_clkFxn(UArg arg0) { // Stop ignoring accelerometer data after a certain time period.
-	ignore = 0; // Turn off ignore flag...
-	z_index = 0; // Set the z-data index to 0...
-	memset(z_data, 0, sizeof(z_data)); // Empty the array just to be sure...
-	Clock_stop(ignore_clkHandle); // ...and stop the clock.
+/*
+ * The work of the states that play a sequence: wait for its coroutines
+ * (pt.c) and move to the menu after it's over.
+ */
+uint8_t sequence_run(const event_t *event) {
+	return pt_running() ? 0 : MENU;
 }
 
-Void btn1_clkFxn(UArg arg0) { // Logic for the second button.
-	if(mainState == CLOCK && !PIN_getOutputValue(Board_BUTTON1)) { // Handle the clock.
-		switch (clockState) {
-			case START:
-				clockState = RUN; // Start the watch!
-				PIN_setOutputValue(ledHandle, Board_LED0, 1); // Inform and encourage the user with the LED.
-				PIN_setOutputValue(ledHandle, Board_LED1, 0);
+void songs_entry() {
+	update = 1; // Draw the list.
+}
+
+uint8_t songs_run(const event_t *event) {
+	if (update == 1) {
+		draw_songs(displayHandle, song);
+		update = 0;
+	}
 
-				Clock_start(timer_clkHandle); // Start the stopwatch clock.
-				break;
-			case RUN:
-				clockState = STOP; // Stop the time.
+	return 0;
+}
 
-				PIN_setOutputValue(ledHandle, Board_LED0, 0);
-				PIN_setOutputValue(ledHandle, Board_LED1, 1); // Inform the user.
+uint8_t songs_next(const event_t *event) {
+	song = (song + 1) % (SONG_LIBRARY + 1); // The songs, then back to the menu.
+	update = 1;
+	return 0;
+}
 
-				break;
-			case STOP:
-				clockState = START; // Resetting the watch.
+uint8_t songs_repeat(const event_t *event) {
+	return event->arg == 0 ? songs_next(event) : 0; // Holding button 0 scrolls, as in the menu.
+}
 
-				PIN_setOutputValue(ledHandle, Board_LED0, 0);
-				PIN_setOutputValue(ledHandle, Board_LED1, 1); // Inform the user.
+uint8_t songs_select(const event_t *event) {
+	return song < SONG_LIBRARY ? KARAOKE : MENU;
+}
 
-				seconds = 0; // Set seconds to zero.
-		}
+void karaoke_entry() {
+    play_karaoke(buzzerHandle, displayHandle, &song_library[song]); // ...play the karaoke!
+}
+
+pt_t flash;
 
-		update = 1; // Request a display update.
-	// Handling MENU / MENU_READ state.
-	} else if ( (mainState == MENU || mainState == MENU_READ) && !PIN_getOutputValue(Board_BUTTON1)) {
-		switch (get_index()) { // Change the state according to the chosen menu item.
-			case 0:
-				mainState = GAME;
-			    update = 1;
-			    break;
-			case 1:
-				mainState = MAZE;
-				update = 1;
-				break;
-			case 2:
-			    mainState = KARAOKE;
-			  	break;
-			case 3:
-			    mainState = CLOCK;
-			    Clock_start(timer_clkHandle);
-			  	update = 1;
-			    break;
-			case 4:
-				mainState = SLIDESHOW;
-				break;
-			case 5:
-			    mainState = SHUTDOWN;
-		 }
-	// Selecting a random direction in state GAME or READ.
-	} else if ( (mainState == GAME || mainState == READ) && !PIN_getOutputValue(Board_BUTTON1)) {
-	    random_direction();
-		update = 1;
-		send = 1;
-		moves++;
+uint8_t flash_thread(pt_t *pt) {
+	if (pt->aborted) {
+		PIN_setOutputValue(ledHandle, Board_LED0, 0);
+		return PT_ENDED;
 	}
 
-	Clock_stop(btn1_clkHandle);
+	PT_BEGIN(pt);
 
-	button_wait = 1;
-	Clock_start(debounce_clkHandle);
+	PIN_setOutputValue(ledHandle, Board_LED0, 1);
+	PT_SLEEP(pt, 100000 / Clock_tickPeriod);
+	PIN_setOutputValue(ledHandle, Board_LED0, 0);
+
+	PT_END(pt);
 }
 
-Void timer_clkFxn(UArg arg0) {
-	if (mainState == CLOCK && clockState == RUN) { // If we're in the clock and state RUN...
+void game_entry() {
+	update = 1;
+}
+
+uint8_t game_run(const event_t *event) {
+	if (update == 1) {
+    	draw_game(displayHandle, buzzerHandle, moves); // Draw the game screen.
+    	update = 0; // No unnecessary display updates, please.
+
+    	pt_spawn(&flash, flash_thread); // Flash the green LED in order to encourage the user.
+	}
+
+	return 0;
+}
+
+uint8_t game_random(const event_t *event) {
+    random_direction(); // Selecting a random direction.
+    session_confidence(0); // No sensor involved.
+	update = 1;
+	send = 1;
+	moves++;
+	return 0;
+}
+
+uint8_t game_move(const event_t *event) {
+	set_direction(event->arg); // The direction the sensorTask detected.
+	session_confidence(event->x);
+	update = 1; // ...request a display update
+	send = 1; // ...request a message transmit
+	moves++; // ...increment the move count.
+	return 0;
+}
+
+uint8_t game_quit(const event_t *event) {
+	session_end(SESSION_QUIT); // Back button: end the session...
+	clear_direction(); // ...and clear the current direction.
+	return 0;
+}
+
+uint8_t game_won(const event_t *event) {
+	session_end(SESSION_WIN);
+	return 0;
+}
+
+uint8_t game_lost(const event_t *event) {
+	session_end(SESSION_LOST);
+	return 0;
+}
+
+void clock_entry() {
+  	update = 1; // The stopwatch clock runs only while the watch does.
+}
+
+void clock_exit() {
+	seconds = 0; // Set stopwatch seconds to 0...
+	clockState = START; // ...and reset stopwatch state.
+
+	// Ensure that the LEDs are off.
+	PIN_setOutputValue(ledHandle, Board_LED0, 0);
+	PIN_setOutputValue(ledHandle, Board_LED1, 0);
+
+	// No need to run the stopwatch timer.
+	timer_stop(&tick_timer);
+}
+
+uint8_t clock_run(const event_t *event) {
+	if (update == 1) { // If we're in the clock...
+    	draw_clock(displayHandle, seconds, temp_str); // ...draw the clock face.
+    	update = 0; // No update by default if not requested elsewhere (reset or seconds increment).
+	}
+
+	return 0;
+}
+
+uint8_t clock_button(const event_t *event) {
+	switch (clockState) {
+		case START:
+			clockState = RUN; // Start the watch!
+			PIN_setOutputValue(ledHandle, Board_LED0, 1); // Inform and encourage the user with the LED.
+			PIN_setOutputValue(ledHandle, Board_LED1, 0);
+
+			timer_start(&tick_timer, (Clock_FuncPtr) timer_clkFxn, 0, 1000, 1000); // Start the stopwatch timer.
+			break;
+		case RUN:
+			clockState = STOP; // Stop the time.
+			timer_stop(&tick_timer);
+
+			PIN_setOutputValue(ledHandle, Board_LED0, 0);
+			PIN_setOutputValue(ledHandle, Board_LED1, 1); // Inform the user.
+
+			break;
+		case STOP:
+			clockState = START; // Resetting the watch.
+
+			PIN_setOutputValue(ledHandle, Board_LED0, 0);
+			PIN_setOutputValue(ledHandle, Board_LED1, 1); // Inform the user.
+
+			seconds = 0; // Set seconds to zero.
+	}
+
+	update = 1; // Request a display update.
+	return 0;
+}
+
+uint8_t clock_tick(const event_t *event) {
+	if (clockState == RUN) { // If the clock is running...
 		seconds++; // ...increment the seconds.
 		update = 1; // ...and request a display update.
-	} else if (mainState == REVERSE) { // If we're in state REVERSE...
-		if (send == 0) { // ...and no send flag...
-			if (reverse_direction() == 0) { // ...and we haven't traversed through all the directions
-				update = 1; // ...request a display update.
-				send = 1; // ...and a message transmit.
-			} else { // If there are no more directions...
-				mainState = MENU; // ...transition to state MENU.
-				update = 1; // ...request a display update.
-				Clock_stop(timer_clkHandle); // Stop the timer.
-			}
-		}
 	}
+
+	return 0;
+}
+
+uint8_t clock_temp(const event_t *event) {
+	sprintf(temp_str, "%d C", event->x); // Prepare the temperature string for displaying on the screen.
+	return 0;
+}
+
+void maze_entry() {
+	update = 1;
+}
+
+uint8_t maze_run(const event_t *event) {
+	if (update == 1) { // In the maze!
+    	draw_labyrinth(displayHandle); // Draw the labyrinth if requested to update.
+    	update = 0;
+	}
+
+	return 0;
+}
+
+uint8_t maze_tilt(const event_t *event) {
+    switch (handle_labyrinth(event->x, event->y)) { // Call the function and proceed accordingly.
+    	case 0:
+    		return ILLEGAL_MOVE; // Lost the game.
+    	case 1:
+    		return WIN; // Won the game!
+    	case 3:
+    		return 0; // The ball didn't move a pixel: nothing to draw.
+    }
+
+    update = 1; // Update the display after handling the labyrinth (the next states draw their own).
+    return 0;
+}
+
+void slideshow_entry() {
+	slideshow(displayHandle); // ...play it!
+}
+
+uint8_t shutdown_run(const event_t *event) {
+	Display_clear(displayHandle);
+	Display_close(displayHandle); // Clear and close the display.
+	Task_sleep(100000 / Clock_tickPeriod);
+
+	PIN_close(buttonHandle);
+    PINCC26XX_setWakeup(powerWakeConfig); // Set the wakeup configuration.
+	Power_shutdown(NULL, 0); // ...and perform the shutdown.
+
+	return 0;
+}
+
+void illegal_entry() {
+	// Notify the user about an illegal move and discourage him/her with a condescending tone.
+	illegal_move(buzzerHandle, displayHandle, ledHandle);
+
+	if (fsm_previous() != MAZE) { // If we weren't in the maze...
+		empty_all(); // ...clear the game data.
+		moves = 0;
+	}
+}
+
+void win_entry() {
+	win(buzzerHandle, displayHandle, ledHandle); // We won!
+}
+
+uint8_t win_run(const event_t *event) {
+	if (pt_running()) return 0; // Still celebrating.
+
+	// Back to the menu from the maze; from the main game, iterate through the moves!
+	return fsm_previous() == MAZE ? MENU : REVERSE;
+}
+
+uint8_t win_skip(const event_t *event) {
+	if (fsm_previous() != MAZE) { // No encore: clear the game data.
+		empty_all();
+		moves = 0;
+	}
+
+	return 0;
+}
+
+void reverse_entry() {
+	clear_direction(); // Clear the direction...
+	moves = 0;
+	timer_start(&tick_timer, (Clock_FuncPtr) timer_clkFxn, 0, 1000, 1000); // ...and start iterating through the moves!
+}
+
+void reverse_exit() {
+	timer_stop(&tick_timer); // Stop the timer.
+	sfx_stop(); // ...and the sound of the last move.
+}
+
+uint8_t reverse_run(const event_t *event) {
+	if (update == 1) { // If in the REVERSE state...
+    	Display_clear(displayHandle);
+    	draw_arrows(displayHandle, buzzerHandle); // Show the current move.
+    	Display_print0(displayHandle, 5, 5, "Encore!"); // ...and inform the user about the playback.
+    	update = 0;
+	}
+
+	return 0;
+}
+
+uint8_t reverse_tick(const event_t *event) {
+	if (reverse_direction() == 0) { // If we haven't traversed through all the directions
+		update = 1; // ...request a display update.
+		send = 1; // ...and a message transmit.
+		return 0;
+	}
+
+	return MENU; // If there are no more directions, transition to state MENU.
+}
+
+void monitor_entry() {
+	monitor_update(); // A fresh window...
+	timer_start(&tick_timer, (Clock_FuncPtr) timer_clkFxn, 0, 1000, 1000); // ...and a new one every second.
+	update = 1;
+}
+
+void monitor_exit() {
+	timer_stop(&tick_timer);
+}
+
+uint8_t monitor_run(const event_t *event) {
+	if (update == 1) {
+		draw_monitor(displayHandle);
+		update = 0;
+	}
+
+	return 0;
+}
+
+uint8_t monitor_tick(const event_t *event) {
+	monitor_update();
+	update = 1;
+	return 0;
 }
 
-Void debounce_clkFxn(UArg arg0) {
-	button_wait = 0;
-	Clock_stop(debounce_clkHandle);
+/*
+ * The state table: one row per state, indexed by enum state, and in
+ * each row what every event leads to. {next, action}: the action runs
+ * first and may choose the next state itself. Button 0 cuts the long
+ * sequences short; leaving a state aborts its coroutines.
+ */
+const fsm_state_t states[STATE_COUNT] = {
+	[WAIT] = {"WAIT", NULL, NULL, wait_run, {
+		[EV_CALIBRATED] = {MENU, NULL}}},
+	[MENU] = {"MENU", menu_entry, NULL, menu_run, {
+		[EV_BUTTON0] = {0, menu_next},
+		[EV_BUTTON1] = {0, menu_select},
+		[EV_REPEAT] = {0, menu_repeat},
+		[EV_MENU_NEXT] = {0, menu_next},
+		[EV_MENU_SELECT] = {0, menu_select}}},
+	[SONGS] = {"SONGS", songs_entry, NULL, songs_run, {
+		[EV_BUTTON0] = {0, songs_next},
+		[EV_BUTTON1] = {0, songs_select},
+		[EV_REPEAT] = {0, songs_repeat}}},
+	[KARAOKE] = {"KARAOKE", karaoke_entry, pt_abort_all, sequence_run, {
+		[EV_BUTTON0] = {MENU, NULL}}},
+	[GAME] = {"GAME", game_entry, pt_abort_all, game_run, {
+		[EV_BUTTON0] = {MENU, game_quit},
+		[EV_BUTTON1] = {0, game_random},
+		[EV_MOVE] = {0, game_move},
+		[EV_WIN] = {WIN, game_won},
+		[EV_LOST] = {ILLEGAL_MOVE, game_lost}}},
+	[CLOCK] = {"CLOCK", clock_entry, clock_exit, clock_run, {
+		[EV_BUTTON0] = {MENU, NULL},
+		[EV_BUTTON1] = {0, clock_button},
+		[EV_TICK] = {0, clock_tick},
+		[EV_TEMP] = {0, clock_temp}}},
+	[MAZE] = {"MAZE", maze_entry, NULL, maze_run, {
+		[EV_TILT] = {0, maze_tilt}}},
+	[SLIDESHOW] = {"SLIDESHOW", slideshow_entry, pt_abort_all, sequence_run, {
+		[EV_BUTTON0] = {MENU, NULL}}},
+	[SHUTDOWN] = {"SHUTDOWN", NULL, NULL, shutdown_run, {{0}}},
+	[ILLEGAL_MOVE] = {"ILLEGAL_MOVE", illegal_entry, pt_abort_all, sequence_run, {
+		[EV_BUTTON0] = {MENU, NULL}}},
+	[WIN] = {"WIN", win_entry, pt_abort_all, win_run, {
+		[EV_BUTTON0] = {MENU, win_skip}}},
+	[REVERSE] = {"REVERSE", reverse_entry, reverse_exit, reverse_run, {
+		[EV_TICK] = {0, reverse_tick}}},
+	[MONITOR] = {"MONITOR", monitor_entry, monitor_exit, monitor_run, {
+		[EV_BUTTON0] = {MENU, NULL},
+		[EV_TICK] = {0, monitor_tick}}},
+};
+
+/*
+ * How often the sensorTask samples in the current state, in ms; 0 if
+ * the state needs no sensors at all.
+ */
+uint16_t sensor_period() {
+	switch (fsm_state()) {
+		case GAME:
+		case MENU:
+			return 100; // Gestures.
+		case MAZE:
+			return 20; // Tilt: a step of the ball physics each.
+		case CLOCK:
+			return clockState == RUN ? 1000 : 0; // The temperature, once per displayed second.
+		default:
+			return 0;
+	}
 }
 
 Void sensorTask() {
@@ -311,18 +612,35 @@ Void sensorTask() {
 	tmp007_setup(&i2c); // Setup the TMP.
 	I2C_close(i2c);
 
-	mainState = MENU; // Calibration OK! Move to the menu.
-	update = 1; // ...and request a display update.
+	event_post(EV_CALIBRATED, 0, 0, 0); // Calibration OK! Move to the menu.
 
 	float ax, ay, az, gx, gy, gz, magnitude; // Storing sensor data and magnitude.
 	float init_ax, init_ay; // Storing the initial acceleration vector (x, y).
 	double temp; // Storing the temperature.
 	float var; // Storing the calculated variance.
 
-	memset(&temp_str[0], 0, sizeof(temp_str)); // Prepare the string for displaying the temperature data.
+	uint8_t ignore = 0; // Avoid detecting another gesture right after the last one.
+	uint32_t ignore_until = 0; // ...for 1 s (in ticks).
+	float z_data[10]; // Storing the accelerometer z-values in an array.
+	uint8_t z_index = 0; // The array index.
 
+	uint16_t period;
+	uint32_t sampled; // When the sample of this round was taken.
+
+	memset(z_data, 0, sizeof(z_data));
+
+	// Sample the sensors the current state needs and tell uiTask what
+	// happened. The state is only read here.
 	while (1) {
-		if (mainState == READ) { // Reading the MPU data.
+		if (ignore && (int32_t) (Clock_getTicks() - ignore_until) >= 0) { // Stop ignoring accelerometer data after a certain time period.
+			ignore = 0; // Turn off ignore flag...
+			z_index = 0; // Set the z-data index to 0...
+			memset(z_data, 0, sizeof(z_data)); // Empty the array just to be sure...
+		}
+
+		sampled = Clock_getTicks();
+
+		if (fsm_state() == GAME) { // Reading the MPU data.
 			i2cMPU = I2C_open(Board_I2C, &i2cMPUParams); // Open the I2C.
 			mpu9250_get_data(&i2cMPU, &ax, &ay, &az, &gx, &gy, &gz); // Read the data.
 			I2C_close(i2cMPU);
@@ -336,7 +654,7 @@ Void sensorTask() {
 				init_ay = ay; // Store the initial direction.
 
 				ignore = 1; // ...and wait for the peak in the opposite direction.
-				Clock_start(ignore_clkHandle); // Stop ignoring after a certain time period.
+				ignore_until = Clock_getTicks() + 1000000 / Clock_tickPeriod; // Stop ignoring after a certain time period.
 			}
 
 			if (ignore) { // If there has been a peak in acceleration, start storing the z-component data.
@@ -353,78 +671,53 @@ Void sensorTask() {
 				z_index = 0;
 				memset(z_data, 0, sizeof(z_data));
 
-				determine_direction(init_ax, init_ay); // Determine the direction.
-				update = 1; // ...request a display update
-				send = 1; // ...request a message transmit
+				// Send the direction to uiTask with the confidence of the detection, 1...15:
+				// how far the return peak exceeds the threshold and how steady the z-axis was.
+				input_motion(EV_MOVE, determine_direction(init_ax, init_ay),
+						1 + (magnitude > 15.0 ? 7 : (uint8_t) (magnitude - 8.0)) + (uint8_t) (7 * (50 - var) / 50), 0, sampled);
 
-				moves++; // ...increment the move count.
+				// One move per gesture: the opposite peak may last for a few samples.
+				init_ax = 0;
+				init_ay = 0;
 			}
-
-			mainState = GAME; // Move back to the state GAME.
-		} else if (mainState == MENU_READ) { // Reading the MPU sensor in the menu.
+		} else if (fsm_state() == MENU) { // Reading the MPU sensor in the menu.
 			i2cMPU = I2C_open(Board_I2C, &i2cMPUParams);
 			mpu9250_get_data(&i2cMPU, &ax, &ay, &az, &gx, &gy, &gz);
 			I2C_close(i2cMPU);
 			ax *= 9.81; ay *= 9.81; az *= 9.81;
 
-			mainState = MENU; // Move back to the state MENU.
-
 			if (az > 6.0 && ay > 8.0 && ax < 5.0) { // If there was a swing to the front...
-				switch (get_index()) { // ...enter the corresponding menu functionality.
-					case 0:
-						mainState = GAME;
-						update = 1;
-						break;
-					case 1:
-						mainState = MAZE;
-						update = 1;
-						break;
-					case 2:
-						mainState = KARAOKE;
-						break;
-					case 3:
-						mainState = CLOCK;
-						Clock_start(timer_clkHandle);
-						update = 1;
-						break;
-					case 4:
-						mainState = SLIDESHOW;
-						break;
-					case 5:
-						mainState = SHUTDOWN;
-				}
+				input_motion(EV_MENU_SELECT, 0, 0, 0, sampled); // ...enter the corresponding menu functionality.
 			} else if (sqrt( pow(gx, 2) + pow(gy, 2) + pow(gz, 2) ) > 250) { // If gyroscope magnitude exceeds 250...
-				menu_increment(); // ...increment the menu
-				update = 1; // ...and update the display.
+				input_motion(EV_MENU_NEXT, 0, 0, 0, sampled); // ...increment the menu.
 			}
-
-		} else if (mainState == CLOCK && clockState == RUN) { // If the clock is running...
+		} else if (fsm_state() == CLOCK && clockState == RUN) { // If the clock is running...
 			i2c = I2C_open(Board_I2C, &i2cParams); // Open the I2C.
 			temp = tmp007_get_data(&i2c); // Get temperature data.
 		    I2C_close(i2c);
 
-			sprintf(temp_str, "%.0f C", temp); // Prepare the temperature string for displaying on the screen.
-		} else if (mainState == MAZE) { // If we're in the maze...
+		    event_post(EV_TEMP, 0, (int16_t) round(temp), 0);
+		} else if (fsm_state() == MAZE) { // If we're in the maze...
 			i2cMPU = I2C_open(Board_I2C, &i2cMPUParams);
 		    mpu9250_get_data(&i2cMPU, &ax, &ay, &az, &gx, &gy, &gz); // Get MPU data.
 		    I2C_close(i2cMPU);
 		    ax *= 9.81; ay *= 9.81; az *= 9.81;
 
-		    update = 1; // Update the display after handling the labyrinth.
-
-		    switch (handle_labyrinth(ax, ay)) { // Call the function and proceed accordingly.
-		    	case 0:
-		    		mainState = ILLEGAL_MOVE; // Lost the game.
-		    		maze = 1; // Let the uiTask know that we were in the maze.
-		    		break;
-		    	case 1:
-		    		mainState = WIN; // Won the game!
-		    		maze = 1; // Let the uiTask know that we were in the maze.
-		    		break;
-		    }
+		    input_motion(EV_TILT, 0, (int16_t) (ax * 100), (int16_t) (ay * 100), sampled); // uiTask moves the ball.
+		}
+
+		period = sensor_period();
+		power_sleep(POWER_SENSOR);
+
+		if (period) {
+			Task_sleep(period * (1000 / Clock_tickPeriod)); // Sleep is crucial even for a machine's wellbeing.
+		} else {
+			sensors_idle = 1; // Nothing to sample: sleep until uiTask enters a state that does.
+			Semaphore_pend(sensor_semHandle, BIOS_WAIT_FOREVER);
+			sensors_idle = 0;
 		}
 
-	    Task_sleep(100000 / Clock_tickPeriod); // Sleep is crucial even for a machine's wellbeing.
+		power_wake(POWER_SENSOR);
 	}
 }
 
@@ -437,16 +730,20 @@ Void commTask() {
 	uint8_t part_index = 0; // Index for the parts.
 	uint16_t senderAddr; // Sender address.
 
-	StartReceive6LoWPAN(); // Receiving mode!
-
     while (1) {
-    	// If we have a message and the state is GAME or READ...
-        if (GetRXFlag() && (mainState == GAME || mainState == READ)) {
+    	// If we have a message...
+        if (GetRXFlag()) {
         	part_index = 0;
         	memset(message, 0, 16);
         	Receive6LoWPAN(&senderAddr, message, 16); // Go ahead and receive the message!
-        	System_printf(message);
-        	System_flush();
+        	trace_log(TRACE_RX, senderAddr, (uint8_t) message[0] | (uint8_t) message[1] << 8
+        			| (uint8_t) message[2] << 16 | (uint32_t) (uint8_t) message[3] << 24);
+
+        	// Acknowledgements are for the link layer in any state;
+        	// the game results only matter in state GAME.
+        	if (link_handle(message) || fsm_state() != GAME) {
+        		continue;
+        	}
 
   	  	  	p = strtok(message, ",");
 
@@ -460,15 +757,20 @@ Void commTask() {
 
   	  	    // If 251 has won...
   	  	    if (strcmp(parts[1], "WIN") == 0 && strcmp(parts[0], "251") == 0) {
-  	  	    	mainState = WIN;
-  	  	    	maze = 0;
+  	  	    	event_post(EV_WIN, 0, 0, 0);
   	  	    }
 
   	  	    // if 251 has lost...
   	  	    if (strcmp(parts[1], "LOST GAME") == 0 && strcmp(parts[0], "251") == 0) {
-  	  	    	mainState = ILLEGAL_MOVE;
-  	  	    	maze = 0;
+  	  	    	event_post(EV_LOST, 0, 0, 0);
   	  	    }
+        } else {
+        	// Nothing yet: look again in a while, and with the receiver
+        	// off, sleep until radio.c turns it on.
+        	power_sleep(POWER_COMM);
+        	Task_sleep(COMM_POLL_MS * (1000 / Clock_tickPeriod));
+        	radio_wait();
+        	power_wake(POWER_COMM);
         }
     }
 }
@@ -477,109 +779,73 @@ Void uiTask() {
    Display_Params params;
    Display_Params_init(&params); // Initialize the display.
    params.lineClearMode = DISPLAY_CLEAR_NONE; // Don't clear the lines.
-   Display_Handle displayHandle = Display_open(Display_Type_LCD, &params); // Open the display.
+   displayHandle = Display_open(Display_Type_LCD, &params); // Open the display.
+
+   event_t event;
+   uint32_t timeout;
+   uint8_t received;
+   uint8_t previous;
+
+   fsm_init(states, STATE_COUNT, WAIT); // Calibrating first.
 
    while (1) {
-	   	if (send) { // If we were requested to send a message...
-	   		if (mainState == REVERSE) { // ...and we're in state REVERSE...
-	   			send_message(1); // ...send the message without WIN.
-	   		} else {
-	   			send_message(0); // We haven't won: send the message.
-	   		}
+	   	if (sensors_idle && sensor_period()) { // A state that samples the sensors...
+	   		Semaphore_post(sensor_semHandle); // ...wakes the sensorTask up.
+	   	}
+
+	   	// Sleep until something happens. With a display update pending, just
+	   	// look; retransmissions and the session upload need us every 100 ms.
+	   	if (update) {
+	   		timeout = BIOS_NO_WAIT;
+	   	} else if (link_pending() || session_pending()) {
+	   		timeout = 100000 / Clock_tickPeriod;
+	   	} else {
+	   		timeout = BIOS_WAIT_FOREVER;
+	   	}
+
+	   	if (pt_wait() < timeout) { // A coroutine sleeping...
+	   		timeout = pt_wait(); // ...resumes on time.
+	   	}
+
+	   	if (timeout != BIOS_NO_WAIT) power_sleep(POWER_UI);
+	   	received = event_pend(&event, timeout, fsm_since()); // Only events meant for this state.
+	   	if (timeout != BIOS_NO_WAIT) power_wake(POWER_UI);
+
+	   	if (received) {
+	   		input_handled(&event); // How long the button or the gesture took to get here.
+	   		previous = fsm_state();
+	   		fsm_dispatch(&event); // One row of the state table.
+	   		latency_input(&event, update || fsm_state() != previous); // The screen owes the input a redraw.
+	   	}
 
-	   		StartReceive6LoWPAN(); // Back to receiving mode!
+	   	if (send) { // If we were requested to send a message...
+	   		send_message(fsm_state() == REVERSE); // ...without WIN in state REVERSE.
 	   		send = 0; // And no need to resend the message.
 	    }
 
-	   	// No switch-structure for clarity: the update parameter
-	   	// doesn't have to be checked always.
-	    if (mainState == WAIT && update == 1) { // If we're just waiting...
-	    	draw_calibrate(displayHandle); // ...draw the calibration screen.
-	    	update = 0;
-	    } else if (mainState == MENU && update == 1) { // If we're in the menu...
-        	draw_menu(displayHandle); // ...unsurprisingly, draw the menu!
-            update = 0;
-        } else if (mainState == KARAOKE) { // If karaoke has been selected...
-            play_karaoke(buzzerHandle, displayHandle); // ...play the karaoke!
-            mainState = MENU; // ...move to the menu after it's over
-            update = 1; // ...and request a display update.
-        } else if (mainState == CLOCK && update == 1) { // If we're in the clock...
-        	draw_clock(displayHandle, seconds, temp_str); // ...draw the clock face.
-        	update = 0; // No update by default if not requested elsewhere (reset or seconds increment).
-        } else if (mainState == GAME && update == 1) { // If we're in the main game...
-        	draw_game(displayHandle, buzzerHandle, moves); // Draw the game screen.
-        	update = 0; // No unnecessary display updates, please.
-
-        	PIN_setOutputValue(ledHandle, Board_LED0, 1); // Flash the green LED in order to encourage the user.
-        	Task_sleep(100000 / Clock_tickPeriod);
-        	PIN_setOutputValue(ledHandle, Board_LED0, 0);
-        } else if (mainState == SLIDESHOW) { // If the slideshow has been selected...
-        	slideshow(displayHandle); // ...play it!
-        	mainState = MENU; // And return to the menu afterwards.
-        	update = 1;
-        } else if (mainState == SHUTDOWN) { // A shutdown has been requested.
-        	Display_clear(displayHandle);
-        	Display_close(displayHandle); // Clear and close the display.
-        	Task_sleep(100000 / Clock_tickPeriod);
-
-        	PIN_close(buttonHandle);
-            PINCC26XX_setWakeup(powerWakeConfig); // Set the wakeup configuration.
-        	Power_shutdown(NULL, 0); // ...and perform the shutdown.
-        } else if (mainState == ILLEGAL_MOVE) { // Illegal move!
-        	// Notify the user about an illegal move and discourage him/her with a condescending tone.
-        	illegal_move(buzzerHandle, displayHandle, ledHandle);
-        	update = 1;
-
-        	if (!maze) { // If we weren't in the maze...
-        		empty_all(); // ...clear the game data.
-        		moves = 0;
-        	}
+	   	// Back in the menu: upload the history of the last game in bulk.
+	   	session_poll(fsm_state() == MENU);
+	   	latency_poll(fsm_state() == MENU); // ...and the latency histogram every now and then.
 
-        	mainState = MENU; // ...and transition to the MENU state.
-        	maze = 0; // Enough of the maze already!
-        } else if (mainState == WIN) {
-        	win(buzzerHandle, displayHandle, ledHandle); // We won!
-
-        	if (maze) { // If we came from the maze...
-        		mainState = MENU; // ...return to the menu.
-        		update = 1;
-        	} else { // However, if we came from the main game...
-        		clear_direction(); // ...clear the direction
-        		mainState = REVERSE; // ...set the REVERSE state
-        		moves = 0;
-        		Clock_start(timer_clkHandle); // ...and start iterating through the moves!
-        	}
+	   	link_poll(); // Transmit queued messages and retransmit unacknowledged ones.
 
-        	maze = 0;
-        } else if (mainState == REVERSE && update == 1) { // If in the REVERSE state...
-        	Display_clear(displayHandle);
-        	draw_arrows(displayHandle, buzzerHandle); // Show the current move.
-        	Display_print0(displayHandle, 5, 5, "Encore!"); // ...and inform the user about the playback.
-        	update = 0;
-        } else if (mainState == MAZE && update == 1) { // In the maze!
-        	draw_labyrinth(displayHandle); // Draw the labyrinth if requested to update.
-        }
+	   	// Keep the receiver on only where the backend's replies matter;
+	   	// elsewhere it just listens in short windows.
+	   	radio_update(fsm_state(), fsm_state() == GAME || fsm_state() == REVERSE);
 
-        Task_sleep(100000 / Clock_tickPeriod); // Remember to sleep!
+	   	latency_draw(update);
+	   	pt_run(); // The next steps of the sequences playing.
+	   	fsm_run(); // Draw the state, or see if it's over and move on.
+	   	latency_flush(update); // Drawn and flushed: the input is on the screen.
     }
 }
 
 void buttonFxn(PIN_Handle handle, PIN_Id pinId) {
-	// Debounce logic for eliminating erratic button behaviour:
-	// start a clock and check if button still down after 200 ms.
-	if (!button_wait) {
-		Clock_start(btn0_clkHandle);
-		button_wait = 1;
-	}
+	input_edge(0); // Debounced in input.c, each button on its own.
 }
 
 void abuttonFxn(PIN_Handle handle, PIN_Id pinId) {
-	// Debounce logic for eliminating erratic button behaviour:
-	// start a clock and check if button still down after 200 ms.
-	if (!button_wait) {
-		Clock_start(btn1_clkHandle);
-		button_wait = 1;
-	}
+	input_edge(1);
 }
 
 
@@ -599,47 +865,15 @@ int main(void)
 
    Board_initGeneral();
 
-   // Clock for button 0 debounce logic.
-   Clock_Params btn0_clkParams;
-   Clock_Params_init(&btn0_clkParams);
-   btn0_clkParams.period = 200000 / Clock_tickPeriod;
-   btn0_clkParams.startFlag = FALSE;
-   btn0_clkHandle = Clock_create((Clock_FuncPtr) btn0_clkFxn, 200000 / Clock_tickPeriod, &btn0_clkParams, NULL);
-
-   //Clock for button 1 debounce logic.
-   Clock_Params btn1_clkParams;
-   Clock_Params_init(&btn1_clkParams);
-   btn1_clkParams.period = 200000 / Clock_tickPeriod;
-   btn1_clkParams.startFlag = FALSE;
-   btn1_clkHandle = Clock_create((Clock_FuncPtr) btn1_clkFxn, 200000 / Clock_tickPeriod, &btn1_clkParams, NULL);
-
-   // Clock for transitioning to sensor read mode every 100 ms.
-   Clock_Params read_clkParams;
-   Clock_Params_init(&read_clkParams);
-   read_clkParams.period = 100000 / Clock_tickPeriod;
-   read_clkParams.startFlag = TRUE;
-   read_clkHandle = Clock_create((Clock_FuncPtr) read_clkFxn, 100000 / Clock_tickPeriod, &read_clkParams, NULL);
-
-   // Clock for "ignoring" sensor data for 1 s after detecting a motion.
-   Clock_Params ignore_clkParams;
-   Clock_Params_init(&ignore_clkParams);
-   ignore_clkParams.period = 1000000 / Clock_tickPeriod;
-   ignore_clkParams.startFlag = FALSE;
-   ignore_clkHandle = Clock_create((Clock_FuncPtr) ignore_clkFxn, 1000000 / Clock_tickPeriod, &ignore_clkParams, NULL);
-
-   // Clock for the stopwatch.
-   Clock_Params timer_clkParams;
-   Clock_Params_init(&timer_clkParams);
-   timer_clkParams.period = 1000000 / Clock_tickPeriod;
-   timer_clkParams.startFlag = FALSE;
-   timer_clkHandle = Clock_create((Clock_FuncPtr) timer_clkFxn, 1000000 / Clock_tickPeriod, &timer_clkParams, NULL);
-
-   // Clock for the button debounce.
-   Clock_Params debounce_clkParams;
-   Clock_Params_init(&debounce_clkParams);
-   debounce_clkParams.period = 100000 / Clock_tickPeriod;
-   debounce_clkParams.startFlag = FALSE;
-   debounce_clkHandle = Clock_create((Clock_FuncPtr) debounce_clkFxn, 200000 / Clock_tickPeriod, &debounce_clkParams, NULL);
+   // The stopwatch and the debounce timers all run on the timer wheel.
+   timer_init();
+   input_init();
+
+   // Semaphore for waking the sensorTask.
+   Semaphore_Params sensor_semParams;
+   Semaphore_Params_init(&sensor_semParams);
+   sensor_semParams.mode = Semaphore_Mode_BINARY;
+   sensor_semHandle = Semaphore_create(0, &sensor_semParams, NULL);
 
    Task_Params_init(&uiTaskParams);
    uiTaskParams.stackSize = TASKSTACKSIZE;
@@ -652,6 +886,10 @@ int main(void)
    sensorTaskParams.priority = 2;
 
    Init6LoWPAN(); // Initialize the wireless communication.
+   link_init(); // ...and the reliable delivery on top of it.
+   radio_init(); // The radio power manager turns the receiver on when needed.
+   events_init(); // The mailbox from the timers, the inputs and the other tasks to uiTask.
+   power_init(); // Standby whenever every task waits.
 
    Task_Params_init(&commTaskParams);
    commTaskParams.stackSize = TASKSTACKSIZE;
@@ -663,6 +901,11 @@ int main(void)
    sensorTaskHandle = Task_create((Task_FuncPtr) sensorTask, &sensorTaskParams, NULL);
    commTaskHandle = Task_create((Task_FuncPtr) commTask, &commTaskParams, NULL);
 
+   // ...and watch their CPU time and stacks, in the order of POWER_UI and the others.
+   monitor_add(uiTaskHandle, "ui");
+   monitor_add(sensorTaskHandle, "sens");
+   monitor_add(commTaskHandle, "comm");
+
    buttonHandle = PIN_open(&buttonState, buttonConfig);
    abuttonHandle = PIN_open(&abuttonState, abuttonConfig);
 
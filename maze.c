@@ -0,0 +1,193 @@
+/*
+ * Perfect-maze generator: every cell can be reached from every other
+ * one by exactly one way, so a maze always has a solution.
+ *
+ * The maze is carved with a recursive backtracker: from the start, go
+ * to a random neighbour not visited yet and open the wall between;
+ * with none left, go back the way you came, until back at the start.
+ * Instead of a stack, each cell keeps the way back to where it was
+ * entered from, so the walk needs no memory beyond the grid and a bit
+ * per cell for the visited ones. The ways back make a tree rooted at
+ * the start: following them from any cell is the solution to it.
+ *
+ * A cell takes a nibble: a bit for an open wall east, one for south
+ * (west and north are the ones of the neighbours) and two for the way
+ * back. The grid takes MAZE_MAX * MAZE_MAX / 2 bytes and carving a
+ * quarter of that more: 128 + 32 bytes for the 16x16 maze of the game,
+ * 1152 + 288 for the 48x48 of the benchmark.
+ *
+ * The end is the cell whose way to the start is closest to the length
+ * asked for (the depth of the walk when it got there), or the furthest
+ * one for 0.
+ *
+ * maze_wall gives the maze as blocks for drawing and collisions: a grid
+ * of 2w+1 x 2h+1 blocks where the cells are the odd ones, and the ones
+ * between them are walls unless the wall is open.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "maze.h"
+
+#define OPEN_EAST 0x1
+#define OPEN_SOUTH 0x2
+#define BACK_SHIFT 2
+
+static const int8_t dx[4] = {1, 0, -1, 0}; // By enum maze_direction.
+static const int8_t dy[4] = {0, 1, 0, -1};
+
+static uint8_t visited[(MAZE_MAX * MAZE_MAX + 7) / 8];
+static uint32_t state; // Of the random numbers.
+
+/*
+ * xorshift32: the same maze for the same seed, on the device and on
+ * the host alike.
+ */
+static uint32_t next_random() {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+static uint8_t get(const maze_t *maze, uint16_t cell) {
+	return maze->cells[cell >> 1] >> ((cell & 1) * 4) & 0x0F;
+}
+
+static void set(maze_t *maze, uint16_t cell, uint8_t bits) {
+	maze->cells[cell >> 1] |= bits << ((cell & 1) * 4);
+}
+
+/*
+ * Opens the wall between the cell and its neighbour in the direction.
+ */
+static void carve(maze_t *maze, uint8_t x, uint8_t y, uint8_t direction) {
+	switch (direction) {
+		case MAZE_EAST:
+			set(maze, y * maze->width + x, OPEN_EAST);
+			break;
+		case MAZE_SOUTH:
+			set(maze, y * maze->width + x, OPEN_SOUTH);
+			break;
+		case MAZE_WEST:
+			set(maze, y * maze->width + x - 1, OPEN_EAST);
+			break;
+		case MAZE_NORTH:
+			set(maze, (y - 1) * maze->width + x, OPEN_SOUTH);
+			break;
+	}
+}
+
+/*
+ * Carves a new maze of width x height cells (1 to MAZE_MAX, clamped to
+ * that), from the middle of the west side to an end length cells away
+ * along the way (0 for as far as there is).
+ */
+void maze_generate(maze_t *maze, uint8_t width, uint8_t height, uint16_t length, uint32_t seed) {
+	uint8_t x, y, nx, ny;
+	uint8_t directions[4];
+	uint8_t count, d;
+	uint16_t cell, depth = 1;
+	uint16_t best = 0xFFFF; // How far the end is from the length asked for.
+
+	// The grid and the visited bits have room for no more.
+	if (width > MAZE_MAX) width = MAZE_MAX;
+	if (height > MAZE_MAX) height = MAZE_MAX;
+	if (width == 0) width = 1;
+	if (height == 0) height = 1;
+
+	maze->width = width;
+	maze->height = height;
+	memset(maze->cells, 0, (width * height + 1) / 2);
+	memset(visited, 0, (width * height + 7) / 8);
+	state = seed ? seed : 1; // xorshift never leaves 0.
+
+	x = maze->start_x = maze->end_x = 0;
+	y = maze->start_y = maze->end_y = height / 2;
+	maze->length = 1;
+	cell = y * width + x;
+	visited[cell >> 3] |= 1 << (cell & 7);
+
+	while (1) {
+		count = 0;
+		for (d = 0; d < 4; d++) { // The neighbours not visited yet.
+			nx = x + dx[d];
+			ny = y + dy[d];
+			cell = ny * width + nx;
+			if (nx < width && ny < height && !(visited[cell >> 3] & 1 << (cell & 7))) { // Wraps below 0.
+				directions[count++] = d;
+			}
+		}
+
+		if (count == 0) { // A dead end: back the way we came.
+			if (x == maze->start_x && y == maze->start_y) break; // All done.
+			d = get(maze, y * width + x) >> BACK_SHIFT;
+			x += dx[d];
+			y += dy[d];
+			depth--;
+			continue;
+		}
+
+		d = directions[next_random() % count];
+		carve(maze, x, y, d);
+		x += dx[d];
+		y += dy[d];
+		depth++;
+		cell = y * width + x;
+		visited[cell >> 3] |= 1 << (cell & 7);
+		set(maze, cell, ((d + 2) & 3) << BACK_SHIFT);
+
+		// Is this a better end? The furthest, or the closest to the length.
+		if (length == 0 ? depth > maze->length : (depth > length ? depth - length : length - depth) < best) {
+			best = depth > length ? depth - length : length - depth;
+			maze->end_x = x;
+			maze->end_y = y;
+			maze->length = depth;
+		}
+	}
+}
+
+/*
+ * Whether the wall of the cell in the direction is open (never on the
+ * edge of the maze).
+ */
+uint8_t maze_open(const maze_t *maze, uint8_t x, uint8_t y, uint8_t direction) {
+	switch (direction) {
+		case MAZE_EAST:
+			return x + 1 < maze->width && get(maze, y * maze->width + x) & OPEN_EAST;
+		case MAZE_SOUTH:
+			return y + 1 < maze->height && get(maze, y * maze->width + x) & OPEN_SOUTH;
+		case MAZE_WEST:
+			return x > 0 && get(maze, y * maze->width + x - 1) & OPEN_EAST;
+		case MAZE_NORTH:
+			return y > 0 && get(maze, (y - 1) * maze->width + x) & OPEN_SOUTH;
+	}
+
+	return 0;
+}
+
+/*
+ * Whether the block (x, y) of the 2w+1 x 2h+1 block grid is a wall;
+ * anything outside it is.
+ */
+uint8_t maze_wall(const maze_t *maze, int16_t x, int16_t y) {
+	if (x <= 0 || y <= 0 || x >= 2 * maze->width || y >= 2 * maze->height) return 1;
+
+	if (x & 1) {
+		if (y & 1) return 0; // A cell.
+		return !maze_open(maze, x / 2, y / 2 - 1, MAZE_SOUTH); // Between the cells above and below.
+	}
+
+	if (y & 1) return !maze_open(maze, x / 2 - 1, y / 2, MAZE_EAST); // Between the cells left and right.
+
+	return 1; // A corner.
+}
+
+/*
+ * The way back from the cell towards the start (enum maze_direction);
+ * meaningless for the start itself.
+ */
+uint8_t maze_back(const maze_t *maze, uint8_t x, uint8_t y) {
+	return get(maze, y * maze->width + x) >> BACK_SHIFT;
+}
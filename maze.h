@@ -0,0 +1,33 @@
+/*
+ * Perfect-maze generator on a bit-packed grid.
+ */
+
+#ifndef MAZE_H_
+#define MAZE_H_
+
+#include <inttypes.h>
+
+#ifndef MAZE_MAX
+#define MAZE_MAX 16 // Cells on a side, at most: the maze of the game. host/maze_bench.c builds with 48.
+#endif
+
+// Directions from a cell; the grid has y growing downwards, like the display.
+enum maze_direction {MAZE_EAST=0, MAZE_SOUTH, MAZE_WEST, MAZE_NORTH};
+
+typedef struct {
+	uint8_t width;
+	uint8_t height;
+	uint8_t cells[(MAZE_MAX * MAZE_MAX + 1) / 2]; // A nibble per cell: the walls east and south, the way back.
+	uint8_t start_x;
+	uint8_t start_y;
+	uint8_t end_x;
+	uint8_t end_y;
+	uint16_t length; // Cells on the way from the start to the end, both included.
+} maze_t;
+
+void maze_generate(maze_t *maze, uint8_t width, uint8_t height, uint16_t length, uint32_t seed);
+uint8_t maze_open(const maze_t *maze, uint8_t x, uint8_t y, uint8_t direction);
+uint8_t maze_wall(const maze_t *maze, int16_t x, int16_t y);
+uint8_t maze_back(const maze_t *maze, uint8_t x, uint8_t y);
+
+#endif
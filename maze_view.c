@@ -0,0 +1,192 @@
+/*
+ * Scrolling view of a maze: a camera that follows the ball through a
+ * maze larger than the display.
+ *
+ * The view has no pixels of its own: the display driver keeps the
+ * screen, and the view renders just the rows that changed into a band
+ * of MAZE_BLOCK rows at 1 bpp, the way a tImage has them, for the game
+ * to blit with GrImageDraw. A block of the maze (maze_wall) is 8x8
+ * pixels, so a block is a byte on each of its rows and a band is the
+ * 12 blocks of a block row, looked up once and rendered with byte
+ * writes, never a single pixel at a time.
+ *
+ * The camera moves a whole block at a time, when the ball gets closer
+ * to the edge of the view than MAZE_VIEW_MARGIN blocks, and the whole
+ * view is rendered again. That is no more than the blit of the view
+ * that moved costs anyway, and saves keeping a copy of the screen
+ * (1152 bytes) to scroll. Otherwise only the rows where the ball was
+ * and is are rendered. A maze that fits the display doesn't scroll at
+ * all; it is centered.
+ *
+ * The trail of the ball is a dot in each cell it has left, a bit per
+ * cell, so it is there again when the view comes back to it.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "maze.h"
+#include "maze_view.h"
+
+static const uint8_t block_wall[MAZE_BLOCK] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+static const uint8_t block_open[MAZE_BLOCK] = {0};
+static const uint8_t block_end[MAZE_BLOCK] = {0x00, 0x38, 0x44, 0x54, 0x44, 0x38, 0x00, 0x00}; // A ring around a dot.
+static const uint8_t block_trail[MAZE_BLOCK] = {0x00, 0x00, 0x00, 0x18, 0x18, 0x00, 0x00, 0x00}; // A dot.
+
+static maze_view_stats_t stats;
+
+/*
+ * The pattern of the block (x, y) of the maze.
+ */
+static const uint8_t *pattern(const maze_view_t *view, const maze_t *maze, int16_t x, int16_t y) {
+	uint16_t cell;
+
+	if (maze_wall(maze, x, y)) return block_wall;
+	if (x == 2 * maze->end_x + 1 && y == 2 * maze->end_y + 1) return block_end;
+
+	if (x & y & 1) { // A cell (not a wall, so not outside the maze).
+		cell = y / 2 * maze->width + x / 2;
+		if (view->trail[cell >> 3] & 1 << (cell & 7)) return block_trail;
+	}
+
+	return block_open;
+}
+
+/*
+ * Where the camera goes along one axis: the block in the corner, for
+ * the ball at the block and the maze blocks long.
+ */
+static int16_t follow(int16_t camera, int16_t block, int16_t blocks) {
+	if (blocks <= MAZE_VIEW_BLOCKS) return -(MAZE_VIEW_BLOCKS - blocks) / 2; // All in view: centered.
+
+	if (block < camera + MAZE_VIEW_MARGIN) camera = block - MAZE_VIEW_MARGIN;
+	if (block > camera + MAZE_VIEW_BLOCKS - 1 - MAZE_VIEW_MARGIN) camera = block - MAZE_VIEW_BLOCKS + 1 + MAZE_VIEW_MARGIN;
+
+	if (camera < 0) camera = 0;
+	if (camera > blocks - MAZE_VIEW_BLOCKS) camera = blocks - MAZE_VIEW_BLOCKS;
+	return camera;
+}
+
+/*
+ * Adds the rows of the view from (pixels of the maze) to to the ones
+ * to render, as far as they are in view.
+ */
+static void dirty(maze_view_t *view, int16_t from, int16_t to) {
+	from -= view->y * MAZE_BLOCK;
+	to -= view->y * MAZE_BLOCK;
+
+	if (from < 0) from = 0;
+	if (to > MAZE_VIEW) to = MAZE_VIEW;
+	if (from >= to) return;
+
+	if (view->dirty_from >= view->dirty_to) { // Nothing yet.
+		view->dirty_from = from;
+		view->dirty_to = to;
+		return;
+	}
+
+	if (from < view->dirty_from) view->dirty_from = from;
+	if (to > view->dirty_to) view->dirty_to = to;
+}
+
+/*
+ * Points the camera at the ball (pixels of the maze), with no trail
+ * yet, and has the whole view rendered.
+ */
+void maze_view_init(maze_view_t *view, const maze_t *maze, int16_t ball_x, int16_t ball_y) {
+	memset(view->trail, 0, sizeof(view->trail));
+
+	view->x = follow(ball_x / MAZE_BLOCK - MAZE_VIEW_BLOCKS / 2, ball_x / MAZE_BLOCK, 2 * maze->width + 1);
+	view->y = follow(ball_y / MAZE_BLOCK - MAZE_VIEW_BLOCKS / 2, ball_y / MAZE_BLOCK, 2 * maze->height + 1);
+	view->ball_x = ball_x;
+	view->ball_y = ball_y;
+
+	view->dirty_from = 0;
+	view->dirty_to = MAZE_VIEW;
+}
+
+/*
+ * Moves the ball (pixels of the maze), leaving a dot in the cell it
+ * left, and the camera after it if it has got too close to the edge.
+ */
+void maze_view_follow(maze_view_t *view, const maze_t *maze, int16_t ball_x, int16_t ball_y) {
+	int16_t bx = view->ball_x / MAZE_BLOCK;
+	int16_t by = view->ball_y / MAZE_BLOCK;
+	int16_t x = follow(view->x, ball_x / MAZE_BLOCK, 2 * maze->width + 1);
+	int16_t y = follow(view->y, ball_y / MAZE_BLOCK, 2 * maze->height + 1);
+	uint16_t cell;
+
+	stats.frames++;
+
+	if (bx & by & 1 && (bx != ball_x / MAZE_BLOCK || by != ball_y / MAZE_BLOCK)) { // Left a cell.
+		cell = by / 2 * maze->width + bx / 2;
+		view->trail[cell >> 3] |= 1 << (cell & 7);
+		dirty(view, by * MAZE_BLOCK, (by + 1) * MAZE_BLOCK);
+	}
+
+	dirty(view, view->ball_y - 1, view->ball_y + 2); // Where the ball was...
+	view->ball_x = ball_x;
+	view->ball_y = ball_y;
+
+	if (x != view->x || y != view->y) {
+		stats.scrolls++;
+		view->x = x;
+		view->y = y;
+		view->dirty_from = 0;
+		view->dirty_to = MAZE_VIEW;
+		return;
+	}
+
+	dirty(view, ball_y - 1, ball_y + 2); // ...and is.
+}
+
+/*
+ * Renders the next rows to blit into the band: up to the end of a block
+ * row, with the ball drawn over the blocks. Returns how many (0 when
+ * all is blitted) and, in y, the first of them on the display.
+ */
+uint8_t maze_view_render(maze_view_t *view, const maze_t *maze, uint8_t *y) {
+	static const int8_t dx[4] = {1, -1, 0, 0}; // The ball: a plus without the middle, like GrCircleDraw with a radius of 1.
+	static const int8_t dy[4] = {0, 0, 1, -1};
+	const uint8_t *patterns[MAZE_VIEW_BLOCKS];
+	uint8_t from = view->dirty_from;
+	uint8_t to = (from / MAZE_BLOCK + 1) * MAZE_BLOCK;
+	uint8_t *pixels;
+	int16_t px, py;
+	uint8_t c, row, i;
+
+	if (from >= view->dirty_to) return 0;
+	if (to > view->dirty_to) to = view->dirty_to;
+
+	for (c = 0; c < MAZE_VIEW_BLOCKS; c++) {
+		patterns[c] = pattern(view, maze, view->x + c, view->y + from / MAZE_BLOCK);
+	}
+	stats.blocks += MAZE_VIEW_BLOCKS;
+
+	for (row = from; row < to; row++) {
+		pixels = &view->band[(row - from) * MAZE_VIEW_STRIDE];
+		for (c = 0; c < MAZE_VIEW_BLOCKS; c++) {
+			pixels[c] = patterns[c][row % MAZE_BLOCK];
+		}
+	}
+
+	for (i = 0; i < 4; i++) {
+		px = view->ball_x - view->x * MAZE_BLOCK + dx[i];
+		py = view->ball_y - view->y * MAZE_BLOCK + dy[i];
+		if (px >= 0 && px < MAZE_VIEW && py >= from && py < to) {
+			view->band[(py - from) * MAZE_VIEW_STRIDE + px / 8] |= 0x80 >> (px % 8);
+		}
+	}
+
+	stats.rows += to - from;
+	*y = from;
+
+	view->dirty_from = to;
+	if (view->dirty_from >= view->dirty_to) view->dirty_from = view->dirty_to = 0;
+
+	return to - from;
+}
+
+void maze_view_get_stats(maze_view_stats_t *out) {
+	*out = stats;
+}
@@ -0,0 +1,40 @@
+/*
+ * Scrolling view of a maze larger than the display.
+ */
+
+#ifndef MAZE_VIEW_H_
+#define MAZE_VIEW_H_
+
+#include <inttypes.h>
+#include "maze.h"
+
+#define MAZE_VIEW 96 // Pixels on a side: the display.
+#define MAZE_VIEW_STRIDE (MAZE_VIEW / 8) // Bytes in a row of pixels...
+#define MAZE_BLOCK 8 // ...and pixels on a side of a block: a block is a byte wide.
+#define MAZE_VIEW_BLOCKS (MAZE_VIEW / MAZE_BLOCK) // Blocks on a side of the view.
+#define MAZE_VIEW_MARGIN 4 // Blocks kept between the ball and the edge of the view, where the maze goes on.
+
+typedef struct {
+	uint8_t band[MAZE_BLOCK * MAZE_VIEW_STRIDE]; // Rows rendered for a blit: 1 bpp, the leftmost pixel in the top bit.
+	uint8_t trail[(MAZE_MAX * MAZE_MAX + 7) / 8]; // A bit per cell the ball has been in.
+	int16_t x; // The block of the maze in the top left corner.
+	int16_t y;
+	int16_t ball_x; // The ball as drawn, in pixels of the view.
+	int16_t ball_y;
+	uint8_t dirty_from; // The rows of pixels changed since the last blit...
+	uint8_t dirty_to; // ...up to this one, not included.
+} maze_view_t;
+
+typedef struct {
+	uint32_t frames; // Views followed the ball.
+	uint32_t scrolls; // ...and had to scroll.
+	uint32_t blocks; // Blocks looked up for rendering, a block row at a time.
+	uint32_t rows; // Rows of pixels rendered and blitted.
+} maze_view_stats_t;
+
+void maze_view_init(maze_view_t *view, const maze_t *maze, int16_t ball_x, int16_t ball_y);
+void maze_view_follow(maze_view_t *view, const maze_t *maze, int16_t ball_x, int16_t ball_y);
+uint8_t maze_view_render(maze_view_t *view, const maze_t *maze, uint8_t *y);
+void maze_view_get_stats(maze_view_stats_t *stats);
+
+#endif
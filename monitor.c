@@ -0,0 +1,141 @@
+/*
+ * Task monitor: how much of the CPU each task takes, how often it is
+ * switched in and how deep its stack has gone.
+ *
+ * monitor_switch is a Task switch hook: the kernel calls it on every
+ * context switch, and it charges the time since the previous switch to
+ * the task that was running. The idle task, and with it the time spent
+ * in standby, goes to the rest (MONITOR_OTHER), as do the Swis and Hwis
+ * that interrupt it; those that interrupt a task are charged to the
+ * task. Register the hook in the application .cfg:
+ *   Task.addHookSet({switchFxn: '&monitor_switch'});
+ *
+ * The stack high-water marks come from Task_stat, which finds the
+ * deepest byte that no longer holds the fill pattern the kernel writes
+ * into a new stack (Task.initStackFlag, on by default). The stacks are
+ * TASKSTACKSIZE each; the marks tell how much of that can go.
+ *
+ * monitor_update closes a window: the loads and switch rates since the
+ * previous call, and a CPU and a STACK record per task to the trace log.
+ * uiTask calls it on every visit to the menu, and every second on the
+ * hidden monitor screen (hold button 0 and press button 1 in the menu).
+ */
+
+#include <xdc/std.h>
+#include <inttypes.h>
+
+// BIOS header files
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Task.h>
+
+#include "monitor.h"
+#include "trace.h"
+
+static Task_Handle handles[MONITOR_OTHER];
+static uint8_t count = 0;
+
+static uint8_t running = MONITOR_OTHER; // Slot of the task on the CPU.
+static uint32_t since = 0; // When it got there.
+
+static uint32_t window = 0; // Start of the current window.
+static uint32_t window_ticks[MONITOR_TASKS]; // cpu_ticks then.
+static uint32_t window_switches[MONITOR_TASKS];
+
+static monitor_stats_t stats = {0, 0, {[MONITOR_OTHER] = {"muu"}}};
+
+static uint8_t slot(Task_Handle task) {
+	uint8_t i;
+
+	for (i = 0; i < count; i++) {
+		if (handles[i] == task) return i;
+	}
+
+	return MONITOR_OTHER;
+}
+
+/*
+ * Watches a task under a name for the screen. Call after Task_create,
+ * before BIOS_start; up to MONITOR_OTHER tasks.
+ */
+void monitor_add(Task_Handle task, const char *name) {
+	if (count >= MONITOR_OTHER) return;
+
+	handles[count] = task;
+	stats.tasks[count].name = name;
+	count++;
+}
+
+/*
+ * The switch hook. Runs in the scheduler, so no task runs meanwhile.
+ */
+Void monitor_switch(Task_Handle prev, Task_Handle next) {
+	uint32_t now = Clock_getTicks();
+
+	stats.tasks[running].cpu_ticks += now - since;
+	since = now;
+
+	running = slot(next);
+	stats.tasks[running].switches++;
+}
+
+/*
+ * Reads the high-water marks of the stacks.
+ */
+static void stacks(monitor_stats_t *out) {
+	Task_Stat stat;
+	uint8_t i;
+
+	for (i = 0; i < count; i++) {
+		Task_stat(handles[i], &stat);
+		out->tasks[i].stack_size = stat.stackSize;
+		out->tasks[i].stack_used = stat.used;
+	}
+}
+
+/*
+ * A copy of the counters, the running task charged up to now.
+ */
+void monitor_get_stats(monitor_stats_t *out) {
+	UInt key = Task_disable();
+
+	*out = stats;
+	out->tasks[running].cpu_ticks += Clock_getTicks() - since;
+
+	Task_restore(key);
+
+	stacks(out);
+}
+
+/*
+ * Closes the window: the loads and the switch rates since the last
+ * call, logged to the trace with the stacks. Runs in uiTask.
+ */
+void monitor_update() {
+	monitor_stats_t now;
+	uint32_t ticks = Clock_getTicks();
+	uint32_t length = ticks - window;
+	uint32_t cpu;
+	uint8_t i;
+
+	monitor_get_stats(&now);
+
+	for (i = 0; i < MONITOR_TASKS; i++) {
+		cpu = now.tasks[i].cpu_ticks - window_ticks[i];
+
+		stats.tasks[i].load = length ? (uint64_t) cpu * 1000 / length : 0;
+		stats.tasks[i].rate = length ? (uint64_t) (now.tasks[i].switches - window_switches[i])
+				* (1000000 / Clock_tickPeriod) / length : 0;
+		stats.tasks[i].stack_size = now.tasks[i].stack_size;
+		stats.tasks[i].stack_used = now.tasks[i].stack_used;
+
+		window_ticks[i] = now.tasks[i].cpu_ticks;
+		window_switches[i] = now.tasks[i].switches;
+
+		trace_log(TRACE_CPU, i, (uint32_t) stats.tasks[i].load << 16 | stats.tasks[i].rate);
+		if (i < count) trace_log(TRACE_STACK, i, stats.tasks[i].stack_used);
+	}
+
+	stats.updates++;
+	stats.window_ms = length / (1000 / Clock_tickPeriod);
+	window = ticks;
+}
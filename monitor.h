@@ -0,0 +1,38 @@
+/*
+ * Per-task CPU load, context switches and stack high-water marks.
+ */
+
+#ifndef MONITOR_H_
+#define MONITOR_H_
+
+#include <xdc/std.h>
+#include <inttypes.h>
+
+// BIOS header files
+#include <ti/sysbios/knl/Task.h>
+
+#define MONITOR_TASKS 4 // uiTask, sensorTask, commTask and the rest.
+#define MONITOR_OTHER (MONITOR_TASKS - 1) // The idle task and anything not added.
+
+typedef struct {
+	const char *name;
+	uint32_t cpu_ticks; // Running, in Clock ticks; wraps after 11 hours.
+	uint32_t switches; // Switched in.
+	uint16_t load; // Share of the CPU in the last window, per mille.
+	uint16_t rate; // Switches in per second in the last window.
+	uint32_t stack_size; // Bytes, 0 for the rest.
+	uint32_t stack_used; // The deepest the stack has been.
+} monitor_task_t;
+
+typedef struct {
+	uint32_t updates; // Windows closed.
+	uint32_t window_ms; // Length of the last one.
+	monitor_task_t tasks[MONITOR_TASKS];
+} monitor_stats_t;
+
+void monitor_add(Task_Handle task, const char *name);
+Void monitor_switch(Task_Handle prev, Task_Handle next);
+void monitor_update();
+void monitor_get_stats(monitor_stats_t *stats);
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ * Music sequencer: plays a song on the buzzer in the background.
+ *
+ * Every step of a song (a tone of the harmony, the melody note or a
+ * break) starts from a timer on the wheel (timer.c), in the Clock Swi,
+ * so a song neither holds a task nor waits for one: uiTask draws the
+ * lyrics or an animation meanwhile and still reacts to the buttons.
+ * The steps are scheduled in absolute time: each one is due a whole
+ * number of wheel ticks after the start of the song, so a step that
+ * starts late (the Swi held up by something) doesn't push back the
+ * rest, and the tempo stays exact. The durations of the songs are in
+ * 10 ms, one wheel tick.
+ *
+ * Every new note, and the end, is posted to uiTask as EV_NOTE, which
+ * wakes the coroutines that follow the music.
+ *
+ * The songs stay in flash as packed notes (music.h), compiled from the
+ * scores in songs/ by Song_compiler.py; nothing of them is copied.
+ *
+ * The buzzer plays one tone at a time, so a song plays its harmony one
+ * of two ways: note by note before the melody note, as the songs were
+ * first written (play_steps), or as a fast arpeggio that the melody
+ * takes turns with every wheel tick, which sounds more like a chord
+ * and keeps the rhythm of the melody (play_arpeggio).
+ */
+
+#include <xdc/std.h>
+#include <inttypes.h>
+
+// BIOS header files
+#include <ti/sysbios/knl/Swi.h>
+
+#include "events.h"
+#include "music.h"
+#include "sfx.h"
+#include "timer.h"
+
+static music_stats_t stats;
+
+/*
+ * Sounds the frequency, or silence for 0.
+ */
+static void tone(music_t *music, uint16_t frequency) {
+	sfx_music(music->buzzerHandle, frequency);
+}
+
+/*
+ * The harmony played first: its notes one by one, MUSIC_CHORD_MS each,
+ * then the melody note. Returns the wheel ticks to the next step.
+ */
+static uint32_t play_steps(music_t *music, uint16_t note) {
+	const uint8_t *chord = music_chords[MUSIC_CHORD(note)];
+	uint8_t notes = chord[1] ? 3 : chord[0] ? 1 : 0; // Assuming we have three notes in the harmony, or one.
+
+	if (music->step < notes) { // The harmony notes one by one...
+		tone(music, music_pitches[chord[music->step]]);
+		music->step++;
+		return MUSIC_CHORD_MS / TIMER_TICK_MS;
+	}
+
+	// ...then the melody note, or a break.
+	tone(music, music_pitches[MUSIC_PITCH(note)]);
+	music->step = 0;
+	music->next++;
+	return music->song->lengths[MUSIC_LENGTH(note)] * 10 / TIMER_TICK_MS;
+}
+
+/*
+ * The harmony cycled with the melody: while a chord is held, every other
+ * tone is the melody note and the ones between go through the chord,
+ * MUSIC_ARPEGGIO_MS each, fast enough to blur into one sound. The chord
+ * holds from the note it comes with until the next one or a break, and
+ * takes no time from the melody. Returns the wheel ticks to the next step.
+ */
+static uint32_t play_arpeggio(music_t *music, uint16_t note) {
+	const uint8_t *chord;
+	uint8_t notes;
+	uint32_t length;
+
+	if (music->left == 0) { // A new note.
+		if (MUSIC_CHORD(note)) music->chord = MUSIC_CHORD(note);
+		if (MUSIC_PITCH(note) == 0) music->chord = 0; // A break silences the harmony too.
+		music->left = music->song->lengths[MUSIC_LENGTH(note)] * 10 / TIMER_TICK_MS;
+		music->voice = 0;
+	}
+
+	chord = music_chords[music->chord];
+	notes = chord[1] ? 3 : chord[0] ? 1 : 0;
+
+	if (notes == 0) { // The melody alone, the whole note at once.
+		tone(music, music_pitches[MUSIC_PITCH(note)]);
+		length = music->left;
+	} else {
+		tone(music, music_pitches[music->voice % 2 ? chord[music->voice / 2 % notes] : MUSIC_PITCH(note)]);
+		music->voice++;
+		length = MUSIC_ARPEGGIO_MS / TIMER_TICK_MS;
+	}
+
+	music->left -= length;
+	music->step = music->left ? 1 : 0; // Within the note until it is over.
+	if (!music->left) music->next++;
+
+	return length;
+}
+
+/*
+ * Starts the next step of the song and the timer for the one after it.
+ */
+static Void music_clkFxn(UArg arg0) {
+	music_t *music = (music_t *) arg0;
+	const song_t *song = music->song;
+	uint32_t late = timer_now() - music->due;
+	uint32_t length;
+
+	if (late) {
+		stats.late++;
+		if (late * TIMER_TICK_MS > stats.late_ms_max) stats.late_ms_max = late * TIMER_TICK_MS;
+	}
+
+	if (music->step == 0) { // A new note.
+		if (music->next >= song->count) { // Over.
+			tone(music, 0);
+			music->playing = 0;
+			event_post(EV_NOTE, music->i, 1, 0);
+			return;
+		}
+
+		music->i = music->next;
+		event_post(EV_NOTE, music->i, 0, 0);
+	}
+
+	if (song->arpeggio) {
+		length = play_arpeggio(music, song->notes[music->i]);
+	} else {
+		length = play_steps(music, song->notes[music->i]);
+	}
+
+	stats.steps++;
+	music->due += length;
+	timer_start_at(&music->timer, (Clock_FuncPtr) music_clkFxn, arg0, music->due);
+}
+
+/*
+ * Starts playing the song on the next wheel tick; music->playing tells
+ * when it is over. Call from a task.
+ */
+void music_start(music_t *music, PIN_Handle buzzerHandle, const song_t *song) {
+	music_stop(music);
+
+	music->buzzerHandle = buzzerHandle;
+	music->song = song;
+	music->i = 0;
+	music->next = 0;
+	music->step = 0;
+	music->chord = 0;
+	music->left = 0;
+	music->playing = 1;
+	music->start = music->due = timer_now() + 1;
+
+	stats.songs++;
+	timer_start_at(&music->timer, (Clock_FuncPtr) music_clkFxn, (UArg) music, music->due);
+}
+
+/*
+ * Stops the song halfway (or does nothing if it is over): silence.
+ */
+void music_stop(music_t *music) {
+	UInt key = Swi_disable();
+
+	timer_stop(&music->timer);
+	if (music->playing) sfx_music(music->buzzerHandle, 0);
+	music->playing = 0;
+
+	Swi_restore(key);
+}
+
+void music_get_stats(music_stats_t *out) {
+	UInt key = Swi_disable();
+	*out = stats;
+	Swi_restore(key);
+}
@@ -0,0 +1,80 @@
+/*
+ * Music sequencer for the buzzer.
+ */
+
+#ifndef MUSIC_H_
+#define MUSIC_H_
+
+#include <inttypes.h>
+#include <ti/drivers/PIN.h>
+#include "timer.h"
+
+#define MUSIC_CHORD_MS 50 // Each note of a harmony played before the melody note.
+#define MUSIC_ARPEGGIO_MS TIMER_TICK_MS // Each tone of a harmony cycled with the melody.
+
+// A packed note: the pitch (music_pitches, 0 for a break), the length
+// (the lengths of the song) and the harmony (music_chords, 0 for none).
+#define MUSIC_NOTE(pitch, length, chord) ((pitch) | (length) << 6 | (chord) << 10)
+#define MUSIC_PITCH(note) ((note) & 0x3F)
+#define MUSIC_LENGTH(note) ((note) >> 6 & 0x0F)
+#define MUSIC_CHORD(note) ((note) >> 10)
+
+// A song (or a part of one), compiled from a score in songs/ into
+// songs.c by Song_compiler.py.
+typedef struct {
+	const uint16_t *notes; // MUSIC_NOTE.
+	const uint8_t *lengths; // In 10 ms.
+	uint8_t count;
+	uint8_t arpeggio; // The harmony: 1 cycled with the melody, 0 played before each note.
+} song_t;
+
+// A row of the lyrics that changes: when (from the start of the part,
+// in 10 ms, as the notes add up) and what it shows, NULL to clear it.
+typedef struct {
+	uint8_t part;
+	uint16_t time;
+	uint8_t row;
+	uint8_t column;
+	const char *text;
+} lyric_t;
+
+// A song of the library (song_library in songs.c): its parts, played
+// one after another, and the lyrics in time order, if any.
+typedef struct {
+	const char *title;
+	const song_t *parts;
+	uint8_t count;
+	const lyric_t *lyrics;
+	uint8_t lyric_count;
+} song_entry_t;
+
+extern const uint16_t music_pitches[]; // Hz, from pitches.h.
+extern const uint8_t music_chords[][3]; // Up to three pitches, 0 for none.
+
+typedef struct {
+	swtimer_t timer;
+	PIN_Handle buzzerHandle;
+	const song_t *song;
+	volatile uint8_t i; // The note playing.
+	volatile uint8_t playing;
+	uint8_t next; // The note after it.
+	uint8_t step; // Within the note: the harmony notes, then the melody.
+	uint8_t chord; // The harmony held under the melody (arpeggio).
+	uint8_t voice; // The tone of the arpeggio next.
+	uint16_t left; // Wheel ticks left of the note (arpeggio).
+	uint32_t start; // Wheel tick the song started at: the lyrics count from it.
+	uint32_t due; // Wheel tick the next step starts at.
+} music_t;
+
+typedef struct {
+	uint32_t songs;
+	uint32_t steps; // Tones and breaks started.
+	uint32_t late; // Steps started a wheel tick or more after their time.
+	uint32_t late_ms_max;
+} music_stats_t;
+
+void music_start(music_t *music, PIN_Handle buzzerHandle, const song_t *song);
+void music_stop(music_t *music);
+void music_get_stats(music_stats_t *stats);
+
+#endif
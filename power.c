@@ -0,0 +1,118 @@
+/*
+ * Power policy.
+ *
+ * The CC2650 drops into standby by itself when the idle loop runs and
+ * the policy is enabled, so sleeping is a matter of letting it idle:
+ * every task blocks on something (an event, a semaphore, a sleep)
+ * instead of waking up on a fixed period, and the clocks run only in
+ * the states that need them. The tasks call power_sleep right before
+ * they block and power_wake right after, which tells when the CPU is
+ * busy; the time in between is charged to the current state as active
+ * or standby time, and every wakeup from standby is counted. The time
+ * is in ms of timer_ms, which keeps counting across the wrap of the
+ * Clock ticks; a stretch shorter than a ms is charged a whole one or
+ * none, by where the ms boundaries fall, so the sums stay right.
+ *
+ * The current is an estimate from the datasheet figures in power.h and
+ * the receiver time of radio.c, not a measurement.
+ */
+
+#include <xdc/std.h>
+#include <inttypes.h>
+#include <string.h>
+
+// BIOS header files
+#include <ti/sysbios/knl/Task.h>
+
+#include <ti/drivers/Power.h>
+
+#include "fsm.h"
+#include "power.h"
+#include "radio.h"
+#include "timer.h"
+
+static uint8_t awake = 0; // Bit per task that is running.
+static uint8_t current = 0; // State the time since last_ms goes to.
+static uint32_t last_ms = 0;
+
+static power_stats_t stats;
+
+/*
+ * Charges the time since the last call to the current state and moves
+ * on to the state uiTask is in now.
+ */
+static void account() {
+	uint32_t now = timer_ms();
+
+	if (awake) {
+		stats.active_ms[current] += now - last_ms;
+	} else {
+		stats.idle_ms[current] += now - last_ms;
+	}
+
+	last_ms = now;
+	current = fsm_state() < POWER_STATES ? fsm_state() : 0;
+}
+
+/*
+ * Call from main before BIOS_start. All tasks start out running.
+ */
+void power_init() {
+	memset(&stats, 0, sizeof(stats));
+
+	awake = (1 << POWER_TASKS) - 1;
+	last_ms = timer_ms();
+
+	Power_enablePolicy(); // Standby whenever nothing is running.
+}
+
+/*
+ * The task is about to block.
+ */
+void power_sleep(uint8_t task) {
+	UInt key = Task_disable();
+
+	account();
+	awake &= ~(1 << task);
+
+	Task_restore(key);
+}
+
+/*
+ * The task is running again. Counts a wakeup if the CPU was idle.
+ */
+void power_wake(uint8_t task) {
+	UInt key = Task_disable();
+
+	account();
+
+	if (!awake) stats.wakeups[current]++;
+	stats.task_wakeups[task]++;
+	awake |= 1 << task;
+
+	Task_restore(key);
+}
+
+void power_get_stats(power_stats_t *out) {
+	radio_stats_t radio;
+	uint32_t total;
+	uint8_t i;
+	UInt key = Task_disable();
+
+	account();
+
+	radio_get_stats(&radio);
+
+	for (i = 0; i < POWER_STATES; i++) {
+		total = stats.active_ms[i] + stats.idle_ms[i];
+
+		// Average over the time in the state: CPU, standby and receiver.
+		stats.current_ua[i] = total ? (uint32_t) (((uint64_t) stats.active_ms[i] * POWER_ACTIVE_UA
+				+ (uint64_t) stats.idle_ms[i] * POWER_STANDBY_UA
+				+ (uint64_t) (i < RADIO_STATES ? radio.rx_on_ms[i] : 0) * POWER_RX_UA) / total) : 0;
+	}
+
+	*out = stats;
+
+	Task_restore(key);
+}
@@ -0,0 +1,36 @@
+/*
+ * Power policy: standby between events, wakeups and current per state.
+ */
+
+#ifndef POWER_H_
+#define POWER_H_
+
+#include <inttypes.h>
+
+#define POWER_STATES 16 // Enough for every value of enum state.
+
+// The tasks that block through power_sleep/power_wake.
+#define POWER_UI 0
+#define POWER_SENSOR 1
+#define POWER_COMM 2
+#define POWER_TASKS 3
+
+// CC2650 datasheet figures for the estimate, in uA.
+#define POWER_ACTIVE_UA 2900 // CPU at 48 MHz.
+#define POWER_STANDBY_UA 1 // Standby, RTC running.
+#define POWER_RX_UA 5900 // Radio receiving.
+
+typedef struct {
+	uint32_t wakeups[POWER_STATES]; // The CPU woke up from idle.
+	uint32_t active_ms[POWER_STATES]; // At least one task running.
+	uint32_t idle_ms[POWER_STATES]; // Every task blocked: standby.
+	uint32_t current_ua[POWER_STATES]; // Estimated average, with the receiver.
+	uint32_t task_wakeups[POWER_TASKS];
+} power_stats_t;
+
+void power_init();
+void power_sleep(uint8_t task);
+void power_wake(uint8_t task);
+void power_get_stats(power_stats_t *stats);
+
+#endif
@@ -0,0 +1,125 @@
+/*
+ * Scheduler for the protothreads of pt.h.
+ *
+ * uiTask calls pt_run on every round of its loop and pends for at most
+ * pt_wait ticks, so a sleeping coroutine resumes on time while events
+ * are still handled in between: the karaoke, the slideshow or the win
+ * animation no longer keep uiTask from reacting to a button, and
+ * several coroutines (the music and the animation) run side by side.
+ *
+ * Everything here runs in uiTask.
+ */
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <inttypes.h>
+
+// BIOS header files
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
+
+#include "pt.h"
+
+static pt_t *threads[PT_MAX];
+
+/*
+ * Lets the coroutine clean up and forgets it.
+ */
+static void stop(uint8_t i) {
+	threads[i]->aborted = 1;
+	threads[i]->fn(threads[i]);
+	threads[i] = NULL;
+}
+
+/*
+ * Starts fn from the beginning with the state in pt. A coroutine that
+ * is already running (the same pt) is aborted and restarted.
+ */
+void pt_spawn(pt_t *pt, pt_fn_t fn) {
+	uint8_t i;
+	uint8_t free = PT_MAX;
+
+	for (i = 0; i < PT_MAX; i++) {
+		if (threads[i] == pt) stop(i);
+		if (threads[i] == NULL && free == PT_MAX) free = i;
+	}
+
+	if (free == PT_MAX) {
+		System_abort("Too many coroutines!");
+	}
+
+	pt->fn = fn;
+	pt->line = 0;
+	pt->sleeping = 0;
+	pt->aborted = 0;
+	threads[free] = pt;
+}
+
+/*
+ * Resumes every coroutine that can go on. Runs the lot again while one
+ * of them moved, so one waiting on another sees its progress at once.
+ */
+void pt_run() {
+	uint8_t i;
+	uint8_t passes;
+	uint8_t moved = 1;
+	uint16_t line;
+
+	for (passes = 0; moved && passes < PT_MAX; passes++) {
+		moved = 0;
+
+		for (i = 0; i < PT_MAX; i++) {
+			if (threads[i] == NULL) continue;
+
+			line = threads[i]->line;
+
+			if (threads[i]->fn(threads[i]) == PT_ENDED) {
+				threads[i] = NULL;
+				moved = 1;
+			} else if (threads[i]->line != line) {
+				moved = 1;
+			}
+		}
+	}
+}
+
+/*
+ * Ticks until the next sleeping coroutine wakes up, BIOS_WAIT_FOREVER
+ * if none sleeps.
+ */
+uint32_t pt_wait() {
+	uint32_t now = Clock_getTicks();
+	uint32_t wait = BIOS_WAIT_FOREVER;
+	uint8_t i;
+
+	for (i = 0; i < PT_MAX; i++) {
+		if (threads[i] == NULL || !threads[i]->sleeping) continue;
+
+		if ((int32_t) (threads[i]->wake - now) <= 0) return 0;
+		if (threads[i]->wake - now < wait) wait = threads[i]->wake - now;
+	}
+
+	return wait;
+}
+
+uint8_t pt_running() {
+	uint8_t i;
+
+	for (i = 0; i < PT_MAX; i++) {
+		if (threads[i]) return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Aborts every coroutine, e.g. when uiTask leaves the state that
+ * started them.
+ */
+void pt_abort_all() {
+	uint8_t i;
+
+	for (i = 0; i < PT_MAX; i++) {
+		if (threads[i]) stop(i);
+	}
+}
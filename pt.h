@@ -0,0 +1,64 @@
+/*
+ * Protothreads: stackless coroutines for the long UI sequences.
+ *
+ * A coroutine is a function that returns PT_WAITING when it waits and
+ * PT_ENDED when it is done; PT_BEGIN jumps back to where it waited the
+ * next time it is called. It has no stack of its own, so whatever must
+ * survive a wait lives in a struct that starts with the pt_t, not in
+ * local variables. At most one wait per source line.
+ *
+ * When a coroutine is aborted it is called once more with pt->aborted
+ * set, before PT_BEGIN, to close what it opened.
+ */
+
+#ifndef PT_H_
+#define PT_H_
+
+#include <inttypes.h>
+#include <ti/sysbios/knl/Clock.h>
+
+#define PT_MAX 6 // Coroutines running at once.
+
+#define PT_WAITING 0
+#define PT_ENDED 1
+
+typedef struct pt pt_t;
+typedef uint8_t (*pt_fn_t)(pt_t *pt);
+
+struct pt {
+	pt_fn_t fn;
+	uint16_t line; // Where to resume: the __LINE__ of the last wait, 0 at the start.
+	uint8_t sleeping; // Waiting in PT_SLEEP until wake.
+	uint8_t aborted;
+	uint32_t wake; // Clock_getTicks() to resume at.
+};
+
+#define PT_BEGIN(pt) switch ((pt)->line) { case 0:
+#define PT_END(pt) } (pt)->line = 0; return PT_ENDED
+
+// Waits until cond is true. It is checked whenever pt_run runs.
+#define PT_WAIT_UNTIL(pt, cond) do { (pt)->line = __LINE__; case __LINE__: if (!(cond)) return PT_WAITING; } while (0)
+
+// Like Task_sleep(ticks), but lets the other coroutines and uiTask run.
+#define PT_SLEEP(pt, ticks) do { \
+		(pt)->wake = Clock_getTicks() + (ticks); \
+		(pt)->sleeping = 1; \
+		PT_WAIT_UNTIL(pt, (int32_t) (Clock_getTicks() - (pt)->wake) >= 0); \
+		(pt)->sleeping = 0; \
+	} while (0)
+
+// Sleeps until Clock_getTicks() reaches tick, or not at all if it has.
+#define PT_SLEEP_UNTIL(pt, tick) do { \
+		(pt)->wake = (tick); \
+		(pt)->sleeping = 1; \
+		PT_WAIT_UNTIL(pt, (int32_t) (Clock_getTicks() - (pt)->wake) >= 0); \
+		(pt)->sleeping = 0; \
+	} while (0)
+
+void pt_spawn(pt_t *pt, pt_fn_t fn);
+void pt_run();
+uint32_t pt_wait();
+uint8_t pt_running();
+void pt_abort_all();
+
+#endif
@@ -0,0 +1,214 @@
+/*
+ * Radio power manager.
+ *
+ * The receiver is the biggest consumer after the display, and outside
+ * the game nothing listens to what it receives. Instead of leaving it on
+ * all the time, the receiver is on only
+ *  - while the caller asks for it (the game states),
+ *  - while the link layer waits for an acknowledgement,
+ *  - for RADIO_TX_WINDOW_MS after every transmission, and
+ *  - for a short RADIO_WINDOW_MS window every RADIO_WINDOW_PERIOD_MS.
+ *
+ * radio_update is called from the tasks whenever the state may have
+ * changed. Between the updates a one-shot timer fires at the next
+ * window edge, so the receiver also goes off while uiTask is busy
+ * with a long sequence. Every update charges the time since the last
+ * one to the state, so the savings can be measured per state.
+ *
+ * commTask can only poll for received frames, so it waits in
+ * radio_wait while the receiver is off instead of polling for nothing.
+ *
+ * The course library can start the receiver but not stop it: only a
+ * wireless/comm_lib.h with StopReceive6LoWPAN (the host shim) defines
+ * COMM_STOP_RX. Without it RADIO_RX_OFF is 0 and the receiver stays on
+ * once started, until a transmission takes it out of RX. So the windows
+ * (rx_on) are kept apart from the receiver itself (receiving): they
+ * still decide when commTask polls, and rx_on_ms counts them either
+ * way.
+ */
+
+#include <xdc/std.h>
+#include <inttypes.h>
+#include <string.h>
+
+// BIOS header files
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/knl/Semaphore.h>
+#include <ti/sysbios/knl/Swi.h>
+
+#include "wireless/comm_lib.h"
+#include "link.h"
+#include "radio.h"
+#include "timer.h"
+
+#ifndef RADIO_RX_OFF
+#ifdef COMM_STOP_RX
+#define RADIO_RX_OFF 1
+#else
+#define RADIO_RX_OFF 0
+#endif
+#endif
+
+static swtimer_t radio_timer;
+static Semaphore_Handle radio_semHandle; // Posted when the receiver goes on.
+
+static uint8_t rx_on = 0; // In a window: commTask polls.
+static uint8_t receiving = 0; // The receiver is in RX.
+static uint8_t listening = 0; // Listen request of the last update.
+static uint8_t current = 0; // State of the last update.
+static uint32_t last_ms = 0; // Time of the last update.
+static uint32_t rx_until = 0; // End of the window after a transmission.
+static uint32_t wake_ms = 0; // When the timer fires next.
+
+static radio_stats_t stats;
+
+/*
+ * Charges the time since the last call to the current state.
+ */
+static void account(uint32_t now) {
+	uint32_t elapsed = now - last_ms;
+
+	stats.state_ms[current] += elapsed;
+	if (rx_on) stats.rx_on_ms[current] += elapsed;
+
+	last_ms = now;
+}
+
+static Void radio_clkFxn(UArg arg0);
+
+static void rx(uint8_t on) {
+	if (on && !receiving) {
+		StartReceive6LoWPAN();
+		stats.rx_starts++;
+		receiving = 1;
+	}
+#if RADIO_RX_OFF
+	if (!on && receiving) {
+		StopReceive6LoWPAN();
+		receiving = 0;
+	}
+#endif
+
+	if (on && !rx_on) Semaphore_post(radio_semHandle);
+	rx_on = on;
+}
+
+/*
+ * Decides whether the receiver should be on now and arms the timer for
+ * the next moment the answer can change. Called with Swis disabled.
+ */
+static void evaluate(uint32_t now) {
+	uint32_t phase = now % RADIO_WINDOW_PERIOD_MS;
+	uint32_t next;
+
+	if (listening || link_pending()) { // The tasks will update us again.
+		rx(1);
+		timer_stop(&radio_timer);
+		return;
+	}
+
+	rx((int32_t) (rx_until - now) > 0 || phase < RADIO_WINDOW_MS);
+
+	// Next window edge...
+	next = phase < RADIO_WINDOW_MS ? RADIO_WINDOW_MS - phase : RADIO_WINDOW_PERIOD_MS - phase;
+
+	// ...or the end of the window after a transmission, if that comes first.
+	if ((int32_t) (rx_until - now) > 0 && rx_until - now < next) next = rx_until - now;
+
+	// The tasks update us far more often than the edges come round.
+	if (!timer_active(&radio_timer) || wake_ms != now + next) {
+		wake_ms = now + next;
+		timer_start(&radio_timer, (Clock_FuncPtr) radio_clkFxn, 0, next, 0);
+	}
+}
+
+static Void radio_clkFxn(UArg arg0) {
+	uint32_t now = timer_ms();
+
+	account(now);
+	evaluate(now);
+}
+
+/*
+ * Call from main before BIOS_start, after timer_init.
+ */
+void radio_init() {
+	Semaphore_Params radio_semParams;
+	Semaphore_Params_init(&radio_semParams);
+	radio_semParams.mode = Semaphore_Mode_BINARY;
+	radio_semHandle = Semaphore_create(0, &radio_semParams, NULL);
+
+	memset(&stats, 0, sizeof(stats));
+	last_ms = timer_ms();
+	rx_until = 0;
+	rx_on = 0; // The first update from the tasks starts receiving.
+	receiving = 0;
+	listening = 0;
+}
+
+/*
+ * Turns the receiver on or off for the given state. listen asks for the
+ * receiver to stay on (the game states).
+ */
+void radio_update(uint8_t state, uint8_t listen) {
+	UInt key = Swi_disable();
+	uint32_t now = timer_ms();
+
+	account(now);
+	current = state < RADIO_STATES ? state : 0;
+	listening = listen;
+	evaluate(now);
+
+	Swi_restore(key);
+}
+
+/*
+ * Re-evaluates with the state and listen request of the last update,
+ * e.g. when the link layer has nothing more to wait for.
+ */
+void radio_refresh() {
+	UInt key = Swi_disable();
+	uint32_t now = timer_ms();
+
+	account(now);
+	evaluate(now);
+
+	Swi_restore(key);
+}
+
+/*
+ * Call after every Send6LoWPAN: transmitting takes the radio out of RX,
+ * so turn the receiver back on and keep it on for the replies.
+ */
+void radio_tx_done() {
+	UInt key = Swi_disable();
+	uint32_t now = timer_ms();
+
+	account(now);
+	stats.tx_frames[current]++;
+
+	receiving = 0; // The transmission ended any reception.
+	rx_until = now + RADIO_TX_WINDOW_MS;
+	evaluate(now);
+
+	Swi_restore(key);
+}
+
+/*
+ * Blocks the calling task (commTask) until a window opens.
+ */
+void radio_wait() {
+	while (!rx_on) {
+		Semaphore_pend(radio_semHandle, BIOS_WAIT_FOREVER);
+	}
+}
+
+void radio_get_stats(radio_stats_t *out) {
+	UInt key = Swi_disable();
+
+	account(timer_ms());
+	*out = stats;
+
+	Swi_restore(key);
+}
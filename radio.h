@@ -0,0 +1,30 @@
+/*
+ * Radio power manager: decides when the 6LoWPAN receiver is on.
+ */
+
+#ifndef RADIO_H_
+#define RADIO_H_
+
+#include <inttypes.h>
+
+#define RADIO_STATES 16 // Enough for every value of enum state.
+
+#define RADIO_TX_WINDOW_MS 500 // Listening after every transmission (ACKs and results).
+#define RADIO_WINDOW_PERIOD_MS 2000 // Outside the game, listen briefly this often...
+#define RADIO_WINDOW_MS 100 // ...for this long.
+
+typedef struct {
+	uint32_t rx_on_ms[RADIO_STATES]; // Time in listen windows per state: the receiver is on at least then.
+	uint32_t state_ms[RADIO_STATES]; // Total time spent per state.
+	uint32_t tx_frames[RADIO_STATES];
+	uint32_t rx_starts;
+} radio_stats_t;
+
+void radio_init();
+void radio_update(uint8_t state, uint8_t listen);
+void radio_refresh();
+void radio_tx_done();
+void radio_wait();
+void radio_get_stats(radio_stats_t *stats);
+
+#endif
@@ -0,0 +1,244 @@
+/*
+ * Records every game session on the device and uploads it in a few
+ * frames once the player is back in the menu, so the backend gets the
+ * whole history without any extra airtime during the game.
+ *
+ * Every move is stored with its direction, the confidence of the
+ * gesture detection (0 for the button) and its time since the start.
+ * For the upload a session is packed into a record:
+ *
+ *   version, outcome, move count, duration (100 ms, 16 bits LE),
+ *   per move: direction | confidence << 3, time since the previous
+ *             move (100 ms, base-128 varint),
+ *   CRC-16/CCITT of everything before it (LE).
+ *
+ * That is two bytes for most moves. The record is cut into
+ * SESSION_FRAGMENT_BYTES pieces, base64 encoded and queued to the link
+ * layer as "sess:<id>,<n>/<count>,<data>", which makes sure each one
+ * arrives once and in order.
+ *
+ * session_move is called from uiTask (send_message), session_end also
+ * from the clock Swis and commTask, so the state is only touched with
+ * the Swis disabled.
+ */
+
+#include <xdc/std.h>
+#include <inttypes.h>
+#include <string.h>
+#include <stdio.h>
+
+// BIOS header files
+#include <ti/sysbios/knl/Swi.h>
+
+#include "link.h"
+#include "session.h"
+#include "timer.h"
+
+enum session_state {IDLE=0, RECORDING, FINISHED};
+
+static enum session_state state = IDLE;
+static uint8_t outcome = 0;
+static uint8_t confidence = 0; // Of the latest detection.
+static uint32_t start_ms = 0;
+static uint32_t end_ms = 0;
+
+static uint8_t move_count = 0;
+static uint8_t moves[SESSION_MAX_MOVES]; // Direction | confidence << 3.
+static uint16_t times[SESSION_MAX_MOVES]; // Since the start, in 100 ms.
+
+// The record being uploaded: the header, a byte per move and up to three
+// of varint time (a uint16_t delta), and the CRC.
+static uint8_t record[5 + 4 * SESSION_MAX_MOVES + 2];
+static uint16_t record_len = 0;
+static uint8_t record_id = 0;
+static uint8_t fragment = 0; // Next fragment to queue.
+static uint8_t fragment_count = 0;
+
+static session_stats_t stats;
+
+static const char base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static uint16_t crc16(const uint8_t *data, uint16_t len) {
+	uint16_t crc = 0xFFFF;
+	uint8_t i;
+
+	while (len--) {
+		crc ^= (uint16_t) *data++ << 8;
+
+		for (i = 0; i < 8; i++) {
+			crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+		}
+	}
+
+	return crc;
+}
+
+/*
+ * Packs the finished session into the upload record and frees the
+ * move buffer for the next one. Call with the Swis disabled.
+ */
+static void encode() {
+	uint16_t n = 0;
+	uint16_t previous = 0;
+	uint16_t delta;
+	uint16_t duration = (end_ms - start_ms) / 100;
+	uint16_t crc;
+	uint8_t i;
+
+	if (fragment < fragment_count) stats.discarded++; // The last upload never finished.
+
+	record[n++] = SESSION_VERSION;
+	record[n++] = outcome;
+	record[n++] = move_count;
+	record[n++] = duration & 0xFF;
+	record[n++] = duration >> 8;
+
+	for (i = 0; i < move_count; i++) {
+		record[n++] = moves[i];
+
+		delta = times[i] - previous;
+		previous = times[i];
+
+		while (delta >= 0x80) { // Seven bits at a time, lowest first.
+			record[n++] = (delta & 0x7F) | 0x80;
+			delta >>= 7;
+		}
+
+		record[n++] = delta;
+	}
+
+	crc = crc16(record, n);
+	record[n++] = crc & 0xFF;
+	record[n++] = crc >> 8;
+
+	record_len = n;
+	record_id++;
+	fragment = 0;
+	fragment_count = (n + SESSION_FRAGMENT_BYTES - 1) / SESSION_FRAGMENT_BYTES;
+
+	stats.moves += move_count;
+	stats.bytes += n;
+
+	state = IDLE;
+}
+
+/*
+ * Base64 of len bytes into out, which must hold 4 * ceil(len / 3) + 1.
+ */
+static void to_base64(const uint8_t *in, uint8_t len, char *out) {
+	uint32_t bits;
+	uint8_t i;
+
+	for (i = 0; i < len; i += 3) {
+		bits = (uint32_t) in[i] << 16;
+		if (i + 1 < len) bits |= (uint32_t) in[i + 1] << 8;
+		if (i + 2 < len) bits |= in[i + 2];
+
+		*out++ = base64[(bits >> 18) & 0x3F];
+		*out++ = base64[(bits >> 12) & 0x3F];
+		*out++ = i + 1 < len ? base64[(bits >> 6) & 0x3F] : '=';
+		*out++ = i + 2 < len ? base64[bits & 0x3F] : '=';
+	}
+
+	*out = 0;
+}
+
+/*
+ * Sets the confidence (0...15) of the move about to be sent: 0 for the
+ * button, 1...15 for a gesture.
+ */
+void session_confidence(uint8_t value) {
+	confidence = value > 15 ? 15 : value;
+}
+
+/*
+ * Records a move (enum direction in game.c), starting a new session
+ * with the first one.
+ */
+void session_move(uint8_t direction) {
+	UInt key = Swi_disable();
+	uint32_t now = timer_ms();
+
+	if (state == FINISHED) encode(); // Still waiting for the menu: pack it now.
+
+	if (state == IDLE) {
+		state = RECORDING;
+		outcome = 0;
+		move_count = 0;
+		start_ms = now;
+	}
+
+	if (move_count < SESSION_MAX_MOVES) {
+		moves[move_count] = (direction & 0x07) | (confidence << 3);
+		times[move_count] = (now - start_ms) / 100;
+		move_count++;
+	} else {
+		outcome = SESSION_TRUNCATED;
+	}
+
+	Swi_restore(key);
+}
+
+/*
+ * Ends the current session, if there is one, with SESSION_WIN,
+ * SESSION_LOST or SESSION_QUIT.
+ */
+void session_end(uint8_t result) {
+	UInt key = Swi_disable();
+
+	if (state == RECORDING) {
+		state = FINISHED;
+		outcome |= result;
+		end_ms = timer_ms();
+		stats.sessions++;
+	}
+
+	Swi_restore(key);
+}
+
+/*
+ * Uploads a finished session while idle (in the menu): queues as many
+ * fragments as the link has room for, leaving one slot for the game.
+ * Call regularly from a task.
+ */
+void session_poll(uint8_t idle) {
+	char frame[LINK_PAYLOAD_SIZE];
+	char data[4 * SESSION_FRAGMENT_BYTES / 3 + 1];
+	uint16_t offset;
+	uint8_t len;
+	UInt key;
+
+	if (!idle) return;
+
+	key = Swi_disable();
+	if (state == FINISHED) encode();
+	Swi_restore(key);
+
+	while (fragment < fragment_count && link_space() > 1) {
+		offset = fragment * SESSION_FRAGMENT_BYTES;
+		len = record_len - offset < SESSION_FRAGMENT_BYTES ? record_len - offset : SESSION_FRAGMENT_BYTES;
+
+		to_base64(&record[offset], len, data);
+		sprintf(frame, "sess:%u,%u/%u,%s", record_id, fragment + 1, fragment_count, data);
+
+		if (!link_send(frame)) break;
+
+		fragment++;
+		stats.fragments++;
+		if (fragment == fragment_count) stats.uploaded++;
+	}
+}
+
+/*
+ * Returns 1 while fragments of the last session wait for room in the
+ * link queue.
+ */
+uint8_t session_pending() {
+	return fragment < fragment_count;
+}
+
+void session_get_stats(session_stats_t *out) {
+	UInt key = Swi_disable();
+	*out = stats;
+	Swi_restore(key);
+}
@@ -0,0 +1,37 @@
+/*
+ * Game session history, uploaded in bulk after the game.
+ */
+
+#ifndef SESSION_H_
+#define SESSION_H_
+
+#include <inttypes.h>
+
+#define SESSION_MAX_MOVES 100 // As many as dir_list holds.
+#define SESSION_FRAGMENT_BYTES 21 // Record bytes per frame: 28 characters in base64.
+#define SESSION_VERSION 1
+
+// Outcome of a session. SESSION_TRUNCATED is or'ed in if there were
+// more moves than SESSION_MAX_MOVES.
+#define SESSION_WIN 1
+#define SESSION_LOST 2
+#define SESSION_QUIT 3
+#define SESSION_TRUNCATED 0x80
+
+typedef struct {
+	uint32_t sessions; // Sessions finished.
+	uint32_t uploaded; // Sessions with every fragment handed to the link.
+	uint32_t discarded; // Sessions replaced before their upload finished.
+	uint32_t moves;
+	uint32_t fragments;
+	uint32_t bytes; // Encoded record bytes, before base64.
+} session_stats_t;
+
+void session_confidence(uint8_t confidence);
+void session_move(uint8_t direction);
+void session_end(uint8_t outcome);
+void session_poll(uint8_t idle);
+uint8_t session_pending();
+void session_get_stats(session_stats_t *stats);
+
+#endif
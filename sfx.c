@@ -0,0 +1,156 @@
+/*
+ * Sound effects: short tone envelopes from a bank in flash, played in
+ * the background from a timer on the wheel (timer.c), like the music.
+ *
+ * The buzzer plays one tone at a time, and everything that sounds goes
+ * through here: the music sets the tone of its voice (sfx_music), and
+ * an effect plays over it. While an effect plays the music ducks: it
+ * keeps its time but is not heard, and the tone it is on comes back as
+ * soon as the effect is over. A new effect cuts short the one playing
+ * unless that one has a higher priority (the sound of a new move cuts
+ * the one of the move before, but not the sound of losing).
+ *
+ * The buzzer stays open from one tone to the next, of an effect or the
+ * music, and is only closed when nothing sounds.
+ */
+
+#include <xdc/std.h>
+#include <inttypes.h>
+
+// BIOS header files
+#include <ti/sysbios/knl/Swi.h>
+
+#include "buzzer.h"
+#include "pitches.h"
+#include "sfx.h"
+#include "timer.h"
+
+// The weird sound of a chosen direction: 500 + 400 sin(2i) Hz for
+// 20 + 20 sin(i) ms, i = 0...9, to the nearest wheel tick but at least
+// one (i = 4 and 5 are shorter than half a tick).
+static const sfx_tone_t arrows[] = {
+	{500, 2}, {864, 4}, {197, 4}, {388, 2}, {896, 1}, {282, 1}, {285, 1}, {896, 3}, {385, 4}, {200, 3},
+};
+
+// Discouraging tones of an illegal move.
+static const sfx_tone_t illegal[] = {
+	{NOTE_B4, 50}, {NOTE_AS4, 50}, {NOTE_A4, 80},
+};
+
+static const sfx_t bank[SFX_COUNT] = {
+	[SFX_ARROWS] = {arrows, sizeof(arrows) / sizeof(arrows[0]), 1},
+	[SFX_ILLEGAL] = {illegal, sizeof(illegal) / sizeof(illegal[0]), 2},
+};
+
+static struct {
+	swtimer_t timer;
+	PIN_Handle buzzerHandle;
+	const sfx_t *effect; // Playing, or NULL.
+	uint8_t tone; // Of the effect.
+	uint32_t due; // Wheel tick the next tone starts at.
+	uint16_t music; // Hz of the music voice, heard when no effect plays.
+	uint8_t open; // The buzzer is open.
+} sfx;
+
+static sfx_stats_t stats;
+
+/*
+ * Sounds the frequency, or closes the buzzer for 0.
+ */
+static void output(uint16_t frequency) {
+	if (frequency == 0) {
+		if (sfx.open) buzzerClose();
+		sfx.open = 0;
+		return;
+	}
+
+	if (!sfx.open) {
+		buzzerOpen(sfx.buzzerHandle);
+		stats.opens++;
+	}
+	sfx.open = 1;
+	buzzerSetFrequency(frequency);
+}
+
+/*
+ * Starts the next tone of the effect, or gives the buzzer back to the
+ * music when it is over.
+ */
+static Void sfx_clkFxn(UArg arg0) {
+	const sfx_tone_t *tone;
+
+	if (sfx.tone >= sfx.effect->count) {
+		sfx.effect = NULL;
+		output(sfx.music);
+		return;
+	}
+
+	tone = &sfx.effect->tones[sfx.tone++];
+	output(tone->frequency);
+	sfx.due += tone->ticks;
+	timer_start_at(&sfx.timer, (Clock_FuncPtr) sfx_clkFxn, 0, sfx.due);
+}
+
+/*
+ * Plays the effect (enum sfx) over the music, cutting short an effect
+ * of the same or a lower priority. Call from a task.
+ */
+void sfx_play(PIN_Handle buzzerHandle, uint8_t effect) {
+	UInt key = Swi_disable();
+
+	if (sfx.effect && sfx.effect->priority > bank[effect].priority) {
+		stats.dropped++;
+		Swi_restore(key);
+		return;
+	}
+
+	if (sfx.effect) stats.preempted++;
+	if (sfx.music) stats.ducked++;
+	stats.played++;
+
+	timer_stop(&sfx.timer);
+	sfx.buzzerHandle = buzzerHandle;
+	sfx.effect = &bank[effect];
+	sfx.tone = 0;
+	sfx.due = timer_now();
+	sfx_clkFxn(0); // The first tone now.
+
+	Swi_restore(key);
+}
+
+/*
+ * Stops the effect playing, if any: the music is heard again.
+ */
+void sfx_stop() {
+	UInt key = Swi_disable();
+
+	timer_stop(&sfx.timer);
+	if (sfx.effect) output(sfx.music);
+	sfx.effect = NULL;
+
+	Swi_restore(key);
+}
+
+uint8_t sfx_playing() {
+	return sfx.effect != NULL;
+}
+
+/*
+ * Sets the tone of the music voice (0 for silence), heard at once
+ * unless an effect is playing. Called by the music sequencer (music.c).
+ */
+void sfx_music(PIN_Handle buzzerHandle, uint16_t frequency) {
+	UInt key = Swi_disable();
+
+	sfx.buzzerHandle = buzzerHandle;
+	sfx.music = frequency;
+	if (!sfx.effect) output(frequency);
+
+	Swi_restore(key);
+}
+
+void sfx_get_stats(sfx_stats_t *out) {
+	UInt key = Swi_disable();
+	*out = stats;
+	Swi_restore(key);
+}
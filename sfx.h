@@ -0,0 +1,39 @@
+/*
+ * Sound effects, and the buzzer shared with the music.
+ */
+
+#ifndef SFX_H_
+#define SFX_H_
+
+#include <inttypes.h>
+#include <ti/drivers/PIN.h>
+
+enum sfx {SFX_ARROWS=0, SFX_ILLEGAL, SFX_COUNT};
+
+// A tone of an effect: Hz (0 for silence) and wheel ticks (TIMER_TICK_MS).
+typedef struct {
+	uint16_t frequency;
+	uint8_t ticks;
+} sfx_tone_t;
+
+typedef struct {
+	const sfx_tone_t *tones;
+	uint8_t count;
+	uint8_t priority; // A playing effect gives way to one of the same priority or higher.
+} sfx_t;
+
+typedef struct {
+	uint32_t played;
+	uint32_t preempted; // Effects cut short by another one.
+	uint32_t dropped; // Effects not played for one of a higher priority.
+	uint32_t ducked; // Effects played over the music.
+	uint32_t opens; // Times the buzzer was opened.
+} sfx_stats_t;
+
+void sfx_play(PIN_Handle buzzerHandle, uint8_t effect);
+void sfx_stop();
+uint8_t sfx_playing();
+void sfx_music(PIN_Handle buzzerHandle, uint16_t frequency);
+void sfx_get_stats(sfx_stats_t *stats);
+
+#endif
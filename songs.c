@@ -0,0 +1,183 @@
+/*
+ * Generated by Song_compiler.py from songs/pelimies.score, songs/sexbomb.score, songs/ukko_nooa.score: do not edit.
+ *
+ * 234 notes in 681 bytes of flash (2170 as plain arrays).
+ */
+
+#include <inttypes.h>
+#include <stddef.h>
+#include "music.h"
+#include "songs.h"
+
+const uint16_t music_pitches[] = {
+	0,
+	139, // 1: CS3
+	185, // 2: FS3
+	220, // 3: A3
+	554, // 4: CS5
+	740, // 5: FS5
+	880, // 6: A5
+	147, // 7: D3
+	294, // 8: D4
+	165, // 9: E3
+	208, // 10: GS3
+	247, // 11: B3
+	330, // 12: E4
+	494, // 13: B4
+	370, // 14: FS4
+	277, // 15: CS4
+	587, // 16: D5
+	440, // 17: A4
+	415, // 18: GS4
+	156, // 19: DS3
+	622, // 20: DS5
+	196, // 21: G3
+	233, // 22: AS3
+	466, // 23: AS4
+	311, // 24: DS4
+	131, // 25: C3
+	523, // 26: C5
+	659, // 27: E5
+	698, // 28: F5
+	784, // 29: G5
+};
+
+const uint8_t music_chords[][3] = {
+	{0, 0, 0},
+	{1, 2, 3}, // 1: CS3+FS3+A3
+	{7, 2, 3}, // 2: D3+FS3+A3
+	{9, 10, 11}, // 3: E3+GS3+B3
+	{15, 0, 0}, // 4: CS4
+	{2, 0, 0}, // 5: FS3
+	{3, 0, 0}, // 6: A3
+	{11, 0, 0}, // 7: B3
+	{1, 0, 0}, // 8: CS3
+	{1, 9, 3}, // 9: CS3+E3+A3
+	{9, 0, 0}, // 10: E3
+	{19, 10, 11}, // 11: DS3+GS3+B3
+	{10, 0, 0}, // 12: GS3
+	{1, 9, 10}, // 13: CS3+E3+GS3
+	{19, 21, 22}, // 14: DS3+G3+AS3
+	{19, 0, 0}, // 15: DS3
+	{25, 9, 21}, // 16: C3+E3+G3
+	{21, 11, 8}, // 17: G3+B3+D4
+};
+
+static const uint8_t pelimies_lengths[] = {15, 150, 50, 30, 20, 5, 25, 100};
+
+static const uint16_t pelimies_0[] = {
+	MUSIC_NOTE(4, 0, 1), MUSIC_NOTE(5, 0, 0), MUSIC_NOTE(6, 1, 0), MUSIC_NOTE(8, 1, 2), MUSIC_NOTE(4, 0, 1), MUSIC_NOTE(5, 0, 0), MUSIC_NOTE(6, 1, 0), MUSIC_NOTE(12, 1, 3),
+	MUSIC_NOTE(4, 0, 0), MUSIC_NOTE(4, 0, 0), MUSIC_NOTE(4, 0, 0), MUSIC_NOTE(13, 2, 1), MUSIC_NOTE(14, 0, 0), MUSIC_NOTE(14, 0, 0), MUSIC_NOTE(14, 3, 4), MUSIC_NOTE(14, 3, 0),
+	MUSIC_NOTE(14, 2, 0), MUSIC_NOTE(4, 0, 5), MUSIC_NOTE(4, 0, 0), MUSIC_NOTE(4, 0, 0), MUSIC_NOTE(16, 2, 2), MUSIC_NOTE(4, 0, 0), MUSIC_NOTE(13, 0, 0), MUSIC_NOTE(17, 3, 6),
+	MUSIC_NOTE(4, 3, 0), MUSIC_NOTE(13, 2, 3), MUSIC_NOTE(4, 0, 0), MUSIC_NOTE(4, 0, 0), MUSIC_NOTE(4, 0, 0), MUSIC_NOTE(13, 2, 1), MUSIC_NOTE(14, 0, 0), MUSIC_NOTE(14, 0, 0),
+	MUSIC_NOTE(14, 3, 4), MUSIC_NOTE(14, 3, 0), MUSIC_NOTE(14, 2, 0), MUSIC_NOTE(4, 0, 0), MUSIC_NOTE(4, 4, 0), MUSIC_NOTE(13, 3, 2), MUSIC_NOTE(17, 0, 0), MUSIC_NOTE(14, 0, 0),
+	MUSIC_NOTE(0, 5, 0), MUSIC_NOTE(4, 0, 0), MUSIC_NOTE(4, 4, 0), MUSIC_NOTE(13, 3, 3), MUSIC_NOTE(17, 0, 0), MUSIC_NOTE(14, 0, 0), MUSIC_NOTE(4, 2, 1), MUSIC_NOTE(14, 4, 5),
+	MUSIC_NOTE(17, 0, 0), MUSIC_NOTE(4, 2, 4), MUSIC_NOTE(14, 6, 5), MUSIC_NOTE(17, 4, 0), MUSIC_NOTE(16, 3, 2), MUSIC_NOTE(4, 3, 0), MUSIC_NOTE(13, 3, 6), MUSIC_NOTE(4, 3, 0),
+	MUSIC_NOTE(13, 3, 3), MUSIC_NOTE(17, 3, 0), MUSIC_NOTE(18, 2, 7), MUSIC_NOTE(4, 2, 1), MUSIC_NOTE(14, 4, 5), MUSIC_NOTE(17, 0, 0), MUSIC_NOTE(4, 2, 5), MUSIC_NOTE(14, 3, 8),
+	MUSIC_NOTE(17, 4, 0), MUSIC_NOTE(18, 2, 2), MUSIC_NOTE(17, 2, 6), MUSIC_NOTE(13, 2, 3), MUSIC_NOTE(4, 2, 7), MUSIC_NOTE(4, 2, 1), MUSIC_NOTE(14, 4, 5), MUSIC_NOTE(17, 0, 0),
+	MUSIC_NOTE(4, 2, 8), MUSIC_NOTE(14, 6, 5), MUSIC_NOTE(17, 0, 0), MUSIC_NOTE(16, 2, 2), MUSIC_NOTE(4, 6, 0), MUSIC_NOTE(13, 4, 6), MUSIC_NOTE(4, 3, 0), MUSIC_NOTE(13, 3, 3),
+	MUSIC_NOTE(17, 3, 0), MUSIC_NOTE(18, 3, 7), MUSIC_NOTE(4, 2, 1), MUSIC_NOTE(14, 4, 5), MUSIC_NOTE(17, 0, 0), MUSIC_NOTE(4, 2, 5), MUSIC_NOTE(14, 6, 8), MUSIC_NOTE(17, 4, 0),
+	MUSIC_NOTE(18, 2, 2), MUSIC_NOTE(17, 2, 6), MUSIC_NOTE(13, 2, 3),
+};
+
+static const uint16_t pelimies_1[] = {
+	MUSIC_NOTE(4, 4, 0), MUSIC_NOTE(4, 4, 0), MUSIC_NOTE(13, 3, 2), MUSIC_NOTE(14, 3, 0), MUSIC_NOTE(14, 7, 6), MUSIC_NOTE(4, 4, 0), MUSIC_NOTE(4, 4, 0), MUSIC_NOTE(13, 3, 9),
+	MUSIC_NOTE(12, 3, 0), MUSIC_NOTE(12, 7, 10), MUSIC_NOTE(4, 4, 0), MUSIC_NOTE(4, 4, 0), MUSIC_NOTE(13, 3, 2), MUSIC_NOTE(14, 3, 0), MUSIC_NOTE(14, 7, 6), MUSIC_NOTE(13, 3, 3),
+	MUSIC_NOTE(4, 4, 10), MUSIC_NOTE(13, 3, 0), MUSIC_NOTE(4, 4, 10), MUSIC_NOTE(13, 3, 0), MUSIC_NOTE(0, 4, 0), MUSIC_NOTE(4, 0, 0), MUSIC_NOTE(4, 0, 0), MUSIC_NOTE(4, 0, 0),
+	MUSIC_NOTE(13, 2, 1), MUSIC_NOTE(14, 0, 0), MUSIC_NOTE(14, 0, 0), MUSIC_NOTE(14, 3, 8), MUSIC_NOTE(14, 3, 0), MUSIC_NOTE(14, 2, 0), MUSIC_NOTE(4, 0, 5), MUSIC_NOTE(4, 4, 0),
+	MUSIC_NOTE(4, 4, 0), MUSIC_NOTE(16, 2, 2), MUSIC_NOTE(4, 0, 0), MUSIC_NOTE(13, 0, 0), MUSIC_NOTE(17, 3, 6), MUSIC_NOTE(4, 3, 0), MUSIC_NOTE(13, 2, 3), MUSIC_NOTE(4, 4, 7),
+	MUSIC_NOTE(4, 4, 0), MUSIC_NOTE(13, 3, 9), MUSIC_NOTE(14, 4, 0), MUSIC_NOTE(14, 4, 0), MUSIC_NOTE(14, 3, 6), MUSIC_NOTE(14, 3, 0), MUSIC_NOTE(14, 2, 0), MUSIC_NOTE(4, 0, 0),
+	MUSIC_NOTE(4, 4, 0), MUSIC_NOTE(13, 3, 2), MUSIC_NOTE(17, 0, 0), MUSIC_NOTE(14, 0, 0), MUSIC_NOTE(0, 5, 0), MUSIC_NOTE(4, 0, 0), MUSIC_NOTE(4, 4, 0), MUSIC_NOTE(13, 3, 3),
+	MUSIC_NOTE(17, 0, 0), MUSIC_NOTE(14, 0, 0),
+};
+
+const song_t pelimies[] = {
+	{pelimies_0, pelimies_lengths, 91, 1},
+	{pelimies_1, pelimies_lengths, 58, 1},
+};
+
+static const lyric_t pelimies_lyrics[] = { // Part, time, row, column, text.
+	{0, 0, 3, 0, "Martti Vainaa &"},
+	{0, 0, 4, 1, "Sallitut aineet"},
+	{0, 0, 6, 3, "Pelimies"},
+	{0, 510, 3, 0, NULL},
+	{0, 510, 4, 0, NULL},
+	{0, 510, 5, 1, "Na-na-na-naa"},
+	{0, 510, 6, 1, "na-na-nan"},
+	{0, 510, 7, 1, "nan-naa"},
+	{0, 1315, 5, 1, "Tana iltana"},
+	{0, 1315, 6, 1, "ei tuu pakkeja!"},
+	{0, 1315, 7, 0, NULL},
+	{0, 1545, 5, 1, "Teen mita vaan"},
+	{0, 1545, 6, 1, "pumppaan rautaa"},
+	{0, 1740, 5, 1, "juosten kierran"},
+	{0, 1740, 6, 1, "maan"},
+	{0, 1970, 5, 1, "jos niin ma"},
+	{0, 1970, 6, 1, "saan sinut"},
+	{0, 1970, 7, 1, "innostumaan"},
+	{0, 2355, 5, 1, "Teen sulle sen"},
+	{0, 2355, 6, 1, "pienen tempun"},
+	{0, 2355, 7, 1, "vanhanaikaisen"},
+	{0, 2685, 5, 1, "Oon pelimies"},
+	{0, 2685, 6, 1, "kovakuntoinen"},
+	{0, 2685, 7, 0, NULL},
+	{1, 0, 5, 2, "Tahdon"},
+	{1, 0, 6, 1, "koskettaa"},
+	{1, 0, 7, 1, "(koskettaa)"},
+	{1, 200, 5, 1, "Voin sen"},
+	{1, 200, 6, 1, "tunnustaa"},
+	{1, 200, 7, 1, "(tunnustaa)"},
+	{1, 400, 5, 1, "Saanko"},
+	{1, 400, 6, 1, "ehdottaa"},
+	{1, 400, 7, 1, "(ehdottaa)"},
+	{1, 600, 5, 1, "iltaa"},
+	{1, 600, 6, 1, "kanssani?"},
+	{1, 600, 7, 0, NULL},
+	{1, 730, 5, 1, "Tule niin"},
+	{1, 730, 6, 1, "vien sinut"},
+	{1, 730, 7, 1, "kahville"},
+	{1, 985, 5, 1, "ja nakki-"},
+	{1, 985, 6, 1, "kioskille"},
+	{1, 985, 7, 1, "jatkoille!"},
+	{1, 1180, 5, 1, "Siita taksiin"},
+	{1, 1180, 6, 1, "ja saatille"},
+	{1, 1180, 7, 0, NULL},
+	{1, 1465, 5, 1, "Tana iltana"},
+	{1, 1465, 6, 1, "ei tuu pakkeja!"},
+};
+
+static const uint8_t sexbomb_lengths[] = {37, 18, 56};
+
+static const uint16_t sexbomb_0[] = {
+	MUSIC_NOTE(13, 0, 0), MUSIC_NOTE(18, 0, 11), MUSIC_NOTE(13, 0, 0), MUSIC_NOTE(18, 0, 12), MUSIC_NOTE(0, 1, 0), MUSIC_NOTE(4, 0, 13), MUSIC_NOTE(13, 1, 0), MUSIC_NOTE(20, 0, 0),
+	MUSIC_NOTE(13, 1, 8), MUSIC_NOTE(4, 0, 0), MUSIC_NOTE(0, 1, 0), MUSIC_NOTE(13, 1, 11), MUSIC_NOTE(18, 1, 0), MUSIC_NOTE(13, 1, 0), MUSIC_NOTE(13, 1, 12), MUSIC_NOTE(13, 1, 0),
+	MUSIC_NOTE(13, 1, 0), MUSIC_NOTE(13, 1, 0), MUSIC_NOTE(13, 1, 0), MUSIC_NOTE(23, 1, 14), MUSIC_NOTE(23, 1, 0), MUSIC_NOTE(23, 1, 0), MUSIC_NOTE(18, 1, 15), MUSIC_NOTE(13, 1, 0),
+	MUSIC_NOTE(18, 1, 0), MUSIC_NOTE(13, 0, 0), MUSIC_NOTE(18, 0, 11), MUSIC_NOTE(13, 0, 0), MUSIC_NOTE(18, 0, 12), MUSIC_NOTE(0, 1, 0), MUSIC_NOTE(4, 0, 13), MUSIC_NOTE(13, 1, 0),
+	MUSIC_NOTE(20, 0, 0), MUSIC_NOTE(13, 1, 8), MUSIC_NOTE(4, 1, 0), MUSIC_NOTE(0, 1, 0), MUSIC_NOTE(12, 1, 0), MUSIC_NOTE(13, 1, 11), MUSIC_NOTE(18, 1, 0), MUSIC_NOTE(13, 1, 0),
+	MUSIC_NOTE(24, 1, 0), MUSIC_NOTE(14, 0, 14), MUSIC_NOTE(14, 1, 0), MUSIC_NOTE(18, 2, 11),
+};
+
+const song_t sexbomb[] = {
+	{sexbomb_0, sexbomb_lengths, 44, 1},
+};
+
+static const uint8_t ukko_nooa_lengths[] = {50, 98, 102, 100};
+
+static const uint16_t ukko_nooa_0[] = {
+	MUSIC_NOTE(26, 0, 16), MUSIC_NOTE(26, 0, 0), MUSIC_NOTE(26, 0, 0), MUSIC_NOTE(27, 0, 0), MUSIC_NOTE(16, 0, 17), MUSIC_NOTE(16, 0, 0), MUSIC_NOTE(16, 0, 0), MUSIC_NOTE(28, 0, 0),
+	MUSIC_NOTE(27, 0, 16), MUSIC_NOTE(27, 0, 0), MUSIC_NOTE(16, 0, 17), MUSIC_NOTE(16, 0, 0), MUSIC_NOTE(26, 1, 16), MUSIC_NOTE(0, 2, 0), MUSIC_NOTE(27, 0, 16), MUSIC_NOTE(27, 0, 0),
+	MUSIC_NOTE(27, 0, 0), MUSIC_NOTE(27, 0, 0), MUSIC_NOTE(29, 3, 17), MUSIC_NOTE(28, 0, 0), MUSIC_NOTE(28, 0, 0), MUSIC_NOTE(16, 0, 0), MUSIC_NOTE(16, 0, 0), MUSIC_NOTE(16, 0, 0),
+	MUSIC_NOTE(16, 0, 0), MUSIC_NOTE(28, 3, 16), MUSIC_NOTE(27, 0, 0), MUSIC_NOTE(27, 0, 0), MUSIC_NOTE(26, 0, 0), MUSIC_NOTE(26, 0, 0), MUSIC_NOTE(26, 0, 0), MUSIC_NOTE(27, 0, 0),
+	MUSIC_NOTE(16, 0, 17), MUSIC_NOTE(16, 0, 0), MUSIC_NOTE(16, 0, 0), MUSIC_NOTE(28, 0, 0), MUSIC_NOTE(27, 0, 16), MUSIC_NOTE(27, 0, 0), MUSIC_NOTE(16, 0, 17), MUSIC_NOTE(16, 0, 0),
+	MUSIC_NOTE(26, 1, 16),
+};
+
+const song_t ukko_nooa[] = {
+	{ukko_nooa_0, ukko_nooa_lengths, 41, 1},
+};
+
+const song_entry_t song_library[] = {
+	{"Pelimies", pelimies, 2, pelimies_lyrics, 47},
+	{"Sexbomb", sexbomb, 1, NULL, 0},
+	{"Ukko Nooa", ukko_nooa, 1, NULL, 0},
+};
@@ -0,0 +1,18 @@
+/*
+ * Generated by Song_compiler.py from songs/pelimies.score, songs/sexbomb.score, songs/ukko_nooa.score: do not edit.
+ */
+
+#ifndef SONGS_H_
+#define SONGS_H_
+
+#include "music.h"
+
+#define SONG_LIBRARY 3 // Songs in song_library.
+
+extern const song_t pelimies[2];
+extern const song_t sexbomb[1];
+extern const song_t ukko_nooa[1];
+
+extern const song_entry_t song_library[SONG_LIBRARY];
+
+#endif
@@ -0,0 +1,341 @@
+/*
+ * Timer wheel: all software timers on one BIOS Clock.
+ *
+ * Instead of a Clock object (and a Swi post) per timer, the timers sit
+ * in a hierarchical wheel of TIMER_LEVELS levels with TIMER_SLOTS
+ * slots each. Level 0 has a slot per TIMER_TICK_MS tick, each level up
+ * a slot per revolution of the one below. A timer goes into the lowest
+ * level whose range reaches its expiry, so starting and stopping are
+ * O(1); when level 0 comes round, the next slot of level 1 is cascaded
+ * down (and of level 2 when level 1 comes round).
+ *
+ * The Clock is one-shot and armed to the next slot with something in
+ * it (or to the next cascade), so with nothing to do there are no
+ * ticks but one every 3 h (see sync) and the device can stay in
+ * standby. All timer functions due at the same time run in one Swi.
+ *
+ * timer_start and timer_stop are callable from tasks, Swis and the
+ * button callbacks (Hwi).
+ */
+
+#include <xdc/std.h>
+#include <inttypes.h>
+#include <string.h>
+
+// BIOS header files
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/hal/Hwi.h>
+
+#include "timer.h"
+
+#define MASK (TIMER_SLOTS - 1)
+#define CLOCK_TICKS (TIMER_TICK_MS * 1000 / Clock_tickPeriod) // Clock ticks per wheel tick.
+#define MS_TICKS (1000 / Clock_tickPeriod) // Clock ticks per ms.
+#define SYNC_TICKS 0x40000000 // Longest the Clock sleeps (3 h), well inside a wrap of the ticks.
+
+static Clock_Handle timer_clkHandle;
+
+static swtimer_t *wheel[TIMER_LEVELS][TIMER_SLOTS];
+static uint16_t count[TIMER_LEVELS]; // Timers per level.
+static uint32_t wheel_tick = 0; // Last tick processed.
+
+static uint32_t synced = 0; // Clock_getTicks at the last sync...
+static uint32_t tick_rest = 0; // ...and the Clock ticks since, not a whole wheel tick...
+static uint32_t ms_rest = 0; // ...or ms yet.
+static uint32_t now_tick = 0;
+static uint32_t ms = 0;
+
+static timer_stats_t stats;
+
+/*
+ * Brings the wheel tick and the ms up to Clock_getTicks, by the ticks
+ * since the last time. Dividing Clock_getTicks would jump back to 0
+ * when the ticks wrap, after 11.9 h; added up, both wrap at 2^32 like
+ * the time anywhere else, so (int32_t) (a - b) compares them across
+ * the wrap. The Clock never sleeps longer than SYNC_TICKS, so no wrap
+ * goes unseen. Call with the Hwis disabled.
+ */
+static void sync() {
+	uint32_t now = Clock_getTicks();
+	uint32_t elapsed = now - synced;
+
+	synced = now;
+
+	tick_rest += elapsed;
+	now_tick += tick_rest / CLOCK_TICKS;
+	tick_rest %= CLOCK_TICKS;
+
+	ms_rest += elapsed;
+	ms += ms_rest / MS_TICKS;
+	ms_rest %= MS_TICKS;
+}
+
+static uint8_t level_of(const swtimer_t *timer) {
+	uint8_t level;
+
+	// The slot index at each level is the expiry shifted; the level is
+	// the lowest one where that index is less than a revolution ahead.
+	for (level = 0; level < TIMER_LEVELS; level++) {
+		if ((timer->expires >> (level * TIMER_SLOT_BITS)) - (wheel_tick >> (level * TIMER_SLOT_BITS)) < TIMER_SLOTS) {
+			return level;
+		}
+	}
+
+	return TIMER_LEVELS; // Further out than the wheel reaches.
+}
+
+static void attach(swtimer_t *timer) {
+	uint8_t level = level_of(timer);
+	uint32_t slot;
+	swtimer_t **head;
+
+	if (level < TIMER_LEVELS) {
+		slot = (timer->expires >> (level * TIMER_SLOT_BITS)) & MASK;
+	} else { // Park it in the last slot of the top level; it is placed again when cascaded.
+		level = TIMER_LEVELS - 1;
+		slot = ((wheel_tick >> (level * TIMER_SLOT_BITS)) + MASK) & MASK;
+	}
+
+	head = &wheel[level][slot];
+	timer->next = *head;
+	if (*head) (*head)->pprev = &timer->next;
+	timer->pprev = head;
+	*head = timer;
+
+	timer->level = level;
+	count[level]++;
+}
+
+static void detach(swtimer_t *timer) {
+	*timer->pprev = timer->next;
+	if (timer->next) timer->next->pprev = timer->pprev;
+	timer->pprev = NULL;
+
+	count[timer->level]--;
+}
+
+/*
+ * Moves the timers of the current slot at the level down.
+ */
+static void cascade(uint8_t level) {
+	swtimer_t **head = &wheel[level][(wheel_tick >> (level * TIMER_SLOT_BITS)) & MASK];
+	swtimer_t *timer;
+
+	while ((timer = *head) != NULL) {
+		detach(timer);
+		attach(timer);
+		stats.cascades++;
+	}
+}
+
+/*
+ * Arms the Clock for the next tick that has something to do: the first
+ * timer on level 0, or the cascade of the first non-empty slot above.
+ */
+static void arm() {
+	uint32_t due = 0;
+	uint32_t at;
+	int32_t timeout;
+	uint8_t level;
+	uint8_t shift;
+	uint8_t k;
+
+	Clock_stop(timer_clkHandle);
+
+	for (level = 0; level < TIMER_LEVELS; level++) {
+		if (!count[level]) continue;
+
+		shift = level * TIMER_SLOT_BITS;
+
+		for (k = 1; k <= TIMER_SLOTS; k++) {
+			if (wheel[level][((wheel_tick >> shift) + k) & MASK]) {
+				at = ((wheel_tick >> shift) + k) << shift;
+				if (due == 0 || (int32_t) (at - due) < 0) due = at;
+				break;
+			}
+		}
+	}
+
+	sync();
+
+	if (due == 0) { // Nothing to wait for but the next sync.
+		timeout = SYNC_TICKS;
+	} else {
+		timeout = (int32_t) (due - now_tick) * CLOCK_TICKS - (int32_t) tick_rest;
+	}
+
+	Clock_setTimeout(timer_clkHandle, timeout > 0 ? timeout : 1);
+	Clock_start(timer_clkHandle);
+}
+
+/*
+ * Moves the wheel up to the current time and runs what expired.
+ */
+static Void timer_clkFxn(UArg arg0) {
+	uint32_t start = Clock_getTicks();
+	uint32_t now;
+	uint32_t elapsed;
+	swtimer_t **head;
+	swtimer_t *timer;
+	UInt key = Hwi_disable();
+
+	sync();
+	now = now_tick;
+	if (!count[0] && !count[1] && !count[2]) wheel_tick = now; // Woken up only to sync.
+
+	while ((int32_t) (now - wheel_tick) > 0) {
+		if (!count[0] && (wheel_tick & MASK) != MASK) { // Nothing on level 0: skip to the cascade.
+			wheel_tick = (int32_t) (now - (wheel_tick | MASK)) < 0 ? now : wheel_tick | MASK;
+			continue;
+		}
+
+		wheel_tick++;
+		stats.ticks++;
+
+		if ((wheel_tick & MASK) == 0) { // Level 0 came round: cascade from above.
+			if (((wheel_tick >> TIMER_SLOT_BITS) & MASK) == 0) cascade(2);
+			cascade(1);
+		}
+
+		head = &wheel[0][wheel_tick & MASK];
+
+		while ((timer = *head) != NULL) {
+			detach(timer);
+
+			if (timer->period) { // Periodic: put it back first, the function may stop it.
+				timer->expires += timer->period;
+				attach(timer);
+			}
+
+			stats.expired++;
+
+			Hwi_restore(key);
+			timer->fxn(timer->arg);
+			key = Hwi_disable();
+		}
+	}
+
+	arm();
+
+	elapsed = (Clock_getTicks() - start) * Clock_tickPeriod;
+	stats.swi_runs++;
+	stats.swi_us_sum += elapsed;
+	if (elapsed > stats.swi_us_max) stats.swi_us_max = elapsed;
+
+	Hwi_restore(key);
+}
+
+/*
+ * Call from main before BIOS_start.
+ */
+void timer_init() {
+	Clock_Params timer_clkParams;
+	Clock_Params_init(&timer_clkParams);
+	timer_clkParams.period = 0; // One-shot: arm() sets the timeout.
+	timer_clkParams.startFlag = FALSE;
+	timer_clkHandle = Clock_create((Clock_FuncPtr) timer_clkFxn, CLOCK_TICKS, &timer_clkParams, NULL);
+
+	memset(wheel, 0, sizeof(wheel));
+	memset(count, 0, sizeof(count));
+	memset(&stats, 0, sizeof(stats));
+	sync();
+	wheel_tick = now_tick;
+	arm(); // For the syncs.
+}
+
+/*
+ * Puts the timer on the wheel to expire at the wheel tick expires.
+ */
+static void start(swtimer_t *timer, Clock_FuncPtr fxn, UArg arg, uint32_t expires, uint32_t period) {
+	UInt key = Hwi_disable();
+
+	if (timer->pprev) detach(timer);
+
+	// An empty wheel is not ticked: catch up without walking the slots.
+	if (!count[0] && !count[1] && !count[2]) {
+		sync();
+		wheel_tick = now_tick;
+	}
+
+	timer->fxn = fxn;
+	timer->arg = arg;
+	timer->expires = expires;
+	timer->period = period;
+
+	// The wheel may lag behind the time until the Clock fires next.
+	if ((int32_t) (timer->expires - wheel_tick) < 1) timer->expires = wheel_tick + 1;
+
+	attach(timer);
+	stats.started++;
+	arm();
+
+	Hwi_restore(key);
+}
+
+/*
+ * (Re)starts the timer: fxn(arg) runs after delay_ms and then every
+ * period_ms, or once if period_ms is 0. Both are rounded up to whole
+ * ticks.
+ */
+void timer_start(swtimer_t *timer, Clock_FuncPtr fxn, UArg arg, uint32_t delay_ms, uint32_t period_ms) {
+	start(timer, fxn, arg, timer_now() + (delay_ms + TIMER_TICK_MS - 1) / TIMER_TICK_MS,
+			(period_ms + TIMER_TICK_MS - 1) / TIMER_TICK_MS);
+}
+
+/*
+ * (Re)starts the timer to run fxn(arg) once at the wheel tick, or on
+ * the next tick if that has passed. For schedules in absolute time:
+ * adding up the ticks keeps late runs from drifting the later ones.
+ */
+void timer_start_at(swtimer_t *timer, Clock_FuncPtr fxn, UArg arg, uint32_t tick) {
+	start(timer, fxn, arg, tick, 0);
+}
+
+/*
+ * The current wheel tick (TIMER_TICK_MS each).
+ */
+uint32_t timer_now() {
+	UInt key = Hwi_disable();
+	uint32_t now;
+
+	sync();
+	now = now_tick;
+
+	Hwi_restore(key);
+	return now;
+}
+
+/*
+ * Milliseconds since boot, wrapping at 2^32 (see sync).
+ */
+uint32_t timer_ms() {
+	UInt key = Hwi_disable();
+	uint32_t now;
+
+	sync();
+	now = ms;
+
+	Hwi_restore(key);
+	return now;
+}
+
+void timer_stop(swtimer_t *timer) {
+	UInt key = Hwi_disable();
+
+	if (timer->pprev) {
+		detach(timer);
+		arm();
+	}
+
+	Hwi_restore(key);
+}
+
+uint8_t timer_active(const swtimer_t *timer) {
+	return timer->pprev != NULL;
+}
+
+void timer_get_stats(timer_stats_t *out) {
+	UInt key = Hwi_disable();
+	*out = stats;
+	Hwi_restore(key);
+}
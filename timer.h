@@ -0,0 +1,47 @@
+/*
+ * Software timers on one BIOS Clock.
+ */
+
+#ifndef TIMER_H_
+#define TIMER_H_
+
+#include <inttypes.h>
+#include <ti/sysbios/knl/Clock.h>
+
+#define TIMER_TICK_MS 10 // Resolution of the wheel.
+#define TIMER_SLOT_BITS 5
+#define TIMER_SLOTS (1 << TIMER_SLOT_BITS) // Per level: 320 ms, 10.24 s and 327 s.
+#define TIMER_LEVELS 3
+
+typedef struct swtimer swtimer_t;
+
+struct swtimer {
+	swtimer_t *next;
+	swtimer_t **pprev; // NULL while not running.
+	Clock_FuncPtr fxn; // Runs in the Clock Swi, like a clock function.
+	UArg arg;
+	uint32_t expires; // Wheel tick.
+	uint32_t period; // Wheel ticks, 0 for one-shot.
+	uint8_t level; // Of the wheel it is on.
+};
+
+typedef struct {
+	uint32_t started;
+	uint32_t expired; // Timer functions run.
+	uint32_t swi_runs; // Clock Swi posts for the whole wheel.
+	uint32_t ticks; // Wheel ticks advanced.
+	uint32_t cascades; // Timers moved down a level.
+	uint32_t swi_us_sum; // Time in the Clock Swi, timer functions included.
+	uint32_t swi_us_max;
+} timer_stats_t;
+
+void timer_init();
+void timer_start(swtimer_t *timer, Clock_FuncPtr fxn, UArg arg, uint32_t delay_ms, uint32_t period_ms);
+void timer_start_at(swtimer_t *timer, Clock_FuncPtr fxn, UArg arg, uint32_t tick);
+void timer_stop(swtimer_t *timer);
+uint8_t timer_active(const swtimer_t *timer);
+uint32_t timer_now();
+uint32_t timer_ms();
+void timer_get_stats(timer_stats_t *stats);
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * Binary trace log.
+ *
+ * System_printf and System_flush format and write out on the spot,
+ * which is slow and, from a Swi or a callback, holds up everything
+ * else. trace_log only stamps a fixed-size record into a ring: the slot
+ * is taken with interrupts off for a few instructions, the record is
+ * filled in with them on, and its id is written last to mark it done.
+ * It can be called from the pin callbacks, the Swis and the tasks alike
+ * and never blocks; if the ring is full, the record is dropped (and
+ * counted).
+ *
+ * The idle task drains the ring: trace_drain writes the finished
+ * records out byte by byte with System_putch, so the dump ends up where
+ * the System output goes (the SysMin buffer, or the console). Register
+ * it in the application .cfg:
+ *   Idle.addFunc('&trace_drain');
+ * host/Trace_decoder.py turns a dump into a readable timeline.
+ */
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <inttypes.h>
+
+// BIOS header files
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/hal/Hwi.h>
+
+#include "trace.h"
+
+#define MASK (TRACE_SIZE - 1)
+
+static volatile trace_record_t ring[TRACE_SIZE];
+static volatile uint16_t head = 0; // Next slot to take.
+static volatile uint16_t tail = 0; // Next slot to drain.
+
+static trace_stats_t stats;
+
+void trace_log(uint16_t id, uint16_t a, uint32_t b) {
+	volatile trace_record_t *r;
+	uint16_t used;
+	UInt key = Hwi_disable();
+
+	used = head - tail;
+
+	if (used >= TRACE_SIZE) {
+		stats.dropped++;
+		Hwi_restore(key);
+		return;
+	}
+
+	r = &ring[head & MASK];
+	head++;
+	r->ticks = Clock_getTicks(); // In slot order.
+
+	stats.logged++;
+	if (used + 1 > stats.max_used) stats.max_used = used + 1;
+
+	Hwi_restore(key);
+
+	r->a = a;
+	r->b = b;
+	r->id = id; // Last: the record is complete.
+}
+
+static void put(uint32_t value, uint8_t bytes) {
+	while (bytes--) {
+		System_putch((Char) (value & 0xFF));
+		value >>= 8;
+	}
+}
+
+/*
+ * Writes out the finished records. Runs in the idle task.
+ */
+void trace_drain() {
+	volatile trace_record_t *r;
+	trace_record_t copy;
+
+	while (tail != head) {
+		r = &ring[tail & MASK];
+		if (r->id == 0) break; // Interrupted while being written: next time.
+
+		copy.ticks = r->ticks;
+		copy.id = r->id;
+		copy.a = r->a;
+		copy.b = r->b;
+		r->id = 0;
+		tail++; // Only written here: the slot is free now.
+
+		put(copy.ticks, 4);
+		put(copy.id, 2);
+		put(copy.a, 2);
+		put(copy.b, 4);
+
+		stats.drained++;
+	}
+}
+
+void trace_get_stats(trace_stats_t *out) {
+	UInt key = Hwi_disable();
+	*out = stats;
+	Hwi_restore(key);
+}
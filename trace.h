@@ -0,0 +1,48 @@
+/*
+ * Binary trace log for the hot paths.
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <inttypes.h>
+
+#define TRACE_SIZE 128 // Records in the ring, a power of two.
+
+/*
+ * The record types and their arguments (a, b). host/Trace_decoder.py
+ * reads the names from here.
+ *   STATE: uiTask moved from state a to state b.
+ *   EVENT: uiTask received an event of type a, b is its arg.
+ *   DROP: an event of type a didn't fit into the queue.
+ *   EDGE: an interrupt on button a.
+ *   PRESS: button a settled down (b 1) or up (b 0).
+ *   RX: a frame from address a; b holds its first four characters.
+ *   TX: the link sent frame a (sequence number), b is the try.
+ *   CPU: task a (monitor.c) ran b >> 16 per mille of the last window and
+ *        was switched in b & 0xFFFF times per second.
+ *   STACK: the stack of task a has been b bytes deep.
+ */
+enum trace_id {TRACE_STATE=1, TRACE_EVENT, TRACE_DROP, TRACE_EDGE, TRACE_PRESS, TRACE_RX, TRACE_TX,
+	TRACE_CPU, TRACE_STACK, TRACE_COUNT};
+
+// 12 bytes, little-endian in the dump in this order.
+typedef struct {
+	uint32_t ticks; // Clock_getTicks().
+	uint16_t id; // enum trace_id, 0 while being written.
+	uint16_t a;
+	uint32_t b;
+} trace_record_t;
+
+typedef struct {
+	uint32_t logged;
+	uint32_t dropped; // The ring was full.
+	uint32_t drained;
+	uint32_t max_used; // Most records waiting at once.
+} trace_stats_t;
+
+void trace_log(uint16_t id, uint16_t a, uint32_t b);
+void trace_drain();
+void trace_get_stats(trace_stats_t *stats);
+
+#endif
@@ -20,6 +20,9 @@
 #include <math.h>
 #include <stdio.h>
 #include "game.h"
+#include "monitor.h"
+#include "pt.h"
+#include "songs.h"
 
 // Define the menu items and the index.
 char menu[][10] = {"Pelaa", "Sokkelo", "Karaoke", "Kello", "Diaesitys", "Sammuta"};
@@ -298,67 +301,41 @@ void draw_menu(Display_Handle displayHandle) {
 	GrFlush(pContext);
 }
 
+static const tImage *slides[] = {
+	&slide1Image, &slide2Image, &slide3Image, &slide4Image, &slide5Image, &slide6Image,
+	&slide7Image, &slide8Image, &slide9Image, &slide10Image, &slide11Image
+};
+
+static struct {
+	pt_t pt;
+	Display_Handle displayHandle;
+	uint8_t i; // The slide on the display.
+} show;
+
+static uint8_t slideshow_thread(pt_t *pt) {
+	tContext *pContext = DisplayExt_getGrlibContext(show.displayHandle);
+
+	if (pt->aborted) return PT_ENDED;
+
+	PT_BEGIN(pt);
+
+	for (show.i = 0; show.i < sizeof(slides) / sizeof(slides[0]); show.i++) {
+		Display_clear(show.displayHandle); // Clear the display.
+		GrImageDraw(pContext, slides[show.i], 0, 0); // Draw the full screen.
+		GrFlush(pContext); // ...and flush.
+		PT_SLEEP(pt, 2000000 / Clock_tickPeriod); // Wait before advancing to the next picture.
+	}
+
+	PT_END(pt);
+}
+
 /*
  * Displays the slideshow: draws all the pictures and
- * sleeps in between.
+ * sleeps in between, in a coroutine that goes on after this returns.
  */
 void slideshow(Display_Handle displayHandle) {
-	tContext *pContext = DisplayExt_getGrlibContext(displayHandle);
-
-	Display_clear(displayHandle); // Clear the display.
-	GrImageDraw(pContext, &slide1Image, 0, 0); // Draw the full screen.
-	GrFlush(pContext); // ...and flush.
-	Task_sleep(2000000 / Clock_tickPeriod); // Wait before advancing to the next picture.
-
-	Display_clear(displayHandle);
-	GrImageDraw(pContext, &slide2Image, 0, 0);
-	GrFlush(pContext);
-	Task_sleep(2000000 / Clock_tickPeriod);
-
-    Display_clear(displayHandle);
-    GrImageDraw(pContext, &slide3Image, 0, 0);
-    GrFlush(pContext);
-    Task_sleep(2000000 / Clock_tickPeriod);
-
-    Display_clear(displayHandle);
-    GrImageDraw(pContext, &slide4Image, 0, 0);
-    GrFlush(pContext);
-    Task_sleep(2000000 / Clock_tickPeriod);
-
-    Display_clear(displayHandle);
-    GrImageDraw(pContext, &slide5Image, 0, 0);
-    GrFlush(pContext);
-    Task_sleep(2000000 / Clock_tickPeriod);
-
-    Display_clear(displayHandle);
-    GrImageDraw(pContext, &slide6Image, 0, 0);
-    GrFlush(pContext);
-    Task_sleep(2000000 / Clock_tickPeriod);
-
-    Display_clear(displayHandle);
-    GrImageDraw(pContext, &slide7Image, 0, 0);
-    GrFlush(pContext);
-    Task_sleep(2000000 / Clock_tickPeriod);
-
-    Display_clear(displayHandle);
-    GrImageDraw(pContext, &slide8Image, 0, 0);
-    GrFlush(pContext);
-    Task_sleep(2000000 / Clock_tickPeriod);
-
-    Display_clear(displayHandle);
-    GrImageDraw(pContext, &slide9Image, 0, 0);
-    GrFlush(pContext);
-    Task_sleep(2000000 / Clock_tickPeriod);
-
-    Display_clear(displayHandle);
-    GrImageDraw(pContext, &slide10Image, 0, 0);
-    GrFlush(pContext);
-    Task_sleep(2000000 / Clock_tickPeriod);
-
-    Display_clear(displayHandle);
-    GrImageDraw(pContext, &slide11Image, 0, 0);
-    GrFlush(pContext);
-    Task_sleep(2000000 / Clock_tickPeriod);
+	show.displayHandle = displayHandle;
+	pt_spawn(&show.pt, slideshow_thread);
 }
 
 /*
@@ -374,6 +351,52 @@ void draw_calibrate(Display_Handle displayHandle) {
 	Display_print0(displayHandle, 2, 1, "Kalibroidaan...");
 }
 
+/*
+ * Draws the hidden task monitor: the CPU load and switches per second
+ * of each task over the last window, and how deep its stack has been.
+ */
+void draw_monitor(Display_Handle displayHandle) {
+	monitor_stats_t stats;
+	char line[20];
+	uint8_t i;
+
+	monitor_get_stats(&stats);
+	Display_clear(displayHandle);
+	Display_print0(displayHandle, 0, 0, "teht   CPU   /s");
+
+	for (i = 0; i < MONITOR_TASKS; i++) {
+		if (stats.tasks[i].name == NULL) continue; // Not added.
+
+		sprintf(line, "%-4s%3u.%u%% %4u", stats.tasks[i].name, stats.tasks[i].load / 10,
+				stats.tasks[i].load % 10, stats.tasks[i].rate);
+		Display_print0(displayHandle, 2 + 2 * i, 0, line);
+
+		if (stats.tasks[i].stack_size) { // Used of the whole stack, in bytes.
+			sprintf(line, " pino %u/%u", (unsigned int) stats.tasks[i].stack_used,
+					(unsigned int) stats.tasks[i].stack_size);
+			Display_print0(displayHandle, 3 + 2 * i, 0, line);
+		}
+	}
+}
+
+/*
+ * Draws the songs of the library for the karaoke, and "Takaisin" (back)
+ * after them, with the selected one marked. Five fit on the display at
+ * once; the list scrolls to keep the selected one on it.
+ */
+void draw_songs(Display_Handle displayHandle, uint8_t selected) {
+	uint8_t first = selected < 5 ? 0 : selected - 4;
+	uint8_t i;
+
+	Display_clear(displayHandle);
+	Display_print0(displayHandle, 0, 4, "Karaoke");
+
+	for (i = first; i <= SONG_LIBRARY && i < first + 5; i++) {
+		Display_print0(displayHandle, 2 + 2 * (i - first), 2, i < SONG_LIBRARY ? song_library[i].title : "Takaisin");
+		if (i == selected) Display_print0(displayHandle, 2 + 2 * (i - first), 0, ">");
+	}
+}
+
 /*
  * Draws the clock face and the clock hand.
  */
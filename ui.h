@@ -12,6 +12,8 @@ void draw_menu(Display_Handle displayHandle);
 void draw_clock(Display_Handle displayHandle, int seconds, char temp_str[]);
 void draw_game(Display_Handle displayHandle, PIN_Handle buzzerHandle, int moves);
 void draw_calibrate(Display_Handle displayHandle);
+void draw_monitor(Display_Handle displayHandle);
+void draw_songs(Display_Handle displayHandle, uint8_t selected);
 void slideshow(Display_Handle displayHandle);
 void menu_increment();
 void set_index(int set);